@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <string>
+
+using namespace xdb;
+
+namespace {
+  constexpr int n_threads = 4;
+  constexpr int n_rounds = 10;
+
+  // how long it takes to have every worker of a fleet stopped, attaching to
+  // them one at a time or all at once, and detaching again afterwards
+  void snapshot(int n_workers) {
+    setenv("XDB_BENCH_THREADS", std::to_string(n_threads).c_str(), 1);
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    std::vector<std::unique_ptr<process>> workers;
+    std::vector<pid_t> pids;
+    for (int i = 0; i < n_workers; ++i) {
+      workers.push_back(process::launch("targets/fleet_worker", false, channel.get_write_fd()));
+      pids.push_back(workers.back()->pid());
+    }
+    channel.close_write();
+    for (std::size_t ready = 0; ready < pids.size();) {
+      ready += channel.read().size();
+    }
+
+    std::chrono::duration<double> one_by_one{}, all_at_once{}, detach{};
+    for (int round = 0; round < n_rounds; ++round) {
+      auto start = std::chrono::steady_clock::now();
+      {
+        std::vector<std::unique_ptr<process>> procs;
+        for (auto pid : pids) procs.push_back(process::attach(pid));
+        one_by_one += std::chrono::steady_clock::now() - start;
+      }
+
+      start = std::chrono::steady_clock::now();
+      auto procs = process::attach(pids);
+      auto stopped = std::chrono::steady_clock::now();
+      all_at_once += stopped - start;
+      procs.clear();
+      detach += std::chrono::steady_clock::now() - stopped;
+    }
+    fmt::print("{:>3} workers x {} threads {:>10.1f} us one by one {:>10.1f} us all at once {:>10.1f} us to detach\n",
+               n_workers, n_threads, one_by_one.count() / n_rounds * 1e6,
+               all_at_once.count() / n_rounds * 1e6, detach.count() / n_rounds * 1e6);
+  }
+}
+
+int main() {
+  fmt::print("time until the whole fleet is stopped:\n");
+  for (int n : { 1, 16, 64 }) snapshot(n);
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+SCRIPT_DIR=$(dirname "$0")
+cd ${SCRIPT_DIR}/../build/bench
+
+# Run the given benchmark, or all of them
+if [ -n "$1" ]; then
+  ./bench_$1
+else
+  for bench in ./bench_*; do
+    ${bench}
+  done
+fi
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <libxdb/process.hpp>
+#include <sstream>
+#include <sys/ptrace.h>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // the largest executable mapping of the inferior (libc, for these targets)
+  std::pair<std::uint64_t, std::uint64_t> largest_text_mapping(pid_t pid) {
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::pair<std::uint64_t, std::uint64_t> best{};
+    std::string line;
+    while (std::getline(maps, line)) {
+      std::istringstream fields(line);
+      std::string range, perms;
+      fields >> range >> perms;
+      if (perms.size() < 3 || perms[2] != 'x') continue;
+      auto dash = range.find('-');
+      auto low = std::stoull(range.substr(0, dash), nullptr, 16);
+      auto high = std::stoull(range.substr(dash + 1), nullptr, 16);
+      if (high - low > best.second - best.first) best = { low, high };
+    }
+    return best;
+  }
+
+  // what a naive debugger does per site: PEEKDATA the word, POKEDATA it back patched
+  void peek_poke_enable(pid_t pid, const std::vector<breakpoint_site*>& sites, std::vector<std::uint64_t>& saved) {
+    saved.clear();
+    for (auto site : sites) {
+      auto addr = site->address().addr();
+      auto word = ptrace(PTRACE_PEEKDATA, pid, addr, nullptr);
+      saved.push_back(word);
+      ptrace(PTRACE_POKEDATA, pid, addr, (word & ~0xffL) | 0xcc);
+    }
+  }
+
+  void peek_poke_disable(pid_t pid, const std::vector<breakpoint_site*>& sites, const std::vector<std::uint64_t>& saved) {
+    for (std::size_t i = sites.size(); i-- > 0;) {
+      ptrace(PTRACE_POKEDATA, pid, sites[i]->address().addr(), saved[i]);
+    }
+  }
+}
+
+int main() {
+  auto proc = process::launch("targets/trap_loop");
+  proc->resume();
+  proc->wait_on_signal();
+
+  // a site every 32 bytes, about as dense as function entries get
+  auto [low, high] = largest_text_mapping(proc->pid());
+  std::vector<breakpoint_site*> sites;
+  for (auto addr = low; addr < high; addr += 32) {
+    sites.push_back(&proc->create_breakpoint_site(virt_addr{ addr }));
+  }
+  fmt::print("breakpoints: {} sites over {} KiB of text\n", sites.size(), (high - low) >> 10);
+  auto report = [&](std::string_view name, double secs) {
+    fmt::print("{:<28} {:>8.1f} ms {:>8.0f} ns/site\n", name, secs * 1e3, secs / sites.size() * 1e9);
+  };
+
+  report("enable, one at a time", seconds([&] { for (auto site : sites) site->enable(); }));
+  report("disable, one at a time", seconds([&] { for (auto site : sites) site->disable(); }));
+  report("enable, page-batched", seconds([&] { proc->enable_breakpoint_sites(sites); }));
+  report("disable, page-batched", seconds([&] { proc->disable_breakpoint_sites(sites); }));
+
+  std::vector<std::uint64_t> saved;
+  report("enable, PEEK/POKEDATA", seconds([&] { peek_poke_enable(proc->pid(), sites, saved); }));
+  report("disable, PEEK/POKEDATA", seconds([&] { peek_poke_disable(proc->pid(), sites, saved); }));
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+
+using namespace xdb;
+
+namespace {
+  // hot(i) is called with i = 0..999999, so this condition is false on every
+  // hit but the last
+  constexpr std::string_view condition = "edi == 999999";
+
+  std::unique_ptr<process> launch(breakpoint_site*& site) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/hot_breakpoint", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+    auto hot = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    site = &proc->create_breakpoint_site(hot);
+    site->enable();
+    return proc;
+  }
+
+  void report(std::string_view name, std::chrono::steady_clock::duration elapsed, std::size_t n_hits) {
+    std::chrono::duration<double> seconds = elapsed;
+    fmt::print("{:<28} {:>9.0f} ns/false hit ({} hits)\n", name, seconds.count() / n_hits * 1e9, n_hits);
+  }
+
+  // what the REPL did before: every hit comes back to the caller, which looks
+  // the register up by name, checks it and resumes
+  void caller_side() {
+    breakpoint_site* site;
+    auto proc = launch(site);
+    std::size_t n_hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    proc->resume();
+    while (proc->wait_on_signal().reason == process_state::stopped) {
+      ++n_hits;
+      auto value = proc->get_registers().read(register_info_by_name("edi"));
+      if (std::get<std::uint32_t>(value) == 999999) break;
+      proc->resume();
+    }
+    report("checked by the caller", std::chrono::steady_clock::now() - start, n_hits);
+  }
+
+  // the compiled condition runs inside wait_on_signal
+  void in_wait_loop() {
+    breakpoint_site* site;
+    auto proc = launch(site);
+    site->set_condition(stop_condition::compile(condition));
+    auto start = std::chrono::steady_clock::now();
+    proc->resume();
+    proc->wait_on_signal();
+    report("compiled condition", std::chrono::steady_clock::now() - start, 1000000);
+  }
+
+  // the interpreter alone, with the registers already fetched
+  void evaluate_only() {
+    breakpoint_site* site;
+    auto proc = launch(site);
+    proc->resume();
+    proc->wait_on_signal();
+    auto compiled = stop_condition::compile(condition);
+    constexpr std::size_t n = 10000000;
+    std::size_t n_true = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+      n_true += compiled.evaluate(*proc);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:<28} {:>9.1f} ns/evaluation ({} true)\n", "evaluate() alone", elapsed.count() / n * 1e9, n_true);
+  }
+}
+
+int main() {
+  fmt::print("conditional breakpoints:\n");
+  caller_side();
+  in_wait_loop();
+  evaluate_only();
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <libxdb/dwarf.hpp>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // resident set size, in bytes
+  std::size_t resident() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size, pages;
+    statm >> size >> pages;
+    return pages * sysconf(_SC_PAGESIZE);
+  }
+
+  // What setting a first breakpoint needs: the function and line at main,
+  // then every address of that line
+  std::size_t first_breakpoint(const dwarf& info, virt_addr main) {
+    auto function = info.function_containing_address(main);
+    auto entry = info.line_entry_at_address(main);
+    if (!function || !entry) return 0;
+    return info.addresses_for_line(entry->file.filename().string(), entry->line).size();
+  }
+
+  void bench_file(const std::string& path) {
+    elf file(path);
+    auto main_symbol = file.symbol_by_name("main");
+    if (!main_symbol || !file.get_section(".debug_info")) {
+      fmt::print("{}: no main or no debugging information\n", path);
+      return;
+    }
+    auto main = virt_addr{ main_symbol->st_value };
+    fmt::print("{} ({:.1f} MB of .debug_info):\n", path, file.section_contents(".debug_info").size() / 1e6);
+
+    for (bool use_aranges : { true, false }) {
+      auto before = resident();
+      std::unique_ptr<dwarf> info;
+      std::size_t found = 0;
+      auto open_time = seconds([&] { info = std::make_unique<dwarf>(file, use_aranges); });
+      auto lookup_time = seconds([&] { found = first_breakpoint(*info, main); });
+      std::size_t parsed = 0;
+      for (auto& unit : info->compile_units()) parsed += unit->dies_parsed();
+      fmt::print("  {:<30} {:>9.3f} ms index, {:>9.3f} ms to first breakpoint ({} found), {}/{} units decoded, "
+                 "{:.1f} MB arena, {:.1f} MB resident\n",
+                 use_aranges ? "lazy, .debug_aranges" : "lazy, unit ranges", open_time * 1e3, lookup_time * 1e3, found,
+                 parsed, info->compile_units().size(), info->arena_bytes() / 1e6, (resident() - before) / 1e6);
+    }
+
+    // what a reader that decodes everything up front costs
+    auto before = resident();
+    std::unique_ptr<dwarf> info;
+    std::size_t found = 0;
+    auto eager_time = seconds([&] {
+      info = std::make_unique<dwarf>(file);
+      info->parse_all();
+    });
+    auto lookup_time = seconds([&] { found = first_breakpoint(*info, main); });
+    fmt::print("  {:<30} {:>9.3f} ms parse, {:>9.3f} ms to first breakpoint ({} found), {:.1f} MB arena, "
+               "{:.1f} MB resident\n",
+               "eager", eager_time * 1e3, lookup_time * 1e3, found, info->arena_bytes() / 1e6,
+               (resident() - before) / 1e6);
+  }
+}
+
+// the files to look at are the arguments; by default this program
+int main(int argc, char** argv) {
+  std::vector<std::string> paths(argv + 1, argv + argc);
+  if (paths.empty()) paths.push_back("/proc/self/exe");
+  for (auto& path : paths) bench_file(path);
+}
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <libxdb/elf.hpp>
+#include <random>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // resident set size, in bytes
+  std::size_t resident() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size, pages;
+    statm >> size >> pages;
+    return pages * sysconf(_SC_PAGESIZE);
+  }
+
+  constexpr std::size_t n_lookups = 1000000;
+
+  void bench_file(const std::string& path) {
+    auto before = resident();
+    std::unique_ptr<elf> file;
+    auto open_time = seconds([&] { file = std::make_unique<elf>(path); });
+    fmt::print("{} ({:.1f} MB, {} symbols):\n", path, file->data().size() / 1e6, file->symbols().size());
+    fmt::print("  {:<34} {:>9.3f} ms, {:.1f} MB resident\n", "open and index", open_time * 1e3,
+               (resident() - before) / 1e6);
+
+    std::vector<const Elf64_Sym*> functions;
+    for (auto& symbol : file->symbols()) {
+      if (ELF64_ST_TYPE(symbol.st_info) == STT_FUNC && symbol.st_value != 0 && symbol.st_size != 0) {
+        functions.push_back(&symbol);
+      }
+    }
+    if (functions.empty()) return;
+    std::mt19937_64 random(42);
+    std::vector<virt_addr> addresses;
+    std::vector<std::string_view> names;
+    for (std::size_t i = 0; i < 4096; ++i) {
+      auto symbol = functions[random() % functions.size()];
+      addresses.push_back(virt_addr{ symbol->st_value + random() % symbol->st_size });
+      names.push_back(file->symbol_name(*symbol));
+    }
+
+    std::size_t found = 0;
+    auto by_address = seconds([&] {
+      for (std::size_t i = 0; i < n_lookups; ++i) found += file->symbol_containing_address(addresses[i % 4096]) != nullptr;
+    });
+    fmt::print("  {:<34} {:>9.1f} ns ({} found)\n", "address, binary search", by_address / n_lookups * 1e9, found);
+    // what a lookup costs without an index
+    found = 0;
+    auto symbols = file->symbols();
+    auto scan = seconds([&] {
+      for (std::size_t i = 0; i < 1000; ++i) {
+        auto address = addresses[i % 4096].addr();
+        for (auto& symbol : symbols) {
+          if (address >= symbol.st_value && address < symbol.st_value + symbol.st_size) {
+            ++found;
+            break;
+          }
+        }
+      }
+    });
+    fmt::print("  {:<34} {:>9.1f} ns ({} found)\n", "address, linear scan", scan / 1000 * 1e9, found);
+
+    // the first miss in .gnu.hash builds the name index
+    auto index_time = seconds([&] { file->symbol_by_name("no such symbol"); });
+    found = 0;
+    auto by_name = seconds([&] {
+      for (std::size_t i = 0; i < n_lookups; ++i) found += file->symbol_by_name(names[i % 4096]) != nullptr;
+    });
+    fmt::print("  {:<34} {:>9.3f} ms\n", "name index build", index_time * 1e3);
+    fmt::print("  {:<34} {:>9.1f} ns ({} found)\n", "name", by_name / n_lookups * 1e9, found);
+
+    if (file->get_section(".gnu.hash")) {
+      std::vector<std::string_view> exported;
+      for (auto& symbol : file->dynamic_symbols()) {
+        if (symbol.st_shndx != SHN_UNDEF && ELF64_ST_BIND(symbol.st_info) != STB_LOCAL) {
+          exported.push_back(file->symbol_name(symbol));
+        }
+      }
+      found = 0;
+      auto hashed = seconds([&] {
+        for (std::size_t i = 0; i < n_lookups; ++i) found += file->symbol_by_name(exported[i % exported.size()]) != nullptr;
+      });
+      fmt::print("  {:<34} {:>9.1f} ns ({} found)\n", "exported name, .gnu.hash", hashed / n_lookups * 1e9, found);
+    }
+  }
+}
+
+// the files to look at are the arguments; by default this program and libc
+int main(int argc, char** argv) {
+  std::vector<std::string> paths(argv + 1, argv + argc);
+  if (paths.empty()) {
+    paths.push_back("/proc/self/exe");
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+      if (auto name = line.find('/'); name != std::string::npos && line.find("/libc.so") != std::string::npos) {
+        paths.push_back(line.substr(name));
+        break;
+      }
+    }
+  }
+  for (auto& path : paths) bench_file(path);
+}
@@ -0,0 +1,66 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/event_loop.hpp>
+#include <libxdb/process.hpp>
+#include <sys/resource.h>
+
+using namespace xdb;
+
+namespace {
+  constexpr int n_processes = 48;
+
+  double cpu_seconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+  }
+
+  // runs the loop for a second and returns the CPU time we used
+  double run_for_a_second(event_loop& loop) {
+    auto cpu_start = cpu_seconds();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < deadline) {
+      loop.run_once(std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()));
+    }
+    return cpu_seconds() - cpu_start;
+  }
+
+  // inferiors that never stop should cost nothing to watch
+  void idle() {
+    event_loop loop;
+    std::vector<std::unique_ptr<process>> procs;
+    for (int i = 0; i < n_processes; ++i) {
+      procs.push_back(process::launch("targets/idle"));
+      loop.add_process(*procs.back(), [](auto&, auto&) {});
+      procs.back()->resume();
+    }
+    auto cpu = run_for_a_second(loop);
+    fmt::print("{:>3} idle inferiors      {:>8.2f} ms of debugger CPU per second\n", n_processes, cpu * 1e3);
+  }
+
+  // every inferior stops with SIGTRAP over and over, and each stop is
+  // resumed from its callback
+  void busy(int n) {
+    event_loop loop;
+    std::vector<std::unique_ptr<process>> procs;
+    std::size_t n_stops = 0;
+    for (int i = 0; i < n; ++i) {
+      procs.push_back(process::launch("targets/trap_loop"));
+      loop.add_process(*procs.back(), [&](process& proc, auto&) {
+        ++n_stops;
+        proc.resume();
+      });
+      procs.back()->resume();
+    }
+    auto cpu = run_for_a_second(loop);
+    fmt::print("{:>3} trapping inferiors  {:>8.0f} stops/s ({:.0f}% debugger CPU)\n", n, n_stops / 1.0,
+               cpu * 100);
+  }
+}
+
+int main() {
+  fmt::print("event loop:\n");
+  idle();
+  busy(1);
+  busy(n_processes);
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <libxdb/process.hpp>
+#include <libxdb/session.hpp>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  constexpr const char* target = "targets/fork_storm";
+
+  double untraced() {
+    auto start = std::chrono::steady_clock::now();
+    auto pid = fork();
+    if (pid == 0) {
+      execl(target, target, nullptr);
+      _exit(1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // every child joins the session and is reported when it exits
+  double followed(int n_children) {
+    auto start = std::chrono::steady_clock::now();
+    session inferiors;
+    auto& parent = inferiors.add(process::launch(target));
+    auto parent_pid = parent.pid();
+    parent.resume();
+    int n_exits = 0;
+    for (;;) {
+      auto [proc, reason] = inferiors.wait_on_signal();
+      if (reason.reason != process_state::stopped) {
+        if (proc.pid() == parent_pid) break;
+        ++n_exits;
+        inferiors.remove(proc);
+      } else {
+        proc.resume();
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (n_exits != n_children) fmt::print("missed {} children\n", n_children - n_exits);
+    return elapsed.count();
+  }
+}
+
+int main() {
+  fmt::print("a process forking short-lived children:\n");
+  for (int n : { 100, 500 }) {
+    setenv("XDB_BENCH_CHILDREN", std::to_string(n).c_str(), 1);
+    untraced();
+    auto base = untraced();
+    auto traced = followed(n);
+    fmt::print("{:>4} children  untraced {:>7.1f} ms  followed {:>7.1f} ms ({:.0f} us/child)\n", n, base * 1e3,
+               traced * 1e3, (traced - base) / n * 1e6);
+  }
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <sys/ptrace.h>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  void report(std::string_view name, std::size_t bytes, double secs) {
+    fmt::print("{:<28} {:>10.1f} MB/s\n", name, bytes / secs / 1e6);
+  }
+
+  // 64-byte reads spread over a handful of pages, like a backtrace walking a stack
+  void small_reads(process& proc, virt_addr buffer, bool cache_enabled) {
+    constexpr std::size_t n_reads = 100000;
+    auto& cache = proc.get_memory_cache();
+    cache.set_enabled(cache_enabled);
+    cache.reset_stats();
+    auto secs = seconds([&] {
+      for (std::size_t i = 0; i < n_reads; ++i) {
+        proc.read_memory(buffer + (i * 1096) % (16 * page_size), 64);
+      }
+    });
+    fmt::print("{:<28} {:>10.1f} ns/read (hits {}, misses {})\n",
+               cache_enabled ? "64-byte reads, cache on" : "64-byte reads, cache off",
+               secs / n_reads * 1e9, cache.hits(), cache.misses());
+  }
+
+  std::vector<std::byte> peek_loop(pid_t pid, virt_addr address, std::size_t amount) {
+    std::vector<std::byte> ret(amount);
+    for (std::size_t i = 0; i < amount; i += 8) {
+      auto word = ptrace(PTRACE_PEEKDATA, pid, address.addr() + i, nullptr);
+      std::memcpy(ret.data() + i, &word, 8);
+    }
+    return ret;
+  }
+
+  void poke_loop(pid_t pid, virt_addr address, const std::vector<std::byte>& data) {
+    for (std::size_t i = 0; i < data.size(); i += 8) {
+      ptrace(PTRACE_POKEDATA, pid, address.addr() + i, from_bytes<std::uint64_t>(data.data() + i));
+    }
+  }
+}
+
+int main() {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/memory_buffer", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto output = channel.read();
+  auto buffer = virt_addr{ from_bytes<std::uint64_t>(output.data()) };
+  auto size = from_bytes<std::size_t>(output.data() + 8);
+  // the word-at-a-time loops are far slower, so give them less to do
+  auto small = size / 16;
+
+  fmt::print("memory: {} MiB buffer\n", size >> 20);
+  small_reads(*proc, buffer, false);
+  small_reads(*proc, buffer, true);
+  proc->get_memory_cache().set_enabled(false);
+  report("read_memory", size, seconds([&] { proc->read_memory(buffer, size); }));
+  report("PTRACE_PEEKDATA loop", small, seconds([&] { peek_loop(proc->pid(), buffer, small); }));
+
+  std::vector<std::byte> data(size, std::byte{0x24});
+  report("write_memory", size, seconds([&] { proc->write_memory(buffer, data); }));
+  data.resize(small);
+  report("PTRACE_POKEDATA loop", small, seconds([&] { poke_loop(proc->pid(), buffer, data); }));
+}
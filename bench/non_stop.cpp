@@ -0,0 +1,50 @@
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+
+using namespace xdb;
+
+namespace {
+  enum class mode { no_breakpoint, all_stop, non_stop };
+
+  // runs the service for its second with a breakpoint on tick() that is
+  // resumed straight away, and returns the work it got done
+  std::uint64_t run(mode m, std::string_view name, std::uint64_t baseline) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/service_threads", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+    auto tick = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+    if (m != mode::no_breakpoint) proc->create_breakpoint_site(tick).enable();
+    proc->set_non_stop(m == mode::non_stop);
+
+    std::size_t n_hits = 0;
+    proc->resume();
+    while (proc->wait_on_signal().reason == process_state::stopped) {
+      ++n_hits;
+      m == mode::non_stop ? proc->resume(proc->current_thread()) : proc->resume();
+    }
+
+    auto work = from_bytes<std::uint64_t>(channel.read().data());
+    fmt::print("{:<16} {:>8.1f} M units/s", name, work / 1e6);
+    if (baseline && n_hits) {
+      // the ticker gets further in non-stop mode, so compare per hit too
+      auto lost = static_cast<double>(baseline) - static_cast<double>(work);
+      fmt::print(" ({:5.1f}% of undisturbed, {} hits, {:.0f} units lost/hit)", 100.0 * work / baseline, n_hits,
+                 lost / n_hits);
+    }
+    fmt::print("\n");
+    return work;
+  }
+}
+
+int main() {
+  fmt::print("service throughput with a breakpoint hit every millisecond:\n");
+  auto baseline = run(mode::no_breakpoint, "no breakpoint", 0);
+  run(mode::all_stop, "all-stop", baseline);
+  run(mode::non_stop, "non-stop", baseline);
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/object_map.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+  double ms_since(clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+  }
+
+  // Attach-to-prompt: attaching, then reading the maps, which is all the
+  // prompt waits for; then the first lookup in the last object mapped, and
+  // every object loaded
+  void attach_to_prompt(pid_t pid, virt_addr in_last, std::size_t n_workers,
+                        std::optional<std::filesystem::path> cache, const char* label) {
+    auto start = clock::now();
+    auto proc = process::attach(pid);
+    object_map objects(pid, n_workers, cache);
+    auto prompt = ms_since(start);
+    bool found = objects.symbol_containing_address(in_last).has_value();
+    auto first_lookup = ms_since(start);
+    objects.wait_all();
+    auto all = ms_since(start);
+    std::size_t symbols = 0;
+    for (auto& object : objects.objects()) {
+      try {
+        symbols += object->get_elf().symbols().size();
+      } catch (const error&) {
+      }
+    }
+    fmt::print("  {:<22} {:>9.1f} ms to prompt {:>9.1f} ms to a lookup in the last object{} {:>9.1f} ms to load "
+               "{} objects, {} symbols\n",
+               label, prompt, first_lookup, found ? "" : " (no symbol)", all, objects.objects().size(), symbols);
+  }
+}
+
+int main() {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto target = process::launch("targets/many_objects", false, channel.get_write_fd());
+  channel.close_write();
+  auto loaded = from_bytes<int>(channel.read().data());
+  fmt::print("{} libraries loaded by the target, {} CPUs here:\n", loaded, std::thread::hardware_concurrency());
+
+  // a function of the object mapped highest, which is queued last
+  virt_addr in_last;
+  {
+    object_map objects(target->pid(), 1, std::nullopt);
+    auto& last = *objects.objects().back();
+    for (auto& symbol : last.get_elf().symbols()) {
+      if (ELF64_ST_TYPE(symbol.st_info) == STT_FUNC && symbol.st_value != 0 && symbol.st_size != 0) {
+        in_last = virt_addr{ symbol.st_value + last.get_elf().load_bias() };
+        break;
+      }
+    }
+  }
+
+  for (std::size_t n : { 1, 4, 16 }) {
+    attach_to_prompt(target->pid(), in_last, n, std::nullopt, fmt::format("{} workers, no cache", n).c_str());
+  }
+  auto cache = std::filesystem::temp_directory_path() / ("xdb-bench-cache-" + std::to_string(getpid()));
+  std::filesystem::remove_all(cache);
+  attach_to_prompt(target->pid(), in_last, 16, cache, "16 workers, cold cache");
+  for (std::size_t n : { 1, 4, 16 }) {
+    attach_to_prompt(target->pid(), in_last, n, cache, fmt::format("{} workers, warm cache", n).c_str());
+  }
+  std::filesystem::remove_all(cache);
+  kill(target->pid(), SIGKILL);
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  void time(std::string_view name, process& proc, F f) {
+    auto epoch = proc.stop_epoch();
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:<28} {:>10.3f} ms {:>8} stops\n", name, elapsed.count() * 1e3, proc.stop_epoch() - epoch);
+  }
+}
+
+int main() {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/long_call", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto work = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  // each command gets its own call of work(), all from one call site
+  proc->run_until(work);
+  auto return_address = virt_addr{ proc->read_memory_as<std::uint64_t>(
+      virt_addr{ proc->get_registers().read<register_id::rsp>() }) };
+  auto call_site = return_address - 5;
+
+  fmt::print("finish:\n");
+  time("single steps", *proc, [&] {
+    proc->step_instructions(UINT64_MAX, [&] { return proc->get_pc() == return_address; });
+  });
+  proc->run_until(call_site);
+  fmt::print("next over the call:\n");
+  // the call leaves the range at once, so stepping has to go on to its end
+  time("single steps", *proc, [&] {
+    proc->step_instructions(UINT64_MAX, [&] { return proc->get_pc() == return_address; });
+  });
+  proc->run_until(call_site);
+  time("hidden breakpoint", *proc, [&] { proc->step_over_instruction(); });
+  proc->run_until(work);
+  fmt::print("finish:\n");
+  time("hidden breakpoint", *proc, [&] { proc->step_out(); });
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/process.hpp>
+
+using namespace xdb;
+
+namespace {
+  constexpr int n_stops = 20000;
+  constexpr int n_lookups = 10000000;
+
+  template <class T>
+  void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  template <class F>
+  void lookups(std::string_view name, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_lookups; ++i) {
+      do_not_optimize(f());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:<28} {:>8.2f} ns/op\n", name, elapsed.count() / n_lookups * 1e9);
+  }
+
+  // the lookup every by_* function used to do
+  const register_info& linear_by_name(std::string_view name) {
+    return register_info_by([name](auto& i) { return i.name == name; });
+  }
+
+  // resume/stop n_stops times, touching registers through inspect on every stop
+  template <class F>
+  void stops(std::string_view name, F inspect) {
+    auto proc = process::launch("targets/trap_loop");
+    auto& regs = proc->get_registers();
+    auto syscalls_before = regs.syscall_count();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n_stops; ++i) {
+      proc->resume();
+      proc->wait_on_signal();
+      inspect(*proc);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    fmt::print("{:<28} {:>8.2f} us/stop {:>6.1f} register syscalls/stop\n", name,
+               elapsed.count() / n_stops * 1e6,
+               static_cast<double>(regs.syscall_count() - syscalls_before) / n_stops);
+  }
+}
+
+int main() {
+  fmt::print("registers: {} stops\n", n_stops);
+  stops("no register access", [](process&) {});
+  stops("get_pc", [](process& proc) { proc.get_pc(); });
+  // what every stop used to cost: GETREGS + GETFPREGS + 8 PEEKUSER
+  stops("all register classes", [](process& proc) {
+    auto& regs = proc.get_registers();
+    regs.read_by_id<std::uint64_t>(register_id::rip);
+    regs.read_by_id<std::uint16_t>(register_id::fcw);
+    for (int i = 0; i < 8; ++i) {
+      regs.read_by_id<std::uint64_t>(static_cast<register_id>(static_cast<int>(register_id::dr0) + i));
+    }
+  });
+  // argument set-up before a call: six writes, flushed with a single SETREGS
+  stops("write 6 argument registers", [](process& proc) {
+    auto& regs = proc.get_registers();
+    for (auto id : { register_id::rdi, register_id::rsi, register_id::rdx,
+                     register_id::rcx, register_id::r8, register_id::r9 }) {
+      regs.write_by_id(id, regs.read_by_id<std::uint64_t>(id));
+    }
+  });
+
+  fmt::print("registers: {} lookups\n", n_lookups);
+  auto proc = process::launch("targets/trap_loop");
+  proc->resume();
+  proc->wait_on_signal();
+  auto& regs = proc->get_registers();
+  // names the optimizer can't see through
+  volatile const char* rip_name = "rip";
+  volatile const char* xmm15_name = "xmm15";
+
+  lookups("linear by name (rip)", [&] { return &linear_by_name(const_cast<const char*>(rip_name)); });
+  lookups("linear by name (xmm15)", [&] { return &linear_by_name(const_cast<const char*>(xmm15_name)); });
+  lookups("hashed by name (xmm15)", [&] { return &register_info_by_name(const_cast<const char*>(xmm15_name)); });
+  lookups("by dwarf (xmm15)", [&] { return &register_info_by_dwarf(32); });
+  lookups("read_by_id<uint64_t>(rip)", [&] { return regs.read_by_id<std::uint64_t>(register_id::rip); });
+  lookups("read<register_id::rip>()", [&] { return regs.read<register_id::rip>(); });
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/object_map.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <poll.h>
+#include <signal.h>
+
+using namespace xdb;
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+  double ms_since(clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+  }
+
+  struct run_result {
+    double ms;
+    int loaded;
+    std::size_t followed;
+    std::size_t mapped;
+  };
+
+  // Launch to the end of the target's dlopens, with the dynamic linker
+  // followed from the exec stop on or not at all; the stops at its
+  // rendezvous are taken inside wait_on_signal
+  run_result run_to_loaded(bool follow) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto start = clock::now();
+    auto proc = process::launch("targets/many_objects", true, channel.get_write_fd());
+    channel.close_write();
+    if (follow) proc->get_objects();
+    proc->resume();
+    for (;;) {
+      pollfd output{ channel.get_read_fd(), POLLIN, 0 };
+      if (poll(&output, 1, 0) > 0) break;
+      proc->wait_on_signal(std::chrono::milliseconds(1));
+    }
+    auto ms = ms_since(start);
+    auto loaded = from_bytes<int>(channel.read().data());
+    proc->interrupt();
+    auto followed = follow ? proc->get_objects().objects().size() : 0;
+    auto mapped = object_map(proc->pid(), 1, std::nullopt).objects().size();
+    return { ms, loaded, followed, mapped };
+  }
+}
+
+int main() {
+  auto plain = run_to_loaded(false);
+  auto followed = run_to_loaded(true);
+  fmt::print("{} libraries dlopened by the target:\n", plain.loaded);
+  fmt::print("  {:<34} {:>9.1f} ms\n", "objects not followed", plain.ms);
+  fmt::print("  {:<34} {:>9.1f} ms, {:.3f} ms more per dlopen, {} objects ({} in the maps)\n",
+             "following r_debug from the exec", followed.ms, (followed.ms - plain.ms) / followed.loaded,
+             followed.followed, followed.mapped);
+
+  // what reading the maps again at each of those stops would cost instead
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto target = process::launch("targets/many_objects", false, channel.get_write_fd());
+  channel.close_write();
+  channel.read();
+  constexpr int rescans = 20;
+  // destroyed after the clock stops, as each waits for its worker's load
+  std::vector<std::unique_ptr<object_map>> maps;
+  auto start = clock::now();
+  for (int i = 0; i < rescans; ++i) maps.push_back(std::make_unique<object_map>(target->pid(), 1, std::nullopt));
+  auto per_rescan = ms_since(start) / rescans;
+  maps.clear();
+  fmt::print("  {:<34} {:>9.3f} ms each, {:.1f} ms for two stops per dlopen at that size\n",
+             "rescanning the maps at the end", per_rescan, per_rescan * 2 * plain.loaded);
+  kill(target->pid(), SIGKILL);
+}
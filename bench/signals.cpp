@@ -0,0 +1,58 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/process.hpp>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  constexpr const char* target = "targets/signal_storm";
+
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void untraced() {
+    auto pid = fork();
+    if (pid == 0) {
+      execl(target, target, nullptr);
+      _exit(1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+  }
+
+  // a signal that stops comes back out of wait_on_signal, and the REPL reads
+  // the pc to print the stop before it is resumed; returns the stops seen
+  std::uint64_t traced(signal_policy policy) {
+    auto proc = process::launch(target);
+    proc->set_signal_policy(SIGUSR1, policy);
+    std::uint64_t stops = 0;
+    proc->resume();
+    while (proc->wait_on_signal().reason == process_state::stopped) {
+      ++stops;
+      proc->get_pc();
+      proc->resume();
+    }
+    return stops;
+  }
+}
+
+int main() {
+  untraced();  // warm up the page cache
+  auto base = seconds(untraced);
+  std::uint64_t stops = 0;
+  auto stopping = seconds([&] { stops = traced(signal_policy::stop); });
+  auto passing = seconds([&] { traced(signal_policy::pass); });
+  auto ignoring = seconds([&] { traced(signal_policy::ignore); });
+
+  fmt::print("100k SIGUSR1s:\n");
+  fmt::print("untraced                      {:>8.1f} ms\n", base * 1e3);
+  fmt::print("stop, resumed by the caller   {:>8.1f} ms ({:.1f}x, {} stops)\n", stopping * 1e3, stopping / base, stops);
+  fmt::print("pass, in the wait loop        {:>8.1f} ms ({:.1f}x)\n", passing * 1e3, passing / base);
+  fmt::print("ignore, in the wait loop      {:>8.1f} ms ({:.1f}x)\n", ignoring * 1e3, ignoring / base);
+}
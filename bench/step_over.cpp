@@ -0,0 +1,40 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+
+using namespace xdb;
+
+namespace {
+  // hit the breakpoint on hot() until the target exits
+  void hits(std::string_view name, step_over_strategy strategy, bool hardware = false) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/hot_breakpoint", true, channel.get_write_fd());
+    channel.close_write();
+    proc->set_step_over_strategy(strategy);
+    proc->resume();
+    proc->wait_on_signal();
+    auto hot = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    proc->create_breakpoint_site(hot, hardware).enable();
+
+    std::size_t n_hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    proc->resume();
+    while (proc->wait_on_signal().reason == process_state::stopped) {
+      ++n_hits;
+      proc->resume();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:<28} {:>9.0f} hits/s {:>8.2f} us/hit ({} hits)\n", name, n_hits / elapsed.count(),
+               elapsed.count() / n_hits * 1e6, n_hits);
+  }
+}
+
+int main() {
+  fmt::print("step over:\n");
+  hits("in place", step_over_strategy::in_place);
+  hits("displaced", step_over_strategy::displaced);
+  hits("hardware", step_over_strategy::displaced, true);
+}
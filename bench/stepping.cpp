@@ -0,0 +1,68 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <libxdb/step_until.hpp>
+
+using namespace xdb;
+
+namespace {
+  constexpr std::uint64_t n_steps = 100000;
+
+  // stopped in the target's loop, with the address of hot() in hot
+  std::unique_ptr<process> start(virt_addr& hot) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/hot_breakpoint", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+    hot = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    return proc;
+  }
+
+  template <class F>
+  void steps(std::string_view name, F step) {
+    virt_addr hot;
+    auto proc = start(hot);
+    auto start_time = std::chrono::steady_clock::now();
+    std::uint64_t n = step(*proc, hot);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    fmt::print("{:<28} {:>9.0f} instr/s {:>8.2f} us/instr ({} steps)\n", name, n / elapsed.count(),
+               elapsed.count() / n * 1e6, n);
+  }
+}
+
+int main() {
+  fmt::print("stepping {} instructions:\n", n_steps);
+  // a stepi loop that shows every register after each instruction
+  steps("step_instruction + all regs", [](process& proc, virt_addr) {
+    for (std::uint64_t i = 0; i < n_steps; ++i) {
+      proc.step_instruction();
+      for (auto& info : g_register_infos) proc.get_registers().read(info);
+    }
+    return n_steps;
+  });
+  // one reported stop and a pc per instruction
+  steps("step_instruction + pc", [](process& proc, virt_addr) {
+    for (std::uint64_t i = 0; i < n_steps; ++i) {
+      proc.step_instruction();
+      proc.get_pc();
+    }
+    return n_steps;
+  });
+  steps("step_instructions(n)", [](process& proc, virt_addr) {
+    return proc.step_instructions(n_steps).steps;
+  });
+  // the pc never leaves, so every step reads it
+  steps("until pc outside", [](process& proc, virt_addr) {
+    return proc.step_instructions(n_steps, pc_outside(proc, virt_addr{ 0 }, virt_addr{ ~0ull })).steps;
+  });
+  steps("until fs changes", [](process& proc, virt_addr) {
+    return proc.step_instructions(n_steps, register_changes(proc, register_info_by_id(register_id::fs))).steps;
+  });
+  steps("until memory changes", [](process& proc, virt_addr hot) {
+    return proc.step_instructions(n_steps, memory_changes(proc, hot, 8)).steps;
+  });
+}
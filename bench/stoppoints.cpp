@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/process.hpp>
+#include <random>
+
+using namespace xdb;
+
+namespace {
+  template <class T>
+  void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  template <class F>
+  void time_ops(std::size_t n_sites, std::string_view name, std::size_t n_ops, F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    fmt::print("{:>7} sites  {:<24} {:>10.1f} ns/op\n", n_sites, name, elapsed.count() / n_ops * 1e9);
+  }
+
+  void run(std::size_t n_sites) {
+    auto proc = process::launch("targets/trap_loop");
+    auto& sites = proc->breakpoint_sites();
+
+    // one site every 16 bytes, created in random order
+    std::vector<std::uint64_t> addrs(n_sites);
+    for (std::size_t i = 0; i < n_sites; ++i) addrs[i] = 0x400000 + i * 16;
+    std::shuffle(addrs.begin(), addrs.end(), std::mt19937_64{42});
+
+    time_ops(n_sites, "create", n_sites, [&] {
+      for (auto addr : addrs) proc->create_breakpoint_site(virt_addr{ addr });
+    });
+
+    constexpr std::size_t n_lookups = 1000000;
+    time_ops(n_sites, "get_by_address (hit)", n_lookups, [&] {
+      for (std::size_t i = 0; i < n_lookups; ++i) {
+        do_not_optimize(&sites.get_by_address(virt_addr{ addrs[i % n_sites] }));
+      }
+    });
+    time_ops(n_sites, "contains (miss)", n_lookups, [&] {
+      for (std::size_t i = 0; i < n_lookups; ++i) {
+        do_not_optimize(sites.contains(virt_addr{ addrs[i % n_sites] + 1 }));
+      }
+    });
+
+    // what a trap used to cost: a linear scan over every site
+    std::vector<breakpoint_site*> flat;
+    sites.for_each([&](auto& site) { flat.push_back(&site); });
+    auto n_linear = std::min<std::size_t>(n_lookups, 10000000 / n_sites);
+    time_ops(n_sites, "linear scan (hit)", n_linear, [&] {
+      for (std::size_t i = 0; i < n_linear; ++i) {
+        virt_addr addr{ addrs[(i * 7919) % n_sites] };
+        do_not_optimize(*std::find_if(flat.begin(), flat.end(), [&](auto site) { return site->at_address(addr); }));
+      }
+    });
+
+    constexpr std::size_t n_ranges = 10000;
+    time_ops(n_sites, "get_in_range (page)", n_ranges, [&] {
+      for (std::size_t i = 0; i < n_ranges; ++i) {
+        virt_addr low{ addrs[i % n_sites] & ~std::uint64_t{0xfff} };
+        do_not_optimize(sites.get_in_range(low, low + page_size).size());
+      }
+    });
+
+    time_ops(n_sites, "remove_by_address", n_sites, [&] {
+      for (auto addr : addrs) sites.remove_by_address(virt_addr{ addr });
+    });
+  }
+}
+
+int main() {
+  fmt::print("stoppoints:\n");
+  for (std::size_t n_sites : { 10, 1000, 100000 }) {
+    run(n_sites);
+  }
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/symbol_index.hpp>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // Startup as the debugger sees it: open the file, get its index, then
+  // name the function and line at main
+  double start_up(const std::string& path, const std::filesystem::path& cache, bool& from_cache) {
+    return seconds([&] {
+      elf file(path);
+      auto index = symbol_index::load(file, cache);
+      from_cache = index->from_cache();
+      auto main = index->symbol_by_name("main");
+      if (!main) return;
+      auto address = virt_addr{ main->st_value };
+      if (!index->symbol_containing_address(address) || !index->line_entry_at_address(address)) {
+        fmt::print("  lookup failed\n");
+      }
+    });
+  }
+
+  void bench_file(const std::string& path) {
+    auto cache = std::filesystem::temp_directory_path() / ("xdb-bench-cache-" + std::to_string(getpid()));
+    std::filesystem::remove_all(cache);
+    {
+      elf file(path);
+      if (file.build_id().empty()) {
+        fmt::print("{}: no build id, so never cached\n", path);
+        return;
+      }
+      fmt::print("{} ({:.1f} MB of .debug_info, {} symbols):\n", path,
+                 file.section_contents(".debug_info").size() / 1e6, file.symbols().size());
+    }
+
+    bool from_cache;
+    auto cold = start_up(path, cache, from_cache);
+    fmt::print("  {:<28} {:>9.3f} ms{}\n", "cold, build and write", cold * 1e3, from_cache ? " (cached?)" : "");
+    double warm = 1e9;
+    for (int i = 0; i < 5; ++i) warm = std::min(warm, start_up(path, cache, from_cache));
+    fmt::print("  {:<28} {:>9.3f} ms{}\n", "warm, mapped", warm * 1e3, from_cache ? "" : " (not cached?)");
+    for (auto& entry : std::filesystem::directory_iterator(cache)) {
+      fmt::print("  {:<28} {:>9.1f} MB\n", "index file", entry.file_size() / 1e6);
+    }
+    fmt::print("  {:<28} {:>9.1f}x\n", "speedup", cold / warm);
+    std::filesystem::remove_all(cache);
+  }
+}
+
+// the files to look at are the arguments; by default this program
+int main(int argc, char** argv) {
+  std::vector<std::string> paths(argv + 1, argv + argc);
+  if (paths.empty()) paths.push_back("/proc/self/exe");
+  for (auto& path : paths) bench_file(path);
+}
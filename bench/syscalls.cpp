@@ -0,0 +1,89 @@
+#include <chrono>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <libxdb/process.hpp>
+#include <libxdb/syscalls.hpp>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace xdb;
+
+namespace {
+  constexpr const char* target = "targets/syscall_heavy";
+
+  template <class F>
+  double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  pid_t spawn(bool traced) {
+    auto pid = fork();
+    if (pid == 0) {
+      if (traced) ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+      execl(target, target, nullptr);
+      _exit(1);
+    }
+    return pid;
+  }
+
+  void untraced() {
+    int status;
+    waitpid(spawn(false), &status, 0);
+  }
+
+  // the strace way: a stop at the entry and exit of every syscall, selected
+  // or not, and the registers read at each
+  void ptrace_syscall(int selected, const std::filesystem::path& log_path) {
+    std::ofstream log(log_path);
+    auto pid = spawn(true);
+    int status;
+    waitpid(pid, &status, 0);
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_TRACESYSGOOD);
+    bool entry = true;
+    std::optional<syscall_record> record;
+    for (;;) {
+      ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr);
+      waitpid(pid, &status, 0);
+      if (!WIFSTOPPED(status)) break;
+      if (WSTOPSIG(status) != (SIGTRAP | 0x80)) continue;
+      user_regs_struct regs;
+      ptrace(PTRACE_GETREGS, pid, nullptr, &regs);
+      if (entry && static_cast<int>(regs.orig_rax) == selected) {
+        record = syscall_record{ pid, selected, { regs.rdi, regs.rsi, regs.rdx, regs.r10, regs.r8, regs.r9 }, std::nullopt };
+      } else if (!entry && record) {
+        record->ret = static_cast<std::int64_t>(regs.rax);
+        log << *record;
+        record.reset();
+      }
+      entry = !entry;
+    }
+  }
+
+  void seccomp(std::vector<int> selected, const std::filesystem::path& log) {
+    auto proc = process::launch(target, true, std::nullopt, syscall_trace{ std::move(selected), log });
+    proc->resume();
+    while (proc->wait_on_signal().reason == process_state::stopped) proc->resume();
+  }
+}
+
+int main() {
+  auto log = std::filesystem::temp_directory_path() / ("xdb_bench_syscalls_" + std::to_string(getpid()));
+  untraced();  // warm up the page cache
+  auto base = seconds(untraced);
+  auto plain = seconds([&] { ptrace_syscall(SYS_openat, log); });
+  auto filtered = seconds([&] { seccomp({ SYS_openat }, log); });
+  auto filtered_hot = seconds([&] { seccomp({ SYS_openat, SYS_write }, log); });
+  std::filesystem::remove(log);
+
+  fmt::print("100k reads and writes, 100 opens:\n");
+  fmt::print("untraced                          {:>8.1f} ms\n", base * 1e3);
+  fmt::print("PTRACE_SYSCALL, logging openat    {:>8.1f} ms ({:.1f}x)\n", plain * 1e3, plain / base);
+  fmt::print("seccomp filter, logging openat    {:>8.1f} ms ({:.1f}x)\n", filtered * 1e3, filtered / base);
+  fmt::print("seccomp filter, openat and write  {:>8.1f} ms ({:.1f}x)\n", filtered_hot * 1e3, filtered_hot / base);
+}
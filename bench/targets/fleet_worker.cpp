@@ -0,0 +1,20 @@
+#include <cstdlib>
+#include <pthread.h>
+#include <unistd.h>
+
+void* work(void*) {
+  for (;;) usleep(5000);
+}
+
+// a worker with XDB_BENCH_THREADS threads, counting the main one, that wake
+// up every 5 ms; writes a byte to stdout once they all exist
+int main() {
+  auto env = std::getenv("XDB_BENCH_THREADS");
+  int n_threads = env ? std::atoi(env) : 1;
+  for (int i = 1; i < n_threads; ++i) {
+    pthread_t thread;
+    pthread_create(&thread, nullptr, work, nullptr);
+  }
+  write(STDOUT_FILENO, "R", 1);
+  work(nullptr);
+}
@@ -0,0 +1,20 @@
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// forks XDB_BENCH_CHILDREN children that exit straight away, keeping up to
+// 16 of them alive at a time
+int main() {
+  auto env = std::getenv("XDB_BENCH_CHILDREN");
+  int n_children = env ? std::atoi(env) : 100;
+  int alive = 0;
+  for (int i = 0; i < n_children; ++i) {
+    if (alive == 16) {
+      wait(nullptr);
+      --alive;
+    }
+    if (fork() == 0) _exit(i & 0xff);
+    ++alive;
+  }
+  while (wait(nullptr) > 0) {}
+}
@@ -0,0 +1,14 @@
+#include <signal.h>
+#include <unistd.h>
+
+__attribute__((noinline)) void hot(int i) {
+  asm volatile("" : : "r"(i));
+}
+
+// Reports the address of hot(), traps, then calls it a million times
+int main() {
+  auto address = &hot;
+  write(STDOUT_FILENO, &address, sizeof(address));
+  raise(SIGTRAP);
+  for (int i = 0; i < 1000000; ++i) hot(i);
+}
@@ -0,0 +1,6 @@
+#include <unistd.h>
+
+// Sleeps until killed
+int main() {
+  for (;;) pause();
+}
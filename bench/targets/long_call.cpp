@@ -0,0 +1,16 @@
+#include <signal.h>
+#include <unistd.h>
+
+__attribute__((noinline)) void work(int n) {
+  for (int i = 0; i < n; ++i) asm volatile("" : : "r"(i));
+}
+
+// Reports the address of work(), traps, then calls it from the same call
+// site a few times, each running a long loop
+int main() {
+  auto address = &work;
+  write(STDOUT_FILENO, &address, sizeof(address));
+  raise(SIGTRAP);
+  volatile int calls = 4;
+  for (int i = 0; i < calls; ++i) work(20000);
+}
@@ -0,0 +1,15 @@
+#include <cstdlib>
+#include <cstring>
+#include <signal.h>
+#include <unistd.h>
+
+// Allocates a 64 MiB buffer, reports its address and size, then traps
+int main() {
+  std::size_t size = 64 << 20;
+  auto buffer = static_cast<char*>(std::malloc(size));
+  std::memset(buffer, 0x42, size);
+  write(STDOUT_FILENO, &buffer, sizeof(buffer));
+  write(STDOUT_FILENO, &size, sizeof(size));
+  raise(SIGTRAP);
+  for (;;) pause();
+}
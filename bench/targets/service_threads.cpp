@@ -0,0 +1,54 @@
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+  constexpr int n_workers = 4;
+  struct alignas(64) counter {
+    std::atomic<std::uint64_t> value{ 0 };
+  };
+  counter work[n_workers];
+  std::atomic<bool> done{ false };
+}
+
+__attribute__((noinline)) void tick() {
+  asm volatile("" ::: "memory");
+}
+
+void* worker(void* arg) {
+  auto& count = static_cast<counter*>(arg)->value;
+  while (!done.load(std::memory_order_relaxed)) count.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void* ticker(void*) {
+  timespec interval{ 0, 1000000 };
+  while (!done.load(std::memory_order_relaxed)) {
+    tick();
+    nanosleep(&interval, nullptr);
+  }
+  return nullptr;
+}
+
+// A stand-in for a service: worker threads count units of work while a
+// ticker calls tick() every millisecond. Reports the address of tick(), traps,
+// runs for a second and then reports the total work done.
+int main() {
+  auto address = &tick;
+  write(STDOUT_FILENO, &address, sizeof(address));
+  raise(SIGTRAP);
+
+  pthread_t threads[n_workers + 1];
+  for (int i = 0; i < n_workers; ++i) pthread_create(&threads[i], nullptr, worker, &work[i]);
+  pthread_create(&threads[n_workers], nullptr, ticker, nullptr);
+  sleep(1);
+  done = true;
+  for (auto& thread : threads) pthread_join(thread, nullptr);
+
+  std::uint64_t total = 0;
+  for (auto& count : work) total += count.value;
+  write(STDOUT_FILENO, &total, sizeof(total));
+}
@@ -0,0 +1,10 @@
+#include <signal.h>
+
+volatile sig_atomic_t handled = 0;
+
+// raises SIGUSR1 a hundred thousand times, each caught by a handler
+int main() {
+  signal(SIGUSR1, [](int) { handled = handled + 1; });
+  for (int i = 0; i < 100000; ++i) raise(SIGUSR1);
+  return handled == 100000 ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+#include <atomic>
+#include <cstdlib>
+#include <pthread.h>
+#include <signal.h>
+
+std::atomic<int> started{ 0 };
+
+void* spin(void*) {
+  ++started;
+  for (;;) {}
+}
+
+// runs XDB_BENCH_THREADS threads, counting the main one, all spinning
+int main() {
+  auto env = std::getenv("XDB_BENCH_THREADS");
+  int n_threads = env ? std::atoi(env) : 1;
+  for (int i = 1; i < n_threads; ++i) {
+    pthread_t thread;
+    pthread_create(&thread, nullptr, spin, nullptr);
+  }
+  while (started < n_threads - 1) {}
+  raise(SIGTRAP);
+  spin(nullptr);
+}
@@ -0,0 +1,15 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+// an I/O-bound loop: a read and a write per iteration, and an open and close
+// every thousandth
+int main() {
+  auto in = open("/dev/zero", O_RDONLY);
+  auto out = open("/dev/null", O_WRONLY);
+  char buffer[64];
+  for (int i = 0; i < 100000; ++i) {
+    read(in, buffer, sizeof(buffer));
+    write(out, buffer, sizeof(buffer));
+    if (i % 1000 == 0) close(open("/dev/null", O_RDONLY));
+  }
+}
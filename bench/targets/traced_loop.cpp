@@ -0,0 +1,24 @@
+#include <signal.h>
+#include <unistd.h>
+
+// seven bytes of code before the ret, enough for a tracepoint's jump
+extern "C" long hot(long i);
+asm(R"(
+  .text
+  .globl hot
+  .type hot, @function
+hot:
+  movq %rdi, %rax
+  addq $1, %rax
+  ret
+)");
+
+// Reports the address of hot(), traps, then calls it ten million times
+int main() {
+  auto address = &hot;
+  write(STDOUT_FILENO, &address, sizeof(address));
+  raise(SIGTRAP);
+  long sum = 0;
+  for (long i = 0; i < 10000000; ++i) sum += hot(i);
+  asm volatile("" : : "r"(sum));
+}
@@ -0,0 +1,6 @@
+#include <signal.h>
+
+// Stops with SIGTRAP over and over
+int main() {
+  for (;;) raise(SIGTRAP);
+}
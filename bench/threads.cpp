@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <libxdb/process.hpp>
+#include <string>
+#include <thread>
+
+using namespace xdb;
+
+namespace {
+  // how long interrupt() takes to stop every thread of a process whose
+  // threads all spin
+  void stop_all(int n_threads) {
+    setenv("XDB_BENCH_THREADS", std::to_string(n_threads).c_str(), 1);
+    auto proc = process::launch("targets/spinning_threads");
+    proc->resume();
+    proc->wait_on_signal();
+    if (proc->threads().size() != static_cast<std::size_t>(n_threads)) {
+      fmt::print("expected {} threads, found {}\n", n_threads, proc->threads().size());
+      return;
+    }
+
+    constexpr int n_stops = 20;
+    std::chrono::duration<double> total{}, worst{};
+    for (int i = 0; i < n_stops; ++i) {
+      proc->resume();
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      auto start = std::chrono::steady_clock::now();
+      proc->interrupt();
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      total += elapsed;
+      worst = std::max(worst, elapsed);
+    }
+    fmt::print("{:>4} threads {:>10.1f} us/stop-all (worst {:.1f} us)\n", n_threads,
+               total.count() / n_stops * 1e6, worst.count() * 1e6);
+  }
+}
+
+int main() {
+  fmt::print("stop-all latency:\n");
+  for (int n : { 1, 16, 256 }) stop_all(n);
+}
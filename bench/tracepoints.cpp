@@ -0,0 +1,92 @@
+#include <atomic>
+#include <chrono>
+#include <fmt/format.h>
+#include <libxdb/bits.hpp>
+#include <libxdb/pipe.hpp>
+#include <libxdb/process.hpp>
+#include <thread>
+
+using namespace xdb;
+
+namespace {
+  constexpr std::size_t n_calls = 10000000;
+
+  std::unique_ptr<process> launch(virt_addr& hot) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/traced_loop", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+    hot = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    return proc;
+  }
+
+  // seconds from resuming until the target exits
+  double run_to_exit(process& proc) {
+    auto start = std::chrono::steady_clock::now();
+    proc.resume();
+    proc.wait_on_signal();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  double untraced() {
+    virt_addr hot;
+    auto proc = launch(hot);
+    auto seconds = run_to_exit(*proc);
+    fmt::print("{:<28} {:>9.1f} ns/call\n", "no tracepoint", seconds / n_calls * 1e9);
+    return seconds;
+  }
+
+  // records rdi and the return address on every call while another thread
+  // drains the buffer
+  void traced(double baseline) {
+    virt_addr hot;
+    auto proc = launch(hot);
+    proc->create_tracepoint(hot, { { register_id::rdi, std::nullopt }, { register_id::rsp, 0 } }).enable();
+    auto& buffer = proc->get_trace_buffer();
+
+    std::atomic<bool> done = false;
+    std::size_t drained = 0;
+    std::thread drainer([&] {
+      while (!done.load()) {
+        buffer.drain([&](auto&) { ++drained; });
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+      buffer.drain([&](auto&) { ++drained; });
+    });
+    auto seconds = run_to_exit(*proc);
+    done = true;
+    drainer.join();
+
+    fmt::print("{:<28} {:>9.1f} ns/call, {:.1f} ns/hit over the untraced loop ({} recorded, {} dropped)\n",
+               "tracepoint", seconds / n_calls * 1e9, (seconds - baseline) / n_calls * 1e9, drained,
+               buffer.dropped());
+  }
+
+  // the same function with a breakpoint, for the first 100k calls
+  void breakpoint() {
+    virt_addr hot;
+    auto proc = launch(hot);
+    auto& site = proc->create_breakpoint_site(hot);
+    site.enable();
+    constexpr std::size_t n_hits = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n_hits; ++i) {
+      proc->resume();
+      proc->wait_on_signal();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    proc->breakpoint_sites().remove_by_id(site.id());
+    fmt::print("{:<28} {:>9.1f} ns/hit\n", "breakpoint stop", elapsed.count() / n_hits * 1e9);
+    run_to_exit(*proc);
+  }
+}
+
+int main() {
+  fmt::print("tracepoints ({} calls):\n", n_calls);
+  auto baseline = untraced();
+  traced(baseline);
+  breakpoint();
+}
@@ -0,0 +1,74 @@
+#ifndef XDB_ARENA_HPP
+#define XDB_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xdb {
+// A bump allocator: objects are carved out of large blocks one after another
+// and all freed together with the arena, never one at a time. Only trivially
+// destructible types go in, as nothing is destroyed.
+class arena {
+ public:
+  explicit arena(std::size_t block_size = 64 * 1024) : block_size_(block_size) {}
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  void* allocate(std::size_t size, std::size_t align) {
+    auto offset = (align - reinterpret_cast<std::uintptr_t>(next_) % align) % align;
+    if (!next_ || offset + size > left_) {
+      // something bigger than a block gets one of its own
+      auto block = std::max(block_size_, size + align);
+      // left uninitialized, so pages are only touched as they are used
+      blocks_.emplace_back(new std::byte[block]);
+      next_ = blocks_.back().get();
+      left_ = block;
+      reserved_ += block;
+      offset = (align - reinterpret_cast<std::uintptr_t>(next_) % align) % align;
+    }
+    auto ptr = next_ + offset;
+    next_ += offset + size;
+    left_ -= offset + size;
+    return ptr;
+  }
+
+  template <class T, class... Args>
+  T* make(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>, "the arena never destroys what it holds");
+    return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+  }
+
+  // n value-initialized Ts, or the contents of a vector
+  template <class T>
+  T* make_array(std::size_t n) {
+    static_assert(std::is_trivially_destructible_v<T>, "the arena never destroys what it holds");
+    auto data = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    for (std::size_t i = 0; i < n; ++i) new (data + i) T{};
+    return data;
+  }
+  template <class T>
+  T* copy(const std::vector<T>& values) {
+    auto data = make_array<T>(values.size());
+    std::copy(values.begin(), values.end(), data);
+    return data;
+  }
+
+  // bytes taken from the system, whether used yet or not
+  std::size_t reserved() const { return reserved_; }
+
+ private:
+  std::size_t block_size_;
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::byte* next_ = nullptr;
+  std::size_t left_ = 0;
+  std::size_t reserved_ = 0;
+};
+}  // namespace xdb
+
+#endif
@@ -2,7 +2,9 @@
 #define XDB_BREAKPOINT_SITE_HPP
 
 #include <cstddef>
+#include <optional>
 
+#include "libxdb/stop_condition.hpp"
 #include "libxdb/types.hpp"
 
 namespace xdb {
@@ -24,6 +26,10 @@ class breakpoint_site {
   bool is_enabled() const {
     return is_enabled_;
   }
+  // hardware sites use a debug register instead of an int3 in .text
+  bool is_hardware() const {
+    return is_hardware_;
+  }
   virt_addr address() const {
     return addr_;
   }
@@ -33,16 +39,46 @@ class breakpoint_site {
   bool in_range(virt_addr start, virt_addr end) const {
     return addr_ >= start && addr_ < end;
   }
+  // put in by the debugger itself, as for step_out; hits the debugger isn't
+  // waiting for are stepped over
+  bool is_internal() const {
+    return is_internal_;
+  }
+
+  // hits where the condition is false are resumed inside wait_on_signal,
+  // as are the next ignore_count() hits where it holds
+  const std::optional<stop_condition>& condition() const {
+    return condition_;
+  }
+  void set_condition(std::optional<stop_condition> condition) {
+    condition_ = std::move(condition);
+  }
+  // hits where the condition held, ignored ones included
+  std::uint64_t hit_count() const {
+    return hit_count_;
+  }
+  std::uint64_t ignore_count() const {
+    return ignore_count_;
+  }
+  void set_ignore_count(std::uint64_t count) {
+    ignore_count_ = count;
+  }
 
  private:
-  breakpoint_site(process& proc, virt_addr addr);
+  breakpoint_site(process& proc, virt_addr addr, bool is_hardware = false, bool is_internal = false);
   friend xdb::process;
 
   id_t id_;
   bool is_enabled_ = false;
+  bool is_hardware_ = false;
+  bool is_internal_ = false;
+  int hardware_register_index_ = -1;
   virt_addr addr_;
   xdb::process& proc_;
   std::byte data_{};
+  std::optional<stop_condition> condition_;
+  std::uint64_t hit_count_ = 0;
+  std::uint64_t ignore_count_ = 0;
 };
 }  // namespace xdb
 
@@ -0,0 +1,211 @@
+#ifndef XDB_DWARF_HPP
+#define XDB_DWARF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "libxdb/arena.hpp"
+#include "libxdb/detail/dwarf.h"
+#include "libxdb/elf.hpp"
+#include "libxdb/types.hpp"
+
+namespace xdb {
+class dwarf;
+class compile_unit;
+
+// [low, high) in file addresses
+struct address_range {
+  std::uint64_t low;
+  std::uint64_t high;
+};
+
+// One debugging information entry, with the attributes stepping and
+// breakpoints need decoded. Addresses are the file's. Lives in the arena of
+// the dwarf it came from.
+struct die {
+  std::uint64_t offset;
+  std::uint64_t tag;
+  std::string_view name;
+  std::string_view linkage_name;
+  // DW_AT_low_pc and DW_AT_high_pc, or ranges from DW_AT_ranges
+  std::uint64_t low_pc;
+  std::uint64_t high_pc;
+  const address_range* ranges;
+  std::size_t n_ranges;
+  // where a definition or an inlined copy takes its name from
+  const die* specification;
+  const die* parent;
+  const die* first_child;
+  const die* next_sibling;
+
+  bool contains_address(std::uint64_t file_address) const;
+};
+
+struct line_row {
+  std::uint64_t address;
+  std::uint32_t file;
+  std::uint32_t line;
+  std::uint16_t column;
+  bool is_stmt;
+  bool end_sequence;
+};
+
+// A unit's line program: the header's files, and once decoded its rows,
+// each sequence in address order and the sequences sorted by start
+struct line_table {
+  std::uint16_t version;
+  span<std::string_view> directories;
+  struct file {
+    std::string_view name;
+    std::uint64_t directory;
+  };
+  // indexed as the rows' file fields are, from 1 before DWARF 5
+  span<file> files;
+  span<line_row> rows;
+};
+
+// A row of a line table, with the address moved by the load bias
+struct line_entry {
+  virt_addr address;
+  std::filesystem::path file;
+  std::uint64_t line;
+  std::uint64_t column;
+  bool is_stmt;
+};
+
+// A compilation unit of .debug_info. Only its header is read up front; its
+// first entry, its line program and the rest of its entries are each
+// decoded the first time they are asked for.
+class compile_unit {
+ public:
+  std::uint64_t offset() const { return offset_; }
+  std::uint16_t version() const { return version_; }
+  std::string_view name() const { return info().name; }
+  std::string_view comp_dir() const { return info().comp_dir; }
+
+  // the unit's entries, all decoded on the first call
+  const die& root() const;
+  // the entry that starts at offset in .debug_info, if it is in this unit
+  const die* die_at_offset(std::uint64_t offset) const;
+  // the header alone, enough to see which files the unit has lines for
+  const line_table& line_header() const;
+  // the header and every row
+  const line_table& lines() const;
+  std::filesystem::path file_path(const line_table& table, std::uint32_t index) const;
+
+  bool dies_parsed() const { return dies_ != nullptr; }
+  bool lines_parsed() const { return lines_ && lines_decoded_; }
+
+ private:
+  friend dwarf;
+  friend class unit_reader;
+  compile_unit(const dwarf& parent, std::uint64_t offset) : parent_(&parent), offset_(offset) {}
+
+  // what the first entry says about the whole unit
+  struct unit_info {
+    std::string_view name;
+    std::string_view comp_dir;
+    std::optional<std::uint64_t> stmt_list;
+    std::uint64_t low_pc = 0;
+    std::uint64_t high_pc = 0;
+    std::vector<address_range> ranges;
+  };
+  const unit_info& info() const;
+
+  const dwarf* parent_;
+  std::uint64_t offset_;
+  std::uint64_t end_ = 0;
+  std::uint64_t first_die_ = 0;
+  std::uint64_t abbrev_offset_ = 0;
+  std::uint16_t version_ = 0;
+  std::uint8_t address_size_ = 8;
+  bool is_64bit_ = false;
+  // from the first entry, which may need them itself
+  mutable std::uint64_t str_offsets_base_ = 0;
+  mutable std::uint64_t addr_base_ = 0;
+  mutable std::uint64_t rnglists_base_ = 0;
+
+  mutable std::optional<unit_info> info_;
+  mutable const line_table* lines_ = nullptr;
+  mutable bool lines_decoded_ = false;
+  mutable const die* dies_ = nullptr;
+  mutable const die* const* dies_by_offset_ = nullptr;
+  mutable std::size_t n_dies_ = 0;
+};
+
+// The DWARF of an ELF file, read lazily. Construction indexes the units by
+// the address ranges .debug_aranges gives them, falling back to the ranges on
+// each remaining unit's first entry; lookups then decode only the units they
+// land in, into one arena. Like the units, it isn't safe to use from two
+// threads at once. Addresses given and returned are the process's, moved
+// by the elf's load bias.
+class dwarf {
+ public:
+  // use_aranges false ignores .debug_aranges and reads every unit's first
+  // entry for its ranges
+  explicit dwarf(const elf& file, bool use_aranges = true);
+  dwarf(const dwarf&) = delete;
+  dwarf& operator=(const dwarf&) = delete;
+
+  const elf& elf_file() const { return *elf_; }
+  const std::vector<std::unique_ptr<compile_unit>>& compile_units() const { return units_; }
+
+  const compile_unit* compile_unit_containing_address(virt_addr address) const;
+  // the innermost subprogram or inlined subroutine holding address
+  const die* function_containing_address(virt_addr address) const;
+  std::optional<line_entry> line_entry_at_address(virt_addr address) const;
+  // the first address of each run of statement rows for line of a file
+  // whose path ends with file; only the units that list the file are decoded
+  std::vector<virt_addr> addresses_for_line(std::string_view file, std::uint64_t line) const;
+
+  // decode every unit's entries and lines now, as an eager reader would
+  void parse_all() const;
+  std::size_t arena_bytes() const { return arena_.reserved(); }
+
+ private:
+  friend compile_unit;
+  friend class unit_reader;
+  struct attribute_spec {
+    std::uint64_t attribute;
+    std::uint64_t form;
+    std::int64_t implicit_const;
+  };
+  struct abbrev {
+    std::uint64_t tag;
+    bool has_children;
+    const attribute_spec* specs;
+    std::size_t n_specs;
+  };
+  // the table at offset in .debug_abbrev, indexed by code, read on first use
+  const std::vector<abbrev>& abbrev_table(std::uint64_t offset) const;
+
+  const elf* elf_;
+  span<std::byte> info_;
+  span<std::byte> abbrev_;
+  span<std::byte> str_;
+  span<std::byte> line_str_;
+  span<std::byte> line_;
+  span<std::byte> str_offsets_;
+  span<std::byte> addr_;
+  span<std::byte> ranges_;
+  span<std::byte> rnglists_;
+  std::vector<std::unique_ptr<compile_unit>> units_;
+  // sorted by low, for a binary search
+  struct unit_range {
+    std::uint64_t low;
+    std::uint64_t high;
+    compile_unit* unit;
+  };
+  std::vector<unit_range> index_;
+  mutable std::unordered_map<std::uint64_t, std::vector<abbrev>> abbrev_tables_;
+  mutable arena arena_;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef XDB_ELF_HPP
+#define XDB_ELF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <elf.h>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "libxdb/types.hpp"
+
+namespace xdb {
+// A run of T in memory we don't own
+template <class T>
+class span {
+ public:
+  span() = default;
+  span(const T* data, std::size_t size) : data_(data), size_(size) {}
+  const T* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+  const T& operator[](std::size_t i) const { return data_[i]; }
+
+ private:
+  const T* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// A 64-bit ELF file mapped read-only. Headers, section contents, symbols and
+// names are views into the mapping, so opening a file copies none of it and
+// touches only the pages that are looked at; the views live as long as the
+// elf does.
+//
+// Addresses are those the file gives until notify_loaded() says where it
+// was loaded; from then on they are the process's, offset by the load bias.
+class elf {
+ public:
+  explicit elf(const std::filesystem::path& path);
+  elf(const elf&) = delete;
+  elf& operator=(const elf&) = delete;
+  ~elf();
+
+  const std::filesystem::path& path() const { return path_; }
+  const Elf64_Ehdr& header() const { return *header_; }
+  // the file as it is mapped
+  span<std::byte> data() const { return { data_, size_ }; }
+
+  span<Elf64_Shdr> sections() const { return { section_headers_, header_->e_shnum }; }
+  std::string_view section_name(const Elf64_Shdr& section) const;
+  // nullptr if there's no section of that name
+  const Elf64_Shdr* get_section(std::string_view name) const;
+  // empty for a section without bytes in the file, such as .bss
+  span<std::byte> section_contents(const Elf64_Shdr& section) const;
+  span<std::byte> section_contents(std::string_view name) const;
+  // the string at offset in the string table section table
+  std::string_view get_string(const Elf64_Shdr& table, std::size_t offset) const;
+  span<Elf64_Phdr> segments() const;
+
+  // .symtab, or .dynsym for a stripped file; empty if it has neither
+  span<Elf64_Sym> symbols() const { return symbols_; }
+  span<Elf64_Sym> dynamic_symbols() const { return dynamic_symbols_; }
+  std::string_view symbol_name(const Elf64_Sym& symbol) const;
+
+  void notify_loaded(virt_addr base);
+  // what the file's addresses are moved by in the process
+  std::uint64_t load_bias() const { return load_bias_; }
+  // the lowest address a PT_LOAD segment asks for, page aligned
+  std::uint64_t image_base() const;
+
+  // the NT_GNU_BUILD_ID note's bytes; empty if the file has none
+  span<std::byte> build_id() const;
+
+  // The function or object symbol whose [value, value + size) holds address,
+  // found by a branchless binary search over their start addresses; of the
+  // symbols at one address, the biggest names it. nullptr if none. The
+  // first lookup sorts the symbols into the index, as the first name miss
+  // does for names.
+  const Elf64_Sym* symbol_containing_address(virt_addr address) const;
+  // A symbol of that name: looked up in .gnu.hash when the file has one,
+  // which covers the exported definitions of .dynsym, then in a sorted index
+  // of the other symbols that is built on the first miss, so the first such
+  // lookup costs a sort and isn't safe to race with another. nullptr if none.
+  const Elf64_Sym* symbol_by_name(std::string_view name) const;
+
+ private:
+  // reads the indexes to save them in its image
+  friend class symbol_index;
+  void build_address_index() const;
+  void build_name_index() const;
+  const Elf64_Sym* gnu_hash_lookup(std::string_view name) const;
+  // the symbols of a symbol table section; empty for nullptr
+  span<Elf64_Sym> symbol_table(const Elf64_Shdr* section) const;
+
+  std::filesystem::path path_;
+  std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+  const Elf64_Ehdr* header_ = nullptr;
+  const Elf64_Shdr* section_headers_ = nullptr;
+  std::unordered_map<std::string_view, const Elf64_Shdr*> section_map_;
+
+  span<Elf64_Sym> symbols_;
+  const Elf64_Shdr* symbol_strings_ = nullptr;
+  span<Elf64_Sym> dynamic_symbols_;
+  const Elf64_Shdr* dynamic_strings_ = nullptr;
+  const Elf64_Shdr* gnu_hash_ = nullptr;
+  std::uint64_t load_bias_ = 0;
+
+  // start addresses in one array, so a search walks dense cache lines, and
+  // the end and symbol of each in another
+  struct address_entry {
+    std::uint64_t end;
+    const Elf64_Sym* symbol;
+  };
+  mutable bool address_index_built_ = false;
+  mutable std::vector<std::uint64_t> address_starts_;
+  mutable std::vector<address_entry> address_entries_;
+
+  mutable std::optional<std::vector<std::pair<std::string_view, const Elf64_Sym*>>> name_index_;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef XDB_EVENT_LOOP_HPP
+#define XDB_EVENT_LOOP_HPP
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "libxdb/process.hpp"
+
+namespace xdb {
+// A signalfd that becomes readable when a child or a thread we trace changes
+// state. The first call blocks SIGCHLD in the calling thread so the signal
+// queues there; threads started later inherit the mask, so set it up before
+// starting any that don't block it themselves.
+int sigchld_fd();
+// reads away queued SIGCHLDs; waitpid then says what happened
+void drain_sigchld_fd();
+
+// Drives any number of processes and file descriptors from one epoll set,
+// sleeping until one of them has something to report. Stops of the processes
+// are found with waitpid(WNOHANG) once SIGCHLD arrives, so nothing is polled
+// while everything is quiet.
+class event_loop {
+ public:
+  using stop_callback = std::function<void(process&, const stop_reason&)>;
+  using fd_callback = std::function<void(int fd)>;
+
+  event_loop();
+  event_loop(const event_loop&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+  ~event_loop();
+
+  // on_stop gets each stop wait_on_signal would have returned, the exit last
+  void add_process(process& proc, stop_callback on_stop);
+  void remove_process(const process& proc);
+  // on_readable is called whenever fd is readable, end of file included
+  void add_fd(int fd, fd_callback on_readable);
+  void remove_fd(int fd);
+
+  // waits up to timeout, or until something happens if there is none, and
+  // runs the callbacks for whatever did; false if nothing did
+  bool run_once(std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+  // runs until a callback calls stop()
+  void run();
+  void stop() { stopped_ = true; }
+
+ private:
+  // reports the stops of every process with threads running; true if any
+  bool check_processes();
+
+  int epoll_fd_ = -1;
+  std::vector<std::pair<process*, stop_callback>> processes_;
+  std::unordered_map<int, fd_callback> fds_;
+  bool stopped_ = false;
+};
+}  // namespace xdb
+
+#endif
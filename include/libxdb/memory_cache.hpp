@@ -0,0 +1,55 @@
+#ifndef XDB_MEMORY_CACHE_HPP
+#define XDB_MEMORY_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include "libxdb/types.hpp"
+
+namespace xdb {
+// Page-granular cache of inferior memory. The inferior can't change while it
+// is stopped, so pages read during one stop epoch stay valid until the
+// process is resumed or we write to them ourselves.
+class memory_cache {
+ public:
+  using page = std::array<std::byte, page_size>;
+
+  explicit memory_cache(std::size_t max_pages = 256) : max_pages_(max_pages) {}
+  memory_cache(const memory_cache&) = delete;
+  memory_cache& operator=(const memory_cache&) = delete;
+
+  bool enabled() const { return enabled_ && max_pages_ > 0; }
+  void set_enabled(bool enabled) {
+    enabled_ = enabled;
+    clear();
+  }
+  std::size_t max_pages() const { return max_pages_; }
+  void set_max_pages(std::size_t max_pages);
+
+  // page_addr must be page aligned; counts a hit or a miss
+  const page* find(virt_addr page_addr);
+  void insert(virt_addr page_addr, const std::byte* data);
+  // drop the pages overlapping [addr, addr + size)
+  void invalidate(virt_addr addr, std::size_t size);
+  void clear();
+
+  std::size_t size() const { return pages_.size(); }
+  std::uint64_t hits() const { return hits_; }
+  std::uint64_t misses() const { return misses_; }
+  void reset_stats() { hits_ = misses_ = 0; }
+
+ private:
+  bool enabled_ = true;
+  std::size_t max_pages_;
+  std::unordered_map<std::uint64_t, std::unique_ptr<page>> pages_;
+  // insertion order, for evicting the oldest page once full
+  std::deque<std::uint64_t> order_;
+  std::uint64_t hits_ = 0;
+  std::uint64_t misses_ = 0;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef XDB_OBJECT_MAP_HPP
+#define XDB_OBJECT_MAP_HPP
+
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+#include "libxdb/dwarf.hpp"
+#include "libxdb/elf.hpp"
+#include "libxdb/symbol_index.hpp"
+#include "libxdb/thread_pool.hpp"
+#include "libxdb/types.hpp"
+
+namespace xdb {
+class object_map;
+
+// An ELF file mapped into a process: the executable, the dynamic linker or
+// a shared library. Its file and symbol index are loaded by a worker, or by
+// the first thread that needs them if no worker has started on it yet.
+class loaded_object {
+ public:
+  const std::filesystem::path& path() const { return path_; }
+  // from the lowest of its mappings to the end of the highest
+  virt_addr start() const { return start_; }
+  virt_addr end() const { return end_; }
+  bool contains_address(virt_addr address) const { return address >= start_ && address < end_; }
+
+  bool is_loaded() const;
+  // These wait until the object is loaded. A file that couldn't be read,
+  // or isn't an ELF file, throws xdb::error saying why.
+  const elf& get_elf() const;
+  const symbol_index& get_index() const;
+
+ private:
+  friend object_map;
+  loaded_object(std::filesystem::path path, virt_addr start, virt_addr end, virt_addr base,
+                std::optional<std::filesystem::path> cache_dir)
+      : path_(std::move(path)), start_(start), end_(end), base_(base), cache_dir_(std::move(cache_dir)) {}
+  // loads on this thread unless another thread already has or is; false if
+  // it was already claimed
+  bool load() const;
+  void wait() const;
+  // stops a load that hasn't started from happening
+  void cancel() const;
+
+  enum class state { queued, loading, loaded, failed };
+
+  std::filesystem::path path_;
+  virt_addr start_;
+  virt_addr end_;
+  // where the mapping of the file's first page starts
+  virt_addr base_;
+  std::optional<std::filesystem::path> cache_dir_;
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable done_;
+  mutable state state_ = state::queued;
+  mutable std::unique_ptr<elf> elf_;
+  mutable std::unique_ptr<symbol_index> index_;
+  mutable std::string error_;
+};
+
+// Every ELF object a process has mapped, sorted by address. Building one
+// only reads /proc/<pid>/maps; the objects' symbols are then loaded on a
+// pool of workers, so the map can be used at once, and a lookup waits only
+// for the object it lands in. The map itself is for one thread; only the
+// loading happens on others.
+class object_map {
+ public:
+  // 0 workers for one per CPU; with no cache_dir, indexes are always built
+  explicit object_map(pid_t pid, std::size_t n_workers = 0,
+                      std::optional<std::filesystem::path> cache_dir = symbol_index::default_cache_dir());
+  object_map(const object_map&) = delete;
+  object_map& operator=(const object_map&) = delete;
+
+  const std::vector<std::shared_ptr<loaded_object>>& objects() const { return objects_; }
+  std::size_t n_workers() const { return pool_->size(); }
+  const loaded_object* object_containing_address(virt_addr address) const;
+  // queues the load of an object that has just been mapped
+  const loaded_object& add(std::filesystem::path path, virt_addr start, virt_addr end, virt_addr base);
+  // the same for an object the dynamic linker reports, which gives only its
+  // load bias; its span comes from the program headers in the file
+  const loaded_object& add(std::filesystem::path path, virt_addr load_bias);
+  // forgets the object at start, once it has been unmapped
+  void remove(virt_addr start);
+
+  struct symbol_match {
+    const loaded_object* object;
+    const Elf64_Sym* symbol;
+  };
+  // the symbol around address; waits for the object holding it alone
+  std::optional<symbol_match> symbol_containing_address(virt_addr address) const;
+  std::optional<line_entry> line_entry_at_address(virt_addr address) const;
+  // a symbol of that name from the lowest object that has one, waiting for
+  // each object in turn
+  std::optional<symbol_match> symbol_by_name(std::string_view name) const;
+
+  bool all_loaded() const;
+  void wait_all() const;
+
+ private:
+  // into objects_, in order, without queueing its load
+  const std::shared_ptr<loaded_object>& insert(std::filesystem::path path, virt_addr start, virt_addr end,
+                                               virt_addr base);
+
+  std::optional<std::filesystem::path> cache_dir_;
+  // shared with the tasks that load them, which may outlive a removal
+  std::vector<std::shared_ptr<loaded_object>> objects_;
+  // last, so its workers are stopped before the objects they load go
+  std::unique_ptr<thread_pool> pool_;
+};
+}  // namespace xdb
+
+#endif
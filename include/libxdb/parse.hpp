@@ -108,6 +108,38 @@ std::optional<std::array<std::byte, N>> to_vector(std::string_view str) {
   return result;
 }
 
+// parse a variable-length byte list like "[0xff,1,2]"
+inline std::optional<std::vector<std::byte>> to_bytes(std::string_view str) {
+  auto beg = str.begin();
+  auto end = str.end();
+  while (beg != end && std::isspace(*beg)) ++beg;
+  while (beg != end && std::isspace(*(end - 1))) --end;
+  if (beg == end || *beg != '[' || *(end - 1) != ']') {
+    return std::nullopt;
+  }
+  ++beg;
+  --end;
+
+  std::vector<std::byte> result;
+  auto is_delim = [](char c) { return std::isspace(c) || c == ','; };
+  while (beg != end) {
+    while (beg != end && is_delim(*beg)) ++beg;
+    if (beg == end) break;
+
+    std::size_t len = 1;
+    while (beg + len != end && !is_delim(*(beg + len))) {
+      ++len;
+    }
+    auto value = to_integer<std::byte>({beg, len});
+    if (!value) {
+      return std::nullopt;
+    }
+    result.push_back(*value);
+    beg += len;
+  }
+  return result;
+}
+
 }
 
 #endif
\ No newline at end of file
@@ -2,17 +2,38 @@
 #define XDB_PROCESS_HPP
 
 #include <libxdb/registers.hpp>
+#include <libxdb/bits.hpp>
+#include <libxdb/memory_cache.hpp>
 #include <cstdint>
 #include <libxdb/error.hpp>
 #include <cassert>
 #include <iostream>
 #include <memory>
 #include <filesystem>
+#include <fstream>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <initializer_list>
+#include <map>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 #include "libxdb/stoppoint_manager.hpp"
 #include "libxdb/types.hpp"
 #include <libxdb/breakpoint_site.hpp>
+#include <libxdb/dwarf.hpp>
+#include <libxdb/elf.hpp>
+#include <libxdb/object_map.hpp>
+#include <libxdb/symbol_index.hpp>
+#include <libxdb/syscalls.hpp>
+#include <libxdb/trace_buffer.hpp>
+#include <libxdb/tracepoint.hpp>
+#include <libxdb/watchpoint.hpp>
 
 namespace xdb {
   enum class process_state {
@@ -22,59 +43,463 @@ namespace xdb {
     terminated
   };
 
+  // how resume() gets past an enabled software breakpoint at the pc
+  enum class step_over_strategy {
+    // restore the original byte, single-step, put the int3 back
+    in_place,
+    // run a relocated copy of the instruction in scratch memory, which jumps
+    // back afterwards; falls back to in_place for instructions it can't move
+    displaced
+  };
+
+  // what the wait loop does with a signal on its way to a thread
+  enum class signal_policy {
+    // report the stop; resuming the thread delivers the signal
+    stop,
+    // deliver it at once and tell the signal observer, without a stop
+    print,
+    // deliver it at once
+    pass,
+    // throw it away
+    ignore
+  };
+
+  enum class trap_type {
+    single_step,
+    software_break,
+    hardware_break,
+    unknown
+  };
+
   struct stop_reason {
     stop_reason(int wait_status);
     process_state reason;
     std::uint8_t info;
+    // what raised a SIGTRAP stop
+    std::optional<trap_type> trap_reason;
+  };
+
+  // One thread of the inferior, with its own register cache
+  struct thread_state {
+    pid_t tid;
+    process_state state = process_state::stopped;
+    std::unique_ptr<registers> regs;
+    // a stop we asked for (a SIGSTOP, or PTRACE_INTERRUPT if the process was
+    // seized), or a new thread's first stop, is still to come
+    bool pending_sigstop = false;
+    // hasn't stopped since it was created, so it has no debug registers yet
+    bool is_new = false;
+    // single stepping, so a stop we filter out steps it again
+    bool stepping = false;
+    // its last stop was reported, so resuming it steps over a breakpoint
+    // under its pc rather than hitting it again
+    bool reported = false;
+    // a stop that came in while the threads were being stopped for another
+    // one's or, in non-stop mode, while waiting for another thread, for
+    // wait_on_signal to report next
+    std::optional<stop_reason> pending_stop;
+    // stopped at the entry of a traced syscall, or running until its exit
+    std::optional<syscall_record> in_syscall;
+    // a signal it stopped on the way to, delivered when it next continues
+    int pending_signal = 0;
+  };
+
+  // Syscalls for launch to trace with a seccomp filter. Only those stop the
+  // inferior, once on entry and once on exit, and never as far as
+  // wait_on_signal: each is written to log as a line and the thread goes on.
+  struct syscall_trace {
+    std::vector<int> syscalls;
+    std::filesystem::path log;
+  };
+
+  // How process::step_instructions ended: reason is the last stop, and steps
+  // the instructions that completed before it
+  struct step_result {
+    stop_reason reason;
+    std::uint64_t steps;
   };
 
   class process {
     public:
       // debug entry of launching a new process
-      static std::unique_ptr<process> launch(std::filesystem::path path, bool trace=true, std::optional<int> stdout_replacement=std::nullopt);
-      // debug entry of attaching to an existing process
+      static std::unique_ptr<process> launch(std::filesystem::path path, bool trace=true, std::optional<int> stdout_replacement=std::nullopt,
+                                             std::optional<syscall_trace> syscalls=std::nullopt);
+      // debug entry of attaching to an existing process, and all its threads
       static std::unique_ptr<process> attach(pid_t pid);
+      // attach to many processes at once, in the order given; they are all
+      // stopped together, so each is paused for about as long as one would be
+      static std::vector<std::unique_ptr<process>> attach(const std::vector<pid_t>& pids);
 
+      // resume every stopped thread, or only tid
       void resume();
+      void resume(pid_t tid);
       stop_reason wait_on_signal();
+      // nullopt if no thread stops within timeout; sleeps on sigchld_fd()
+      std::optional<stop_reason> wait_on_signal(std::chrono::milliseconds timeout);
+      // like wait_on_signal, but nullopt if no thread has stopped yet
+      std::optional<stop_reason> poll_stop();
+      // steps the current thread; in non-stop mode the others keep running
+      stop_reason step_instruction();
+      // Steps the current thread count times, or until until() is true after a
+      // step, or until anything else stops it: a breakpoint it steps onto, a
+      // signal, its exit. Only the last stop is reported. Each step in between
+      // is a PTRACE_SINGLESTEP, a waitpid and a PTRACE_GETSIGINFO, plus
+      // whatever until reads.
+      step_result step_instructions(std::uint64_t count, const std::function<bool()>& until = nullptr);
+      // These run the current thread to hidden breakpoints, so they take a
+      // stop or two however much code runs on the way. Any other stop (a user
+      // breakpoint, a signal, the exit) ends them early. Finding the caller
+      // goes by the prologue, so in code without frame pointers it is only
+      // right at the entry or the ret of a function.
+      //
+      // until address is reached, in any frame, or the current function returns
+      stop_reason run_until(virt_addr address);
+      // until the current function returns to its caller
+      stop_reason step_out();
+      // until the pc leaves [low, high), with calls made from it run to their
+      // return; low must be the start of an instruction
+      stop_reason step_over_range(virt_addr low, virt_addr high);
+      // step_over_range over the instruction at the pc
+      stop_reason step_over_instruction();
+      // In non-stop mode a stop only stops the thread that reported it, and
+      // state() is the current thread's. Off by default; turning it off
+      // stops every thread.
+      void set_non_stop(bool on);
+      bool non_stop() const { return non_stop_; }
+      step_over_strategy get_step_over_strategy() const { return step_over_strategy_; }
+      void set_step_over_strategy(step_over_strategy strategy) { step_over_strategy_ = strategy; }
       pid_t pid() const { return pid_; }
       process_state state() const { return state_; }
+      // bumped on every stop; the inferior can't change within one epoch
+      std::uint64_t stop_epoch() const { return stop_epoch_; }
+      // the executable, mapped from /proc/<pid>/exe on first use and told
+      // where it is loaded; an exec replaces it
+      elf& get_elf();
+      // its debugging information, read lazily as lookups need it
+      const dwarf& get_dwarf();
+      // its symbol and line indexes, mapped from the on-disk cache when a
+      // run before this one built them
+      const symbol_index& get_symbol_index();
+      // where get_symbol_index and get_objects cache indexes, by default
+      // symbol_index::default_cache_dir(); with none, they are always built.
+      // Takes effect for indexes not loaded yet.
+      void set_symbol_cache_dir(std::optional<std::filesystem::path> dir) { symbol_cache_dir_ = std::move(dir); }
+      // every object the process has mapped, as its maps list them on the
+      // first call; their symbols load in the background from then on. The
+      // dynamic linker's own list is followed after that, through a hidden
+      // breakpoint on the function it calls around each dlopen and dlclose,
+      // so objects are added and removed as it changes without reading the
+      // maps again.
+      object_map& get_objects();
+
+      // An enabled breakpoint on the symbol name, from the lowest object that
+      // defines it. If none of the loaded objects does, it is kept pending,
+      // and nullptr returned, until an object that defines it is loaded.
+      breakpoint_site* create_breakpoint_at_symbol(std::string name, bool hardware = false);
+      struct pending_breakpoint {
+        std::string symbol;
+        bool hardware;
+      };
+      const std::vector<pending_breakpoint>& pending_breakpoints() const { return pending_breakpoints_; }
+      // drops the breakpoint on symbol, pending or placed
+      void remove_breakpoint_at_symbol(std::string_view symbol);
+      // removes the site, and with it the breakpoint on a symbol it was
+      // placed for
+      void remove_breakpoint_site(breakpoint_site::id_t id);
+      // called with each pending breakpoint as it gets its site
+      using resolve_observer = std::function<void(const std::string& symbol, breakpoint_site& site)>;
+      void set_resolve_observer(resolve_observer observer) { resolve_observer_ = std::move(observer); }
 
       process() = delete;
       process(const process&) = delete;
       process& operator=(const process&) = delete;
       ~process();
 
-      registers& get_registers() { return *regs_; } 
-      const registers& get_registers() const { return *regs_; }
+      // threads by tid. The current thread is the one the last stop was
+      // reported for; get_registers() and get_pc() look at it.
+      const std::map<pid_t, thread_state>& threads() const { return threads_; }
+      pid_t current_thread() const { return current_tid_; }
+      bool has_running_threads() const;
+      void set_current_thread(pid_t tid);
+      // stop every running thread, signalling all of them before waiting on any
+      void interrupt();
+      // waitpid for a child that isn't traced, such as one launched with
+      // trace=false. A waitpid(-1) for our inferiors may have reaped its exit
+      // first, in which case that status is returned instead of ECHILD.
+      static pid_t wait_untraced(pid_t pid, int* status, int options = 0);
+
+      // Called with each child a fork or vfork creates, already attached and
+      // running, with our settings and fork handler. Without a handler
+      // children are detached, with our int3s removed from their memory.
+      using fork_handler = std::function<void(std::unique_ptr<process>)>;
+      void set_fork_handler(fork_handler handler) { fork_handler_ = std::move(handler); }
+      // Signal-delivery stops are settled in the wait loop by these, so a
+      // signal that doesn't stop costs a waitpid and a PTRACE_CONT carrying
+      // it. SIGTRAP and SIGSTOP are the debugger's own, always stop and are
+      // never delivered. By default SIGALRM, SIGVTALRM, SIGPROF, SIGCHLD,
+      // SIGURG, SIGIO and SIGWINCH pass and every other signal stops.
+      // Children get a copy of the table and the observer.
+      void set_signal_policy(int signo, signal_policy policy);
+      signal_policy get_signal_policy(int signo) const;
+      using signal_observer = std::function<void(pid_t tid, int signo)>;
+      void set_signal_observer(signal_observer observer) { signal_observer_ = std::move(observer); }
+      // For one wait loop over many inferiors: the thread group of the next
+      // wait status that wanted accepts, collected with waitpid(-1) if none
+      // is stashed. That process's poll_stop() then takes it.
+      static pid_t next_pending_thread_group(const std::function<bool(pid_t)>& wanted);
+
+      registers& get_registers() { return *current_regs_; } 
+      const registers& get_registers() const { return *current_regs_; }
+      registers& get_registers(pid_t tid);
+      const registers& get_registers(pid_t tid) const;
+      // read registers
+      void read_gprs(pid_t tid, user_regs_struct& gprs) const;
+      void read_fprs(pid_t tid, user_fpregs_struct& fprs) const;
+      std::uint64_t read_user_area(pid_t tid, std::size_t offset) const;
       // write regisers
-      void write_user_area(std::size_t offset, std::uint64_t data);
-      void write_fprs(const user_fpregs_struct& fprs);
-      void write_gprs(const user_regs_struct& gprs);
+      void write_user_area(pid_t tid, std::size_t offset, std::uint64_t data);
+      void write_fprs(pid_t tid, const user_fpregs_struct& fprs);
+      void write_gprs(pid_t tid, const user_regs_struct& gprs);
 
       xdb::virt_addr get_pc() const {
-        return xdb::virt_addr(regs_->read_by_id<std::uint64_t>(register_id::rip));
+        return xdb::virt_addr(current_regs_->read<register_id::rip>());
       } 
 
 
+      // memory access
+      std::vector<std::byte> read_memory(virt_addr address, std::size_t amount) const;
+      void read_memory(virt_addr address, std::byte* data, std::size_t amount) const;
+      void write_memory(virt_addr address, const std::byte* data, std::size_t size);
+      void write_memory(virt_addr address, const std::vector<std::byte>& data) {
+        write_memory(address, data.data(), data.size());
+      }
+      // memory as the program sees it, with our int3 bytes replaced by the
+      // original data
+      std::vector<std::byte> read_memory_without_traps(virt_addr address, std::size_t amount) const;
+      void read_memory_without_traps(virt_addr address, std::byte* data, std::size_t amount) const;
+      memory_cache& get_memory_cache() { return mem_cache_; }
+      const memory_cache& get_memory_cache() const { return mem_cache_; }
+      template <class T>
+      T read_memory_as(virt_addr address) const {
+        auto data = read_memory(address, sizeof(T));
+        return from_bytes<T>(data.data());
+      }
+
       // breakpoint management
-      breakpoint_site& create_breakpoint_site(virt_addr addr);
+      // internal sites are the debugger's own, and left out of user listings
+      breakpoint_site& create_breakpoint_site(virt_addr addr, bool hardware = false, bool internal = false);
+      stoppoint_manager<breakpoint_site>& breakpoint_sites() { return breakpoint_sites_; }
+      const stoppoint_manager<breakpoint_site>& breakpoint_sites() const { return breakpoint_sites_; }
+      // patch many sites at once: each page is read once and written back
+      // once, however many sites it holds
+      void enable_breakpoint_sites(std::vector<breakpoint_site*> sites);
+      void disable_breakpoint_sites(std::vector<breakpoint_site*> sites);
+      void enable_all_breakpoint_sites();
+      void disable_all_breakpoint_sites();
+
+      // watchpoints and hardware breakpoints share the four debug address
+      // registers dr0-dr3; the set_* calls return the slot they took
+      watchpoint& create_watchpoint(virt_addr address, stoppoint_mode mode, std::size_t size);
+      stoppoint_manager<watchpoint>& watchpoints() { return watchpoints_; }
+      const stoppoint_manager<watchpoint>& watchpoints() const { return watchpoints_; }
+      int set_hardware_breakpoint(virt_addr address);
+      int set_watchpoint(virt_addr address, stoppoint_mode mode, std::size_t size);
+      void clear_hardware_stoppoint(int index);
+      // which stoppoint raised the current hardware_break stop, from dr6
+      std::variant<breakpoint_site::id_t, watchpoint::id_t> get_current_hardware_stoppoint() const;
+
+      // fast tracepoints record into the trace buffer without stopping
+      tracepoint& create_tracepoint(virt_addr address, std::vector<trace_field> fields);
+      stoppoint_manager<tracepoint>& tracepoints() { return tracepoints_; }
+      const stoppoint_manager<tracepoint>& tracepoints() const { return tracepoints_; }
+      void enable_tracepoint(tracepoint& point);
+      void disable_tracepoint(tracepoint& point);
+      // set up in the inferior on first use, which needs it stopped
+      trace_buffer& get_trace_buffer();
+      static constexpr std::size_t trace_buffer_capacity = 1 << 16;
 
 
     private: 
       process(pid_t pid, bool termianted_on_end, bool is_attached)
-        : pid_(pid), terminated_on_end_(termianted_on_end),
-        is_attached_(is_attached), regs_(new registers(*this)) {}
+        : pid_(pid), terminated_on_end_(termianted_on_end), is_attached_(is_attached), current_tid_(pid) {
+        current_regs_ = add_thread(pid, process_state::stopped, false).regs.get();
+      }
+
+      thread_state& add_thread(pid_t tid, process_state state, bool pending_sigstop);
+      // PTRACE_SEIZE every thread in /proc/<pid>/task, leaving them running
+      void seize_threads();
+      // ask a running thread to stop, without waiting for it
+      void request_stop(thread_state& thread);
+      // whether a stop is the one request_stop or a new thread's creation causes
+      bool is_interrupt_stop(int wait_status) const;
+      void copy_debug_registers(thread_state& thread);
+      // the next wait status of one of our threads, either stashed by another
+      // process object's waitpid(-1) or from our own; nullopt if block is
+      // false and there is none yet
+      std::optional<std::pair<pid_t, int>> next_wait_status(bool block = true);
+      // handles a status that isn't a stop to report: thread creation and
+      // exit and the SIGSTOPs we caused; returns the stop reason otherwise
+      std::optional<stop_reason> filter_wait_status(pid_t tid, int wait_status);
+      // whether threads that report a filtered-out stop are set running again
+      bool keep_running() const {
+        return !stopping_threads_ && (non_stop_ || state_ == process_state::running);
+      }
+      // PTRACE_CONT, or PTRACE_SINGLESTEP if it is stepping, with no step over
+      void continue_thread(thread_state& thread);
+      // step over the breakpoint its reported stop was at, then continue
+      void resume_thread(thread_state& thread);
+      // write out the syscall it is in, with or without its return value
+      void log_syscall(thread_state& thread);
+      std::unique_ptr<process> make_child(pid_t pid, bool vfork);
+      void handle_exec();
+      // the span the main executable is mapped at, found on first use
+      struct executable_mapping {
+        virt_addr start;
+        virt_addr end;
+        dev_t device;
+        ino_t inode;
+      };
+      const executable_mapping& executable_range();
+      // false if the thread exited, was killed or stopped for a ptrace event
+      // on the way
+      bool step_over_breakpoint(thread_state& thread);
+      // Steps the thread over one instruction, with PTRACE_SINGLESTEPs until
+      // the kernel's trap for it: an interrupt we asked for and seccomp stops
+      // are stepped past, and a signal on its way is kept in pending_signal
+      // for the next continue. False if the thread exited, was killed or
+      // stopped for another ptrace event instead, with its status stashed for
+      // wait_for_stop.
+      bool single_step_thread(thread_state& thread);
+      void stop_running_threads();
+      // runs f with every thread but the current one stopped, for changes
+      // running threads mustn't see halfway; in all-stop mode they already are
+      template <class F>
+      void with_other_threads_stopped(F f);
       
-      // read regisers
-      void read_all_registers();
+      // read straight from the inferior, bypassing the page cache
+      void read_memory_direct(virt_addr address, std::byte* data, std::size_t amount) const;
+
+      // waits for any thread, or only for thread only (stops of others are
+      // kept as their pending_stop)
+      std::optional<stop_reason> wait_for_stop(bool block = true, pid_t only = 0);
+      // fill in stop_reason::trap_reason from the siginfo of a SIGTRAP stop
+      void augment_stop_reason(stop_reason& reason);
+      // counts a breakpoint hit and checks its condition and ignore count;
+      // true when the stop should be hidden and the inferior resumed
+      bool should_resume_from(const stop_reason& reason);
+      int set_hardware_stoppoint(virt_addr address, stoppoint_mode mode, std::size_t size);
+      // lets a resume run past a hardware breakpoint at the pc
+      void set_resume_flag(registers& regs);
+      // Resumes until the current thread stops at one of targets where
+      // accept holds, putting internal sites on the ones that need them for
+      // the duration; reached is false if something else stopped it
+      struct target_run {
+        stop_reason reason;
+        bool reached;
+      };
+      target_run run_to_targets(const std::vector<virt_addr>& targets, const std::function<bool(virt_addr)>& accept);
+      // where the current function's return address is: [rsp] at its entry
+      // or its ret, [rsp + 8] right after "push rbp", else [rbp + 8] or, for
+      // a leaf without a frame pointer, [rsp]; none if no slot holds a code
+      // address
+      std::optional<virt_addr> return_address_slot() const;
+      static std::array<signal_policy, NSIG> default_signal_policies();
+
+      // Finds the dynamic linker's r_debug through DT_DEBUG, or, before the
+      // linker has run, its rendezvous function among its own symbols, and
+      // puts an internal site there. Nothing for a static executable.
+      void track_shared_objects();
+      // r_debug as the executable's DT_DEBUG points to it; nullopt until the
+      // dynamic linker fills that in
+      std::optional<virt_addr> find_r_debug();
+      // Brings objects_ in line with the link_map list once r_debug says the
+      // list is consistent, and resolves the pending breakpoints the objects
+      // new to it define
+      void update_shared_objects();
+      void resolve_pending_breakpoints(const std::vector<const loaded_object*>& added);
+      // forget the code of the sites in [low, high), which was unmapped
+      void unload_breakpoint_sites(virt_addr low, virt_addr high);
+
+      // run a syscall in thread from its current pc; the registers and the
+      // code under the pc are restored afterwards
+      std::int64_t inject_syscall(thread_state& thread, std::uint64_t number,
+                                  std::initializer_list<std::uint64_t> args);
+      // the same, with the other threads already stopped
+      std::int64_t inject_syscall_stopped(thread_state& thread, std::uint64_t number,
+                                          std::initializer_list<std::uint64_t> args);
+      // executable memory within rel32 reach of near, for relocated code; a
+      // new block is mapped by a syscall thread runs
+      virt_addr allocate_scratch(thread_state& thread, virt_addr near, std::size_t size);
+      // the relocated copy of the instruction under site, made on first use
+      // with thread's help; nullopt if the instruction can't be moved
+      std::optional<virt_addr> displaced_copy(thread_state& thread, const breakpoint_site& site);
+
+      // the trampoline for point, with the relocated copy of code
+      std::vector<std::byte> build_trampoline(const tracepoint& point, const std::vector<std::byte>& code, virt_addr slot);
+
+      // fd of /proc/<pid>/mem, opened on first use
+      int mem_fd() const;
+      // access a single page through /proc/<pid>/mem, which can reach pages
+      // process_vm_readv/writev can't (e.g. read-only text when writing)
+      void read_proc_mem(virt_addr address, std::byte* data, std::size_t size) const;
+      void write_proc_mem(virt_addr address, const std::byte* data, std::size_t size);
+      // read or patch the bytes under the given sites, one page at a time
+      void patch_breakpoint_sites(std::vector<breakpoint_site*>& sites, bool enable);
 
       pid_t pid_ = 0;
       process_state state_ = process_state::stopped;
+      std::uint64_t stop_epoch_ = 0;
       bool terminated_on_end_ = true;
       bool is_attached_ = true;
-      std::unique_ptr<registers> regs_;
+      // attached with PTRACE_SEIZE, so stops use PTRACE_INTERRUPT, not SIGSTOP
+      bool seized_ = false;
+      bool non_stop_ = false;
+      bool stopping_threads_ = false;
+      std::map<pid_t, thread_state> threads_;
+      pid_t current_tid_;
+      registers* current_regs_;
+      // the debug registers every thread gets, new ones included
+      std::array<std::uint64_t, 4> hardware_addresses_{};
+      std::uint64_t hardware_control_ = 0;
+      // shared with the children, which inherit the seccomp filter
+      std::shared_ptr<std::ofstream> syscall_log_;
+      fork_handler fork_handler_;
+      std::array<signal_policy, NSIG> signal_policies_ = default_signal_policies();
+      signal_observer signal_observer_;
+      std::optional<executable_mapping> executable_;
+      mutable int mem_fd_ = -1;
+      mutable memory_cache mem_cache_;
       stoppoint_manager<breakpoint_site> breakpoint_sites_;
+      stoppoint_manager<watchpoint> watchpoints_;
+      stoppoint_manager<tracepoint> tracepoints_;
+      std::unique_ptr<trace_buffer> trace_buffer_;
+      std::unique_ptr<elf> elf_;
+      std::unique_ptr<dwarf> dwarf_;
+      std::unique_ptr<symbol_index> symbol_index_;
+      std::optional<std::filesystem::path> symbol_cache_dir_ = symbol_index::default_cache_dir();
+      std::unique_ptr<object_map> objects_;
+      std::optional<virt_addr> r_debug_address_;
+      // r_brk: where the dynamic linker calls in before and after changing
+      // its list of objects
+      std::optional<virt_addr> rendezvous_address_;
+      // the link_map entries seen when the list was last consistent, by their
+      // l_ld, with the start of their object; none for those that aren't
+      // files, like the executable's own and the vdso's
+      std::unordered_map<std::uint64_t, std::optional<virt_addr>> linked_objects_;
+      std::vector<pending_breakpoint> pending_breakpoints_;
+      // the sites made for a symbol, by id, to go back to pending if their
+      // object is unloaded
+      std::unordered_map<breakpoint_site::id_t, pending_breakpoint> symbol_sites_;
+      resolve_observer resolve_observer_;
+      virt_addr trace_buffer_address_;
+      step_over_strategy step_over_strategy_ = step_over_strategy::displaced;
+      std::unordered_map<breakpoint_site::id_t, std::optional<virt_addr>> displaced_copies_;
+      struct scratch_block {
+        virt_addr base;
+        std::size_t size;
+        std::size_t used;
+      };
+      std::vector<scratch_block> scratch_blocks_;
   };
 
 }
@@ -3,8 +3,13 @@
 
 #include <sys/user.h>
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string_view>
 #include <libxdb/error.hpp>
+#include <libxdb/types.hpp>
 
 namespace xdb {
   enum class register_id {
@@ -42,6 +47,128 @@ namespace xdb {
   };
 
 
+  namespace detail {
+    inline constexpr std::size_t n_registers = std::size(g_register_infos);
+
+    constexpr bool register_ids_are_indices() {
+      for (std::size_t i = 0; i < n_registers; ++i) {
+        if (static_cast<std::size_t>(g_register_infos[i].id) != i) return false;
+      }
+      return true;
+    }
+    static_assert(register_ids_are_indices(), "registers.inc must list registers in register_id order");
+
+    // FNV-1a
+    constexpr std::uint64_t hash_name(std::string_view name) {
+      std::uint64_t hash = 0xcbf29ce484222325;
+      for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+      }
+      return hash;
+    }
+
+    // splitmix64 finalizer
+    constexpr std::uint64_t mix(std::uint64_t x) {
+      x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+      x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+      return x ^ (x >> 31);
+    }
+
+    // Perfect hash of register names (hash and displace): names are grouped
+    // into buckets by hash, and each bucket gets the first displacement that
+    // sends all of its names to free slots. A lookup is then two hashes and
+    // a single string comparison.
+    inline constexpr std::size_t name_buckets = 64;
+    inline constexpr std::size_t name_slots = 256;
+    static_assert(n_registers <= name_slots);
+
+    struct register_name_table {
+      std::array<std::uint16_t, name_buckets> displacement{};
+      std::array<std::int16_t, name_slots> index{};
+    };
+
+    constexpr std::size_t name_slot(std::uint64_t hash, std::uint16_t displacement) {
+      return mix(hash + displacement) % name_slots;
+    }
+
+    constexpr register_name_table make_register_name_table() {
+      register_name_table table{};
+      for (auto& index : table.index) index = -1;
+
+      std::array<std::uint64_t, n_registers> hashes{};
+      std::array<std::size_t, name_buckets> bucket_sizes{};
+      for (std::size_t i = 0; i < n_registers; ++i) {
+        hashes[i] = hash_name(g_register_infos[i].name);
+        ++bucket_sizes[hashes[i] % name_buckets];
+      }
+
+      // place the largest buckets first, while the table is still empty
+      std::array<bool, name_buckets> placed{};
+      for (std::size_t n = 0; n < name_buckets; ++n) {
+        std::size_t bucket = 0;
+        std::size_t largest = 0;
+        for (std::size_t b = 0; b < name_buckets; ++b) {
+          if (!placed[b] && bucket_sizes[b] >= largest) {
+            bucket = b;
+            largest = bucket_sizes[b];
+          }
+        }
+        placed[bucket] = true;
+
+        std::array<std::size_t, n_registers> members{};
+        std::size_t n_members = 0;
+        for (std::size_t i = 0; i < n_registers; ++i) {
+          if (hashes[i] % name_buckets == bucket) members[n_members++] = i;
+        }
+
+        for (std::uint16_t displacement = 0;; ++displacement) {
+          if (displacement == 0xffff) throw "no perfect hash displacement found";
+          bool fits = true;
+          for (std::size_t m = 0; m < n_members && fits; ++m) {
+            auto slot = name_slot(hashes[members[m]], displacement);
+            fits = table.index[slot] == -1;
+            for (std::size_t other = 0; other < m && fits; ++other) {
+              fits = name_slot(hashes[members[other]], displacement) != slot;
+            }
+          }
+          if (fits) {
+            table.displacement[bucket] = displacement;
+            for (std::size_t m = 0; m < n_members; ++m) {
+              table.index[name_slot(hashes[members[m]], displacement)] = static_cast<std::int16_t>(members[m]);
+            }
+            break;
+          }
+        }
+      }
+      return table;
+    }
+
+    inline constexpr register_name_table g_register_name_table = make_register_name_table();
+
+    constexpr std::size_t max_dwarf_id() {
+      std::int32_t max = 0;
+      for (auto& info : g_register_infos) max = std::max(max, info.dwarf_id);
+      return max;
+    }
+
+    using register_dwarf_table = std::array<std::int16_t, max_dwarf_id() + 1>;
+
+    // indices into g_register_infos by DWARF register number, -1 if unused
+    constexpr register_dwarf_table make_register_dwarf_table() {
+      register_dwarf_table table{};
+      for (auto& index : table) index = -1;
+      for (std::size_t i = 0; i < n_registers; ++i) {
+        if (g_register_infos[i].dwarf_id >= 0) {
+          table[g_register_infos[i].dwarf_id] = static_cast<std::int16_t>(i);
+        }
+      }
+      return table;
+    }
+
+    inline constexpr register_dwarf_table g_register_dwarf_table = make_register_dwarf_table();
+  }
+
   template <class F>
   const register_info& register_info_by(F f) {
     auto it = std::find_if(std::begin(g_register_infos), std::end(g_register_infos), f);
@@ -51,17 +178,42 @@ namespace xdb {
     return *it;
   }
 
-  inline const register_info& register_info_by_id(register_id id) {
-    return register_info_by([id](auto& i) { return i.id == id; });
+  constexpr const register_info& register_info_by_id(register_id id) {
+    return g_register_infos[static_cast<std::size_t>(id)];
   }
 
   inline const register_info& register_info_by_name(std::string_view name) {
-    return register_info_by([name](auto& i) { return i.name == name; });
+    auto hash = detail::hash_name(name);
+    auto displacement = detail::g_register_name_table.displacement[hash % detail::name_buckets];
+    auto index = detail::g_register_name_table.index[detail::name_slot(hash, displacement)];
+    if (index < 0 || g_register_infos[index].name != name) {
+      error::send("Can't find register info");
+    }
+    return g_register_infos[index];
   }
 
   inline const register_info& register_info_by_dwarf(std::int32_t dwarf_id) {
-    return register_info_by([dwarf_id](auto& i) { return i.dwarf_id == dwarf_id; });
+    if (dwarf_id < 0 || static_cast<std::size_t>(dwarf_id) >= detail::g_register_dwarf_table.size() ||
+        detail::g_register_dwarf_table[dwarf_id] < 0) {
+      error::send("Can't find register info");
+    }
+    return g_register_infos[detail::g_register_dwarf_table[dwarf_id]];
   }
+
+  // the C++ type holding the value of a register, e.g. std::uint64_t for rip
+  template <register_format Format, std::size_t Size>
+  struct register_value;
+  template <> struct register_value<register_format::uint, 1> { using type = std::uint8_t; };
+  template <> struct register_value<register_format::uint, 2> { using type = std::uint16_t; };
+  template <> struct register_value<register_format::uint, 4> { using type = std::uint32_t; };
+  template <> struct register_value<register_format::uint, 8> { using type = std::uint64_t; };
+  template <> struct register_value<register_format::double_float, 8> { using type = double; };
+  template <> struct register_value<register_format::long_double, 16> { using type = long double; };
+  template <> struct register_value<register_format::vector, 8> { using type = byte64; };
+  template <> struct register_value<register_format::vector, 16> { using type = byte128; };
+
+  template <register_id Id>
+  using register_value_t = typename register_value<register_info_by_id(Id).format, register_info_by_id(Id).size>::type;
 }
 
 #endif
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define XDB_REGISTERS_HPP
 
 
+#include <cstddef>
+#include <sys/types.h>
+#include <libxdb/bits.hpp>
 #include <libxdb/types.hpp>
 #include <libxdb/register_info.hpp>
 
@@ -20,16 +23,70 @@ namespace xdb {
       T read_by_id(register_id id) const {
         return std::get<T>(read(register_info_by_id(id)));
       }
+      // typed read with the register resolved at compile time: no lookup and
+      // no variant, just a copy out of the register block
+      template<register_id Id>
+      register_value_t<Id> read() const {
+        constexpr auto& info = register_info_by_id(Id);
+        ensure_fetched(info);
+        return from_bytes<register_value_t<Id>>(as_bytes(data_) + info.offset);
+      }
+
       void write_by_id(register_id id, xdb::value v) {
         write(register_info_by_id(id), v);
       }
 
+      // number of ptrace calls issued to fetch or flush registers so far
+      std::uint64_t syscall_count() const { return syscall_count_; }
+      // the thread these registers belong to
+      pid_t tid() const { return tid_; }
+
     private:
       friend process;
-      registers(process& proc): proc_(&proc) {}
+      registers(process& proc, pid_t tid): proc_(&proc), tid_(tid) {}
+
+      // each register class (gpr, fpr) is fetched on its first access after
+      // a stop, so stops nobody inspects cost no syscalls. Debug registers
+      // take a PEEKUSER each, so they are fetched one at a time.
+      void ensure_fetched(register_type type) const {
+        if (!(valid_ & class_bit(type))) fetch(type);
+      }
+      void ensure_fetched(const register_info& info) const {
+        if (info.type == register_type::dr) {
+          auto index = dr_index(info);
+          if (!(valid_drs_ & (1u << index))) fetch_dr(index);
+        } else {
+          ensure_fetched(info.type);
+        }
+      }
+      void fetch(register_type type) const;
+      void fetch_dr(std::size_t index) const;
+      void invalidate() {
+        valid_ = 0;
+        valid_drs_ = 0;
+      }
+      // writes only update data_ and mark their class dirty; the process
+      // writes each dirty class back once before the inferior runs again
+      void flush();
+
+      static std::size_t dr_index(const register_info& info) {
+        return (info.offset - offsetof(user, u_debugreg)) / 8;
+      }
+      static unsigned class_bit(register_type type) {
+        // sub-registers live in the GPR block
+        return type == register_type::sub_gpr ? 1u << static_cast<int>(register_type::gpr)
+                                               : 1u << static_cast<int>(type);
+      }
 
-      user data_;
+      mutable user data_;
+      mutable unsigned valid_ = 0;
+      mutable std::uint8_t valid_drs_ = 0;
+      unsigned dirty_ = 0;
+      // debug registers have no SETREGS-style call, so track them one by one
+      std::uint8_t dirty_drs_ = 0;
+      mutable std::uint64_t syscall_count_ = 0;
       process *proc_;
+      pid_t tid_;
   };
 }
 
@@ -0,0 +1,40 @@
+#ifndef XDB_SESSION_HPP
+#define XDB_SESSION_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "libxdb/process.hpp"
+
+namespace xdb {
+// Inferiors that share one wait loop. A process added to the session follows
+// its forks: each child joins the session as a process of its own, running,
+// with the parent's breakpoints. A process stays in the session after it
+// has exited, until it is removed.
+class session {
+ public:
+  session() = default;
+  session(const session&) = delete;
+  session& operator=(const session&) = delete;
+
+  process& add(std::unique_ptr<process> proc);
+  // detaches from it, or kills it if it was launched
+  void remove(const process& proc);
+
+  const std::vector<std::unique_ptr<process>>& processes() const { return processes_; }
+  // nullptr if no process of the session has that pid
+  process* find(pid_t pid) const;
+
+  // the next stop of any inferior, as its wait_on_signal would report it;
+  // each wait status is collected once, whichever inferior it belongs to
+  std::pair<process&, stop_reason> wait_on_signal();
+
+ private:
+  std::vector<std::unique_ptr<process>> processes_;
+  std::unordered_map<pid_t, process*> by_pid_;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef XDB_STEP_UNTIL_HPP
+#define XDB_STEP_UNTIL_HPP
+
+#include <cstddef>
+#include <functional>
+
+#include "libxdb/register_info.hpp"
+#include "libxdb/types.hpp"
+
+namespace xdb {
+class process;
+
+// A test process::step_instructions makes after every step. The ones below
+// read only what they compare: the pc (one PTRACE_GETREGS), one register
+// (nothing more for a general purpose one, PTRACE_GETFPREGS or a PEEKUSER for
+// the others) or the memory they watch. Each takes its starting value from
+// the process as it is when it's made.
+using step_predicate = std::function<bool()>;
+
+// true once the pc is outside [low, high)
+step_predicate pc_outside(const process& proc, virt_addr low, virt_addr high);
+// true once the current thread's register differs from its value now
+step_predicate register_changes(const process& proc, const register_info& info);
+// true once any of the size bytes at address differ from their values now
+step_predicate memory_changes(const process& proc, virt_addr address, std::size_t size);
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef XDB_STOP_CONDITION_HPP
+#define XDB_STOP_CONDITION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xdb {
+class process;
+
+// A breakpoint condition compiled to a small stack bytecode, so the wait loop
+// can check it on every hit without going back to the REPL. Expressions use
+// integer registers, literals, memory loads ("qword [rsp + 8]", with byte,
+// word and dword for narrower loads; a bare "[...]" is a qword), the
+// arithmetic and bitwise operators + - & | ^ ~, the comparisons == != < <= >
+// >= (unsigned) and the logical ! && || (short-circuiting). Only the
+// registers and memory the expression touches are read.
+class stop_condition {
+ public:
+  // throws error for anything it can't parse
+  static stop_condition compile(std::string_view text);
+
+  // a load from unmapped memory throws error
+  bool evaluate(const process& proc) const;
+
+  const std::string& text() const { return text_; }
+
+ private:
+  friend class condition_compiler;
+
+  enum class opcode : std::uint8_t {
+    push,      // operand
+    reg,       // register with id operand
+    load,      // size bytes from the popped address
+    add, sub, bit_and, bit_or, bit_xor,
+    eq, ne, lt, le, gt, ge,
+    logical_not, negate, complement,
+    // for && and ||: jump to operand keeping the top as the result if it
+    // decides the outcome, otherwise pop it
+    and_jump, or_jump,
+    to_bool
+  };
+
+  struct instruction {
+    opcode op;
+    std::uint8_t size = 0;
+    std::uint64_t operand = 0;
+  };
+
+  // deep enough for any sane condition; evaluation needs no allocation
+  static constexpr std::size_t max_stack = 32;
+
+  std::vector<instruction> code_;
+  std::string text_;
+};
+}  // namespace xdb
+
+#endif
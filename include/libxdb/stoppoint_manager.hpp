@@ -2,87 +2,162 @@
 #define XDB_STOPPOINT_MANAGER_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
-#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
+#include "libxdb/error.hpp"
 #include "libxdb/types.hpp"
 namespace xdb {
 
+// Owns the stoppoints of one kind. Stoppoints live in a dense vector (the
+// unique_ptrs keep references stable) with hash indices by id and by
+// address, so the lookup done on every trap is O(1). A sorted address index
+// for range queries is rebuilt lazily after insertions.
 template<class T>
 class stoppoint_manager {
  public:
+  using id_t = typename T::id_t;
+
   stoppoint_manager() = default;
   stoppoint_manager(const stoppoint_manager&) = delete;
   stoppoint_manager& operator=(const stoppoint_manager&) = delete;
   ~stoppoint_manager() = default;
 
-
-  void add_stoppoint(T stoppoint) {
-    stoppoints_.emplace_back(stoppoint);
-  }
   T& push(std::unique_ptr<T> stoppoint) {
-    stoppoints_.emplace_back(std::move(stoppoint));
+    auto index = stoppoints_.size();
+    by_id_.emplace(stoppoint->id(), index);
+    by_address_.emplace(stoppoint->address().addr(), index);
+    stoppoints_.push_back(std::move(stoppoint));
+    sorted_valid_ = false;
     return *stoppoints_.back();
   }
 
   bool contains(virt_addr addr) const {
-    for (auto& stoppoint : stoppoints_) {
-      if (stoppoint->address() == addr) {
-        return true;
-      }
+    return by_address_.count(addr.addr()) != 0;
+  }
+  bool contains(id_t id) const {
+    return by_id_.count(id) != 0;
+  }
+  bool enabled_stoppoint_at_address(virt_addr addr) const {
+    auto it = by_address_.find(addr.addr());
+    return it != by_address_.end() && stoppoints_[it->second]->is_enabled();
+  }
+
+  T& get_by_id(id_t id) {
+    return *stoppoints_[index_of_id(id)];
+  }
+  const T& get_by_id(id_t id) const {
+    return *stoppoints_[index_of_id(id)];
+  }
+  T& get_by_address(virt_addr addr) {
+    return *stoppoints_[index_of_address(addr)];
+  }
+  const T& get_by_address(virt_addr addr) const {
+    return *stoppoints_[index_of_address(addr)];
+  }
+
+  // stoppoints with addresses in [low, high), in address order
+  std::vector<T*> get_in_range(virt_addr low, virt_addr high) const {
+    std::vector<T*> ret;
+    for_each_in_range(low, high, [&](T& stoppoint) { ret.push_back(&stoppoint); });
+    return ret;
+  }
+  // the same without building the list
+  template <class F>
+  void for_each_in_range(virt_addr low, virt_addr high, F f) const {
+    ensure_sorted();
+    auto cmp = [](const auto& entry, std::uint64_t addr) { return entry.first < addr; };
+    auto it = std::lower_bound(sorted_.begin(), sorted_.end(), low.addr(), cmp);
+    for (; it != sorted_.end() && it->first < high.addr(); ++it) {
+      f(*stoppoints_[it->second]);
     }
-    return false;
   }
-  bool contains(typename T::id_t id) const {
-    for (auto& stoppoint : stoppoints_) {
-      if (stoppoint->id() == id) {
-        return true;
-      }
+
+  void remove_by_id(id_t id) {
+    remove_at(index_of_id(id));
+  }
+  void remove_by_address(virt_addr addr) {
+    remove_at(index_of_address(addr));
+  }
+
+  template <class F>
+  void for_each(F f) {
+    for (auto& stoppoint : stoppoints_) f(*stoppoint);
+  }
+  template <class F>
+  void for_each(F f) const {
+    for (auto& stoppoint : stoppoints_) f(static_cast<const T&>(*stoppoint));
+  }
+
+  // rebuilds the address index after the owner moved stoppoints; their
+  // addresses must still be distinct
+  void reindex() {
+    by_address_.clear();
+    for (std::size_t i = 0; i < stoppoints_.size(); ++i) {
+      by_address_.emplace(stoppoints_[i]->address().addr(), i);
     }
-    return false;
+    sorted_valid_ = false;
   }
 
-  std::optional<T&> get_by_id(typename T::id_t id) const {
-    for (auto& stoppoint : stoppoints_) {
-      if (stoppoint->id() == id) {
-        return *stoppoint; 
-      }
+  std::size_t size() const { return stoppoints_.size(); }
+  bool empty() const { return stoppoints_.empty(); }
+
+ private:
+  std::size_t index_of_id(id_t id) const {
+    auto it = by_id_.find(id);
+    if (it == by_id_.end()) {
+      error::send("Invalid stoppoint id");
     }
-    return nullptr;
+    return it->second;
   }
-  std::optional<T&> get_by_address(virt_addr addr) const {
-    for (auto& stoppoint : stoppoints_) {
-      if (stoppoint->address() == addr) {
-        return *stoppoint;
-      }
+  std::size_t index_of_address(virt_addr addr) const {
+    auto it = by_address_.find(addr.addr());
+    if (it == by_address_.end()) {
+      error::send("Stoppoint with given address not found");
     }
-    return nullptr;
+    return it->second;
   }
 
- private:
-  using SP = std::vector<std::unique_ptr<T>>;
+  // swap with the last stoppoint and pop, fixing up the moved one's indices
+  void remove_at(std::size_t index) {
+    auto& stoppoint = *stoppoints_[index];
+    if (stoppoint.is_enabled()) {
+      stoppoint.disable();
+    }
+    by_id_.erase(stoppoint.id());
+    by_address_.erase(stoppoint.address().addr());
 
-  auto find_by_id(typename T::id_t id) {
-    return std::find_if(stoppoints_.begin(), stoppoints_.end(), [id](const auto& stoppoint) {
-      return stoppoint->id() == id;
-    });
+    auto last = stoppoints_.size() - 1;
+    if (index != last) {
+      std::swap(stoppoints_[index], stoppoints_[last]);
+      by_id_[stoppoints_[index]->id()] = index;
+      by_address_[stoppoints_[index]->address().addr()] = index;
+    }
+    stoppoints_.pop_back();
+    sorted_valid_ = false;
   }
 
-  // auto find_by_id(typename T::id_t id) const { return 
-  // }
-  struct x {
-    std::vector<int> v;
-    auto f() {
-      return v.begin();
-    }
-    auto f() const {
-      return f();
+  void ensure_sorted() const {
+    if (sorted_valid_) return;
+    sorted_.clear();
+    sorted_.reserve(stoppoints_.size());
+    for (std::size_t i = 0; i < stoppoints_.size(); ++i) {
+      sorted_.emplace_back(stoppoints_[i]->address().addr(), i);
     }
-  };
+    std::sort(sorted_.begin(), sorted_.end());
+    sorted_valid_ = true;
+  }
 
-  SP stoppoints_;
+  std::vector<std::unique_ptr<T>> stoppoints_;
+  std::unordered_map<id_t, std::size_t> by_id_;
+  std::unordered_map<std::uint64_t, std::size_t> by_address_;
+  // (address, index) pairs, sorted by address
+  mutable std::vector<std::pair<std::uint64_t, std::size_t>> sorted_;
+  mutable bool sorted_valid_ = true;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
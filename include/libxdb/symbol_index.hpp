@@ -0,0 +1,76 @@
+#ifndef XDB_SYMBOL_INDEX_HPP
+#define XDB_SYMBOL_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "libxdb/dwarf.hpp"
+#include "libxdb/elf.hpp"
+#include "libxdb/types.hpp"
+
+namespace xdb {
+// The symbol and line indexes of an ELF file in one flat image that holds
+// offsets and symbol numbers rather than pointers, so the same bytes work
+// built in memory or mapped from a cache file. The cache is keyed by the
+// file's build id and lives under default_cache_dir(); a cached image is
+// used in place, with nothing parsed, once its header, version, size and
+// checksum say it is whole and for this build. Addresses given and
+// returned are the process's, moved by the elf's load bias.
+class symbol_index {
+ public:
+  // bumped whenever the layout of the image changes
+  static constexpr std::uint32_t format_version = 1;
+
+  // $XDG_CACHE_HOME/xdb, or ~/.cache/xdb
+  static std::filesystem::path default_cache_dir();
+
+  // The index for file: mapped from cache_dir if an image for its build id
+  // is there and sound, otherwise built from its symbols and DWARF and
+  // written there for next time. A file without a build id is never cached.
+  static std::unique_ptr<symbol_index> load(const elf& file,
+                                            const std::filesystem::path& cache_dir = default_cache_dir());
+  // built in memory, neither read from nor written to a cache
+  static std::unique_ptr<symbol_index> build(const elf& file);
+
+  symbol_index(const symbol_index&) = delete;
+  symbol_index& operator=(const symbol_index&) = delete;
+  ~symbol_index();
+
+  const elf& elf_file() const { return *elf_; }
+  bool from_cache() const { return mapping_ != nullptr; }
+  // where the image was read from or written to; empty if neither
+  const std::filesystem::path& cache_path() const { return cache_path_; }
+  std::size_t size() const { return size_; }
+
+  // as elf::symbol_containing_address and elf::symbol_by_name
+  const Elf64_Sym* symbol_containing_address(virt_addr address) const;
+  const Elf64_Sym* symbol_by_name(std::string_view name) const;
+  // as dwarf::line_entry_at_address and dwarf::addresses_for_line
+  std::optional<line_entry> line_entry_at_address(virt_addr address) const;
+  std::vector<virt_addr> addresses_for_line(std::string_view file, std::uint64_t line) const;
+
+ private:
+  symbol_index(const elf& file) : elf_(&file) {}
+  static std::vector<std::byte> build_image(const elf& file);
+  // false if the image isn't one this build of xdb can use for file
+  static bool is_sound(const elf& file, const std::byte* data, std::size_t size);
+  template <class T>
+  span<T> table(std::size_t which) const;
+  std::string_view file_name(std::uint32_t file) const;
+
+  const elf* elf_;
+  std::filesystem::path cache_path_;
+  // the image, either mapped from the cache or built here
+  void* mapping_ = nullptr;
+  std::vector<std::byte> built_;
+  const std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef XDB_SYSCALLS_HPP
+#define XDB_SYSCALLS_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <sys/types.h>
+
+namespace xdb {
+  // x86-64 syscall numbers by name, and back; both throw for unknown ones
+  std::string_view syscall_id_to_name(int id);
+  int syscall_name_to_id(std::string_view name);
+
+  // One traced syscall, from the registers at its entry and exit
+  struct syscall_record {
+    pid_t tid;
+    int id;
+    std::array<std::uint64_t, 6> args;
+    // nullopt if the thread never came back from it (exit, execve failing
+    // to return, a single step over it)
+    std::optional<std::int64_t> ret;
+  };
+
+  // writes it as one line, strace style: "<tid> name(args...) = ret"
+  std::ostream& operator<<(std::ostream& out, const syscall_record& record);
+}
+
+#endif
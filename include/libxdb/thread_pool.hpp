@@ -0,0 +1,63 @@
+#ifndef XDB_THREAD_POOL_HPP
+#define XDB_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xdb {
+// A fixed set of worker threads, each with its own deque of tasks. A worker
+// takes the newest task from its own deque and, once that is empty, steals
+// the oldest from another's, so a few long tasks landing on one worker don't
+// leave the others idle. Tasks submitted from outside are dealt round the
+// deques in turn. Workers block every signal, so they never take a SIGCHLD
+// meant for the tracing thread.
+class thread_pool {
+ public:
+  using task = std::function<void()>;
+
+  // 0 for one worker per CPU; a positive niceness has the workers yield the
+  // CPU to the threads that started them, for work in the background
+  explicit thread_pool(std::size_t n_workers = 0, int niceness = 0);
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+  // tasks not started yet are dropped; running ones are waited for
+  ~thread_pool();
+
+  std::size_t size() const { return workers_.size(); }
+  void submit(task work);
+  // deals a batch round the deques and wakes the workers once, so a caller
+  // queueing many tasks isn't preempted by a worker for each
+  void submit(std::vector<task> batch);
+  // blocks until every task submitted so far has run
+  void wait_idle();
+
+ private:
+  struct worker {
+    std::mutex mutex;
+    std::deque<task> tasks;
+    std::thread thread;
+  };
+  void run(std::size_t self, int niceness);
+  bool pop(std::size_t self, task& work);
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  std::atomic<std::size_t> next_{ 0 };
+  // tasks in the deques, and those queued or running, which sleeping
+  // workers and wait_idle wait on
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::ptrdiff_t queued_ = 0;
+  std::size_t pending_ = 0;
+  bool stopping_ = false;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef XDB_TRACE_BUFFER_HPP
+#define XDB_TRACE_BUFFER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace xdb {
+// The debugger's side of the ring buffer that tracepoint trampolines write
+// into. The buffer is a memfd mapped shared into both processes:
+//
+//   header (64 bytes): head, tail, dropped, capacity, record size
+//   records:           sequence, tracepoint id, values[max_fields]
+//
+// A trampoline claims slot head with a cmpxchg, fills it in and then stores
+// its sequence number (index + 1) to publish it. When the buffer is full it
+// counts a drop instead of waiting. drain() may run on another thread while
+// the inferior runs; it is the only consumer.
+class trace_buffer {
+ public:
+  static constexpr std::size_t max_fields = 8;
+  static constexpr std::size_t header_size = 64;
+
+  struct record {
+    std::uint64_t sequence;
+    std::uint64_t tracepoint_id;
+    std::array<std::uint64_t, max_fields> values;
+  };
+  static constexpr std::size_t record_size = sizeof(record);
+
+  // offsets of the header fields, as the trampolines address them
+  static constexpr std::size_t head_offset = 0;
+  static constexpr std::size_t tail_offset = 8;
+  static constexpr std::size_t dropped_offset = 16;
+
+  // maps size_for(capacity) bytes of fd; capacity must be a power of two
+  trace_buffer(int fd, std::size_t capacity);
+  trace_buffer(const trace_buffer&) = delete;
+  trace_buffer& operator=(const trace_buffer&) = delete;
+  ~trace_buffer();
+
+  static std::size_t size_for(std::size_t capacity) {
+    return header_size + capacity * record_size;
+  }
+  std::size_t capacity() const { return capacity_; }
+
+  // calls f with each published record in order; returns how many there were
+  template <class F>
+  std::size_t drain(F f) {
+    std::size_t n = 0;
+    auto tail = __atomic_load_n(header(tail_offset), __ATOMIC_RELAXED);
+    for (;; ++tail, ++n) {
+      auto& rec = records_[tail & (capacity_ - 1)];
+      if (__atomic_load_n(&rec.sequence, __ATOMIC_ACQUIRE) != tail + 1) break;
+      f(static_cast<const record&>(rec));
+    }
+    // hands the slots back to the producers
+    __atomic_store_n(header(tail_offset), tail, __ATOMIC_RELEASE);
+    return n;
+  }
+
+  // records lost to a full buffer
+  std::uint64_t dropped() const {
+    return __atomic_load_n(header(dropped_offset), __ATOMIC_RELAXED);
+  }
+
+ private:
+  std::uint64_t* header(std::size_t offset) const {
+    return reinterpret_cast<std::uint64_t*>(static_cast<char*>(mapping_) + offset);
+  }
+
+  void* mapping_;
+  std::size_t capacity_;
+  record* records_;
+};
+}  // namespace xdb
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef XDB_TRACEPOINT_HPP
+#define XDB_TRACEPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "libxdb/register_info.hpp"
+#include "libxdb/types.hpp"
+
+namespace xdb {
+class process;
+
+// A value a tracepoint records: a 64-bit general purpose register, rip or
+// eflags, or the qword at that register plus deref
+struct trace_field {
+  register_id reg;
+  std::optional<std::int32_t> deref;
+};
+
+// A fast tracepoint never stops the inferior. Enabling it replaces the
+// instructions at its address with a jmp to a trampoline that appends a
+// record to the process's trace_buffer, runs relocated copies of those
+// instructions and jumps back. The instructions it covers must add up to five
+// bytes without a block-ending one before the last, and nothing may jump into
+// their middle.
+class tracepoint {
+ public:
+  tracepoint() = delete;
+  tracepoint(const tracepoint&) = delete;
+  tracepoint& operator=(const tracepoint&) = delete;
+
+  using id_t = std::int32_t;
+  id_t id() const {
+    return id_;
+  }
+
+  void enable();
+  void disable();
+
+  bool is_enabled() const {
+    return is_enabled_;
+  }
+  virt_addr address() const {
+    return address_;
+  }
+  const std::vector<trace_field>& fields() const {
+    return fields_;
+  }
+  bool at_address(virt_addr addr) const {
+    return address_ == addr;
+  }
+  bool in_range(virt_addr start, virt_addr end) const {
+    return address_ >= start && address_ < end;
+  }
+  // the bytes the jump overwrites, known once it has been enabled
+  std::size_t patch_size() const {
+    return original_code_.size();
+  }
+
+ private:
+  tracepoint(process& proc, virt_addr address, std::vector<trace_field> fields);
+  friend xdb::process;
+
+  id_t id_;
+  process& process_;
+  virt_addr address_;
+  std::vector<trace_field> fields_;
+  bool is_enabled_ = false;
+  std::optional<virt_addr> trampoline_;
+  std::vector<std::byte> original_code_;
+};
+}  // namespace xdb
+
+#endif
@@ -2,10 +2,13 @@
 #define XDB_TYPES_HPP
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <variant>
 
 namespace xdb {
+  inline constexpr std::size_t page_size = 0x1000;
+
   using byte64 = std::array<std::byte, 8>;
   using byte128 = std::array<std::byte, 16>;
 
@@ -15,6 +18,12 @@ namespace xdb {
     float, double, long double,
     byte64, byte128>;
 
+  enum class stoppoint_mode {
+    write,
+    read_write,
+    execute
+  };
+
   // Stand for virtual address
   class virt_addr {
    public:
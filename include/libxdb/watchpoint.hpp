@@ -0,0 +1,69 @@
+#ifndef XDB_WATCHPOINT_HPP
+#define XDB_WATCHPOINT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libxdb/types.hpp"
+
+namespace xdb {
+class process;
+class watchpoint {
+ public:
+  watchpoint() = delete;
+  watchpoint(const watchpoint&) = delete;
+  watchpoint& operator=(const watchpoint&) = delete;
+
+  using id_t = std::int32_t;
+  id_t id() const {
+    return id_;
+  }
+
+  void enable();
+  void disable();
+
+  bool is_enabled() const {
+    return is_enabled_;
+  }
+  virt_addr address() const {
+    return address_;
+  }
+  stoppoint_mode mode() const {
+    return mode_;
+  }
+  std::size_t size() const {
+    return size_;
+  }
+  bool at_address(virt_addr addr) const {
+    return address_ == addr;
+  }
+  bool in_range(virt_addr start, virt_addr end) const {
+    return address_ >= start && address_ < end;
+  }
+
+  // the watched value at the last hit, and before it
+  std::uint64_t data() const {
+    return data_;
+  }
+  std::uint64_t previous_data() const {
+    return previous_data_;
+  }
+  void update_data();
+
+ private:
+  watchpoint(process& proc, virt_addr address, stoppoint_mode mode, std::size_t size);
+  friend xdb::process;
+
+  id_t id_;
+  process& process_;
+  virt_addr address_;
+  stoppoint_mode mode_;
+  std::size_t size_;
+  bool is_enabled_ = false;
+  int hardware_register_index_ = -1;
+  std::uint64_t data_ = 0;
+  std::uint64_t previous_data_ = 0;
+};
+}  // namespace xdb
+
+#endif
@@ -7,15 +7,23 @@ namespace xdb {
     return ++id;
   }
 
-  void breakpoint_site::enable() {
+  // internal sites count down from the top, so user ids stay dense
+  auto get_next_internal_id() {
+    static breakpoint_site::id_t id = 0;
+    return --id;
+  }
 
+  void breakpoint_site::enable() {
+    if (is_enabled_) return;
+    proc_.enable_breakpoint_sites({ this });
   }
 
   void breakpoint_site::disable() {
-
+    if (!is_enabled_) return;
+    proc_.disable_breakpoint_sites({ this });
   }
 
-  breakpoint_site::breakpoint_site(process& proc, virt_addr addr) : id_(get_next_id()), addr_(addr), proc_(proc) {}
+  breakpoint_site::breakpoint_site(process& proc, virt_addr addr, bool is_hardware, bool is_internal)
+    : id_(is_internal ? get_next_internal_id() : get_next_id()), is_hardware_(is_hardware),
+      is_internal_(is_internal), addr_(addr), proc_(proc) {}
 }
-void enable();
-void disable();
@@ -0,0 +1,852 @@
+#include <algorithm>
+#include <cstring>
+#include <libxdb/dwarf.hpp>
+#include <libxdb/error.hpp>
+
+namespace {
+  [[noreturn]] void malformed(const std::string& what) {
+    xdb::error::send("Malformed DWARF: " + what);
+  }
+
+  // Reads the fixed-size, LEB128 and string fields of a DWARF section,
+  // throwing rather than reading past its end
+  class cursor {
+   public:
+    explicit cursor(xdb::span<std::byte> data, std::uint64_t offset = 0) : data_(data) { seek(offset); }
+
+    std::uint64_t offset() const { return pos_ - data_.begin(); }
+    void seek(std::uint64_t offset) {
+      if (offset > data_.size()) malformed("offset past the end of a section");
+      pos_ = data_.begin() + offset;
+    }
+    bool finished() const { return pos_ >= data_.end(); }
+    void skip(std::uint64_t n) {
+      need(n);
+      pos_ += n;
+    }
+
+    // a little-endian value of n bytes
+    std::uint64_t fixed(std::size_t n) {
+      need(n);
+      std::uint64_t value = 0;
+      std::memcpy(&value, pos_, n);
+      pos_ += n;
+      return value;
+    }
+    std::uint8_t u8() { return static_cast<std::uint8_t>(fixed(1)); }
+    std::uint16_t u16() { return static_cast<std::uint16_t>(fixed(2)); }
+    std::uint32_t u32() { return static_cast<std::uint32_t>(fixed(4)); }
+    std::uint64_t u64() { return fixed(8); }
+    // a section offset, 8 bytes in the 64-bit format
+    std::uint64_t offset_field(bool is_64bit) { return fixed(is_64bit ? 8 : 4); }
+
+    std::uint64_t uleb128() {
+      std::uint64_t value = 0;
+      int shift = 0;
+      std::uint8_t byte;
+      do {
+        byte = u8();
+        if (shift < 64) value |= std::uint64_t{ byte & 0x7fu } << shift;
+        shift += 7;
+      } while (byte & 0x80);
+      return value;
+    }
+    std::int64_t sleb128() {
+      std::uint64_t value = 0;
+      int shift = 0;
+      std::uint8_t byte;
+      do {
+        byte = u8();
+        if (shift < 64) value |= std::uint64_t{ byte & 0x7fu } << shift;
+        shift += 7;
+      } while (byte & 0x80);
+      if (shift < 64 && (byte & 0x40)) value |= ~std::uint64_t{ 0 } << shift;
+      return static_cast<std::int64_t>(value);
+    }
+
+    std::string_view string() {
+      auto start = reinterpret_cast<const char*>(pos_);
+      auto left = static_cast<std::size_t>(data_.end() - pos_);
+      auto length = strnlen(start, left);
+      if (length == left) malformed("unterminated string");
+      pos_ += length + 1;
+      return { start, length };
+    }
+
+    // a unit's length, which also says whether it uses the 64-bit format
+    std::uint64_t initial_length(bool& is_64bit) {
+      auto length = u32();
+      is_64bit = length == 0xffffffff;
+      return is_64bit ? u64() : length;
+    }
+
+   private:
+    void need(std::uint64_t n) {
+      if (n > static_cast<std::uint64_t>(data_.end() - pos_)) malformed("read past the end of a section");
+    }
+
+    xdb::span<std::byte> data_;
+    const std::byte* pos_;
+  };
+
+  std::string_view string_at(xdb::span<std::byte> section, std::uint64_t offset) {
+    if (offset >= section.size()) malformed("string offset past the end of its section");
+    cursor cur(section, offset);
+    return cur.string();
+  }
+
+  bool is_function(const xdb::die& entry) {
+    return entry.tag == DW_TAG_subprogram || entry.tag == DW_TAG_inlined_subroutine;
+  }
+}
+
+bool xdb::die::contains_address(std::uint64_t file_address) const {
+  if (n_ranges > 0) {
+    return std::any_of(ranges, ranges + n_ranges,
+                       [&](auto& range) { return file_address >= range.low && file_address < range.high; });
+  }
+  return file_address >= low_pc && file_address < high_pc;
+}
+
+namespace xdb {
+// Decodes one unit: attribute values in the unit's forms, its first entry,
+// its entries and its line program
+class unit_reader {
+ public:
+  explicit unit_reader(const compile_unit& unit) : unit_(unit), dwarf_(*unit.parent_) {}
+
+  // an attribute as its form encodes it: a number, which for the index
+  // forms still has to be looked up, or a string
+  struct value {
+    std::uint64_t form;
+    std::uint64_t number;
+    std::string_view string;
+  };
+
+  value read(cursor& cur, std::uint64_t form, std::int64_t implicit_const) {
+    value v{ form, 0, {} };
+    switch (form) {
+      case DW_FORM_addr: v.number = cur.fixed(unit_.address_size_); break;
+      case DW_FORM_block1: cur.skip(cur.u8()); break;
+      case DW_FORM_block2: cur.skip(cur.u16()); break;
+      case DW_FORM_block4: cur.skip(cur.u32()); break;
+      case DW_FORM_block:
+      case DW_FORM_exprloc: cur.skip(cur.uleb128()); break;
+      case DW_FORM_data1:
+      case DW_FORM_ref1:
+      case DW_FORM_flag:
+      case DW_FORM_strx1:
+      case DW_FORM_addrx1: v.number = cur.u8(); break;
+      case DW_FORM_data2:
+      case DW_FORM_ref2:
+      case DW_FORM_strx2:
+      case DW_FORM_addrx2: v.number = cur.u16(); break;
+      case DW_FORM_strx3:
+      case DW_FORM_addrx3: v.number = cur.fixed(3); break;
+      case DW_FORM_data4:
+      case DW_FORM_ref4:
+      case DW_FORM_ref_sup4:
+      case DW_FORM_strx4:
+      case DW_FORM_addrx4: v.number = cur.u32(); break;
+      case DW_FORM_data8:
+      case DW_FORM_ref8:
+      case DW_FORM_ref_sig8:
+      case DW_FORM_ref_sup8: v.number = cur.u64(); break;
+      case DW_FORM_data16: cur.skip(16); break;
+      case DW_FORM_string: v.string = cur.string(); break;
+      case DW_FORM_sdata: v.number = static_cast<std::uint64_t>(cur.sleb128()); break;
+      case DW_FORM_udata:
+      case DW_FORM_ref_udata:
+      case DW_FORM_strx:
+      case DW_FORM_addrx:
+      case DW_FORM_loclistx:
+      case DW_FORM_rnglistx:
+      case DW_FORM_GNU_addr_index:
+      case DW_FORM_GNU_str_index: v.number = cur.uleb128(); break;
+      case DW_FORM_strp: v.string = string_at(dwarf_.str_, cur.offset_field(unit_.is_64bit_)); break;
+      case DW_FORM_line_strp: v.string = string_at(dwarf_.line_str_, cur.offset_field(unit_.is_64bit_)); break;
+      // in a supplementary file we don't have
+      case DW_FORM_strp_sup:
+      case DW_FORM_GNU_strp_alt:
+      case DW_FORM_GNU_ref_alt:
+      case DW_FORM_sec_offset: v.number = cur.offset_field(unit_.is_64bit_); break;
+      case DW_FORM_ref_addr:
+        v.number = unit_.version_ <= 2 ? cur.fixed(unit_.address_size_) : cur.offset_field(unit_.is_64bit_);
+        break;
+      case DW_FORM_flag_present: v.number = 1; break;
+      case DW_FORM_implicit_const: v.number = static_cast<std::uint64_t>(implicit_const); break;
+      case DW_FORM_indirect: return read(cur, cur.uleb128(), implicit_const);
+      default: malformed("unknown attribute form " + std::to_string(form));
+    }
+    return v;
+  }
+
+  std::string_view string(const value& v) {
+    switch (v.form) {
+      case DW_FORM_strx:
+      case DW_FORM_strx1:
+      case DW_FORM_strx2:
+      case DW_FORM_strx3:
+      case DW_FORM_strx4:
+      case DW_FORM_GNU_str_index: {
+        auto size = unit_.is_64bit_ ? 8 : 4;
+        cursor cur(dwarf_.str_offsets_, unit_.str_offsets_base_ + v.number * size);
+        return string_at(dwarf_.str_, cur.offset_field(unit_.is_64bit_));
+      }
+      default: return v.string;
+    }
+  }
+
+  std::uint64_t address_at_index(std::uint64_t index) {
+    cursor cur(dwarf_.addr_, unit_.addr_base_ + index * unit_.address_size_);
+    return cur.fixed(unit_.address_size_);
+  }
+
+  std::uint64_t address(const value& v) {
+    switch (v.form) {
+      case DW_FORM_addrx:
+      case DW_FORM_addrx1:
+      case DW_FORM_addrx2:
+      case DW_FORM_addrx3:
+      case DW_FORM_addrx4:
+      case DW_FORM_GNU_addr_index: return address_at_index(v.number);
+      default: return v.number;
+    }
+  }
+
+  // a high_pc is an address, or in DWARF 4 and on may be the size
+  std::uint64_t high_pc(const value& v, std::uint64_t low_pc) {
+    switch (v.form) {
+      case DW_FORM_addr:
+      case DW_FORM_addrx:
+      case DW_FORM_addrx1:
+      case DW_FORM_addrx2:
+      case DW_FORM_addrx3:
+      case DW_FORM_addrx4:
+      case DW_FORM_GNU_addr_index: return address(v);
+      default: return low_pc + v.number;
+    }
+  }
+
+  // the .debug_info offset a reference points at; 0 for one into another file
+  std::uint64_t reference(const value& v) {
+    switch (v.form) {
+      case DW_FORM_ref1:
+      case DW_FORM_ref2:
+      case DW_FORM_ref4:
+      case DW_FORM_ref8:
+      case DW_FORM_ref_udata: return unit_.offset_ + v.number;
+      case DW_FORM_ref_addr: return v.number;
+      default: return 0;
+    }
+  }
+
+  /// DWARF 5 range lists are a series of DW_RLE entries in .debug_rnglists,
+  /// found through the unit's offset table for DW_FORM_rnglistx; earlier
+  /// versions have pairs of addresses in .debug_ranges, where a pair whose
+  /// first is all ones sets the base address.
+  std::vector<address_range> ranges(const value& v, std::uint64_t base) {
+    std::vector<address_range> out;
+    auto add = [&](std::uint64_t low, std::uint64_t high) {
+      if (low < high) out.push_back({ low, high });
+    };
+    if (unit_.version_ < 5) {
+      cursor cur(dwarf_.ranges_, v.number);
+      auto all_ones = unit_.address_size_ == 8 ? ~std::uint64_t{ 0 } : 0xffffffffu;
+      for (;;) {
+        auto start = cur.fixed(unit_.address_size_);
+        auto end = cur.fixed(unit_.address_size_);
+        if (start == 0 && end == 0) break;
+        if (start == all_ones) {
+          base = end;
+        } else {
+          add(base + start, base + end);
+        }
+      }
+      return out;
+    }
+
+    auto offset = v.number;
+    if (v.form == DW_FORM_rnglistx) {
+      auto size = unit_.is_64bit_ ? 8 : 4;
+      cursor table(dwarf_.rnglists_, unit_.rnglists_base_ + v.number * size);
+      offset = unit_.rnglists_base_ + table.offset_field(unit_.is_64bit_);
+    }
+    cursor cur(dwarf_.rnglists_, offset);
+    for (;;) {
+      switch (cur.u8()) {
+        case DW_RLE_end_of_list: return out;
+        case DW_RLE_base_addressx: base = address_at_index(cur.uleb128()); break;
+        case DW_RLE_startx_endx: {
+          auto start = address_at_index(cur.uleb128());
+          add(start, address_at_index(cur.uleb128()));
+          break;
+        }
+        case DW_RLE_startx_length: {
+          auto start = address_at_index(cur.uleb128());
+          add(start, start + cur.uleb128());
+          break;
+        }
+        case DW_RLE_offset_pair: {
+          auto start = cur.uleb128();
+          add(base + start, base + cur.uleb128());
+          break;
+        }
+        case DW_RLE_base_address: base = cur.fixed(unit_.address_size_); break;
+        case DW_RLE_start_end: {
+          auto start = cur.fixed(unit_.address_size_);
+          add(start, cur.fixed(unit_.address_size_));
+          break;
+        }
+        case DW_RLE_start_length: {
+          auto start = cur.fixed(unit_.address_size_);
+          add(start, start + cur.uleb128());
+          break;
+        }
+        default: malformed("unknown range list entry");
+      }
+    }
+  }
+
+  const dwarf::abbrev& abbrev_for(const std::vector<dwarf::abbrev>& table, std::uint64_t code) {
+    if (code >= table.size() || !table[code].specs) malformed("unknown abbreviation code " + std::to_string(code));
+    return table[code];
+  }
+
+  /// The bases the index forms go through are attributes of this same
+  /// entry, so every value is read before any is looked up.
+  compile_unit::unit_info read_info() {
+    compile_unit::unit_info info;
+    cursor cur(unit_span(), unit_.first_die_);
+    auto code = cur.uleb128();
+    if (code == 0) return info;
+    auto& table = dwarf_.abbrev_table(unit_.abbrev_offset_);
+    auto& abbrev = abbrev_for(table, code);
+    std::optional<value> name, comp_dir, low_value, high_value, ranges_value;
+    for (std::size_t i = 0; i < abbrev.n_specs; ++i) {
+      auto& spec = abbrev.specs[i];
+      auto v = read(cur, spec.form, spec.implicit_const);
+      switch (spec.attribute) {
+        case DW_AT_name: name = v; break;
+        case DW_AT_comp_dir: comp_dir = v; break;
+        case DW_AT_stmt_list: info.stmt_list = v.number; break;
+        case DW_AT_low_pc: low_value = v; break;
+        case DW_AT_high_pc: high_value = v; break;
+        case DW_AT_ranges: ranges_value = v; break;
+        case DW_AT_str_offsets_base: unit_.str_offsets_base_ = v.number; break;
+        case DW_AT_addr_base:
+        case DW_AT_GNU_addr_base: unit_.addr_base_ = v.number; break;
+        case DW_AT_rnglists_base: unit_.rnglists_base_ = v.number; break;
+      }
+    }
+    if (name) info.name = string(*name);
+    if (comp_dir) info.comp_dir = string(*comp_dir);
+    if (low_value) info.low_pc = address(*low_value);
+    if (high_value) info.high_pc = high_pc(*high_value, info.low_pc);
+    if (ranges_value) info.ranges = ranges(*ranges_value, info.low_pc);
+    return info;
+  }
+
+  /// Entries are made in the arena in the order they come, which is offset
+  /// order, so the array of them the unit keeps can be binary searched.
+  void read_dies() {
+    auto& info = unit_.info();
+    auto& table = dwarf_.abbrev_table(unit_.abbrev_offset_);
+    auto& arena = dwarf_.arena_;
+    cursor cur(unit_span(), unit_.first_die_);
+
+    struct open_parent {
+      die* parent;
+      die* last_child;
+    };
+    std::vector<open_parent> open;
+    std::vector<const die*> all;
+    std::vector<std::pair<die*, std::uint64_t>> specifications;
+    die* root = nullptr;
+    while (!cur.finished()) {
+      auto offset = cur.offset();
+      auto code = cur.uleb128();
+      if (code == 0) {
+        // the end of a list of siblings
+        if (!open.empty()) open.pop_back();
+        continue;
+      }
+      auto& abbrev = abbrev_for(table, code);
+      auto entry = arena.make<die>();
+      entry->offset = offset;
+      entry->tag = abbrev.tag;
+      std::optional<value> low_value, high_value, ranges_value;
+      for (std::size_t i = 0; i < abbrev.n_specs; ++i) {
+        auto& spec = abbrev.specs[i];
+        auto v = read(cur, spec.form, spec.implicit_const);
+        switch (spec.attribute) {
+          case DW_AT_name: entry->name = string(v); break;
+          case DW_AT_linkage_name:
+          case DW_AT_MIPS_linkage_name: entry->linkage_name = string(v); break;
+          case DW_AT_low_pc: low_value = v; break;
+          case DW_AT_high_pc: high_value = v; break;
+          case DW_AT_ranges: ranges_value = v; break;
+          case DW_AT_specification:
+          case DW_AT_abstract_origin:
+            if (auto target = reference(v)) specifications.emplace_back(entry, target);
+            break;
+        }
+      }
+      if (low_value) entry->low_pc = address(*low_value);
+      if (high_value) entry->high_pc = high_pc(*high_value, entry->low_pc);
+      if (ranges_value) {
+        auto found = ranges(*ranges_value, info.low_pc);
+        entry->ranges = arena.copy(found);
+        entry->n_ranges = found.size();
+      }
+
+      if (open.empty()) {
+        // a unit has one top-level entry
+        if (root) break;
+        root = entry;
+      } else {
+        auto& [parent, last_child] = open.back();
+        entry->parent = parent;
+        if (last_child) {
+          last_child->next_sibling = entry;
+        } else {
+          parent->first_child = entry;
+        }
+        last_child = entry;
+      }
+      all.push_back(entry);
+      if (abbrev.has_children) open.push_back({ entry, nullptr });
+    }
+    if (!root) root = arena.make<die>();
+
+    unit_.dies_by_offset_ = arena.copy(all);
+    unit_.n_dies_ = all.size();
+    // a definition or an inlined copy goes by its declaration's name
+    for (auto [entry, target] : specifications) entry->specification = unit_.die_at_offset(target);
+    for (auto [entry, target] : specifications) {
+      // a few hops at most, so a malformed cycle can't hang us
+      int hops = 0;
+      for (auto from = entry->specification; from && hops < 8; from = from->specification, ++hops) {
+        if (entry->name.empty()) entry->name = from->name;
+        if (entry->linkage_name.empty()) entry->linkage_name = from->linkage_name;
+      }
+    }
+    unit_.dies_ = root;
+  }
+
+  /// Before DWARF 5 the header lists directories and then files as strings
+  /// ended by an empty one, with directory 0 the unit's own and file 0 its
+  /// source; from 5 on, each list says first which fields and forms its
+  /// entries have.
+  const line_table* read_line_table(bool decode_rows) {
+    auto& info = unit_.info();
+    auto& arena = dwarf_.arena_;
+    auto table = arena.make<line_table>();
+    if (!info.stmt_list) return table;
+
+    cursor cur(dwarf_.line_, *info.stmt_list);
+    bool is_64bit;
+    auto length = cur.initial_length(is_64bit);
+    auto end = cur.offset() + length;
+    table->version = cur.u16();
+    if (table->version < 2 || table->version > 5) malformed("unknown line table version");
+    auto address_size = unit_.address_size_;
+    if (table->version >= 5) {
+      address_size = cur.u8();
+      cur.u8();  // segment selector size
+    }
+    auto header_length = cur.offset_field(is_64bit);
+    auto program_start = cur.offset() + header_length;
+    auto min_instruction_length = cur.u8();
+    if (table->version >= 4) cur.u8();  // maximum operations per instruction
+    bool default_is_stmt = cur.u8() != 0;
+    auto line_base = static_cast<std::int8_t>(cur.u8());
+    auto line_range = cur.u8();
+    auto opcode_base = cur.u8();
+    if (line_range == 0) malformed("line table with a line range of 0");
+    std::vector<std::uint8_t> opcode_lengths;
+    for (int i = 1; i < opcode_base; ++i) opcode_lengths.push_back(cur.u8());
+
+    std::vector<std::string_view> directories;
+    std::vector<line_table::file> files;
+    if (table->version >= 5) {
+      auto read_formats = [&] {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> formats(cur.u8());
+        for (auto& [content, form] : formats) {
+          content = cur.uleb128();
+          form = cur.uleb128();
+        }
+        return formats;
+      };
+      auto directory_formats = read_formats();
+      for (auto n = cur.uleb128(); n > 0; --n) {
+        std::string_view path;
+        for (auto [content, form] : directory_formats) {
+          auto v = read(cur, form, 0);
+          if (content == DW_LNCT_path) path = string(v);
+        }
+        directories.push_back(path);
+      }
+      auto file_formats = read_formats();
+      for (auto n = cur.uleb128(); n > 0; --n) {
+        line_table::file file{};
+        for (auto [content, form] : file_formats) {
+          auto v = read(cur, form, 0);
+          if (content == DW_LNCT_path) file.name = string(v);
+          if (content == DW_LNCT_directory_index) file.directory = v.number;
+        }
+        files.push_back(file);
+      }
+    } else {
+      directories.push_back(info.comp_dir);
+      for (auto dir = cur.string(); !dir.empty(); dir = cur.string()) directories.push_back(dir);
+      files.push_back({ info.name, 0 });
+      for (auto name = cur.string(); !name.empty(); name = cur.string()) {
+        auto directory = cur.uleb128();
+        cur.uleb128();  // modification time
+        cur.uleb128();  // size
+        files.push_back({ name, directory });
+      }
+    }
+
+    std::vector<line_row> rows;
+    if (decode_rows) {
+      cur.seek(program_start);
+      // [first, last] rows of each finished sequence
+      std::vector<std::pair<std::size_t, std::size_t>> sequences;
+      std::size_t sequence_start = 0;
+      line_row state{};
+      auto reset = [&] { state = line_row{ 0, 1, 1, 0, default_is_stmt, false }; };
+      reset();
+      while (cur.offset() < end) {
+        auto opcode = cur.u8();
+        if (opcode >= opcode_base) {
+          auto adjusted = opcode - opcode_base;
+          state.address += (adjusted / line_range) * min_instruction_length;
+          state.line += line_base + adjusted % line_range;
+          rows.push_back(state);
+        } else if (opcode == 0) {
+          auto length = cur.uleb128();
+          auto next = cur.offset() + length;
+          switch (cur.u8()) {
+            case DW_LNE_end_sequence:
+              state.end_sequence = true;
+              rows.push_back(state);
+              sequences.emplace_back(sequence_start, rows.size() - 1);
+              sequence_start = rows.size();
+              reset();
+              break;
+            case DW_LNE_set_address: state.address = cur.fixed(length > 1 ? length - 1 : address_size); break;
+            case DW_LNE_define_file: {
+              auto name = cur.string();
+              files.push_back({ name, cur.uleb128() });
+              break;
+            }
+          }
+          cur.seek(next);
+        } else {
+          switch (opcode) {
+            case DW_LNS_copy: rows.push_back(state); break;
+            case DW_LNS_advance_pc: state.address += cur.uleb128() * min_instruction_length; break;
+            case DW_LNS_advance_line: state.line += static_cast<std::uint32_t>(cur.sleb128()); break;
+            case DW_LNS_set_file: state.file = static_cast<std::uint32_t>(cur.uleb128()); break;
+            case DW_LNS_set_column: state.column = static_cast<std::uint16_t>(cur.uleb128()); break;
+            case DW_LNS_negate_stmt: state.is_stmt = !state.is_stmt; break;
+            case DW_LNS_const_add_pc: state.address += ((255 - opcode_base) / line_range) * min_instruction_length; break;
+            case DW_LNS_fixed_advance_pc: state.address += cur.u16(); break;
+            case DW_LNS_set_basic_block:
+            case DW_LNS_set_prologue_end:
+            case DW_LNS_set_epilogue_begin: break;
+            default:
+              for (auto n = opcode_lengths[opcode - 1]; n > 0; --n) cur.uleb128();
+          }
+        }
+      }
+
+      // code the linker threw away is left at address 0
+      sequences.erase(std::remove_if(sequences.begin(), sequences.end(),
+                                     [&](auto& sequence) { return rows[sequence.first].address == 0; }),
+                      sequences.end());
+      std::sort(sequences.begin(), sequences.end(),
+                [&](auto& a, auto& b) { return rows[a.first].address < rows[b.first].address; });
+      std::vector<line_row> ordered;
+      ordered.reserve(rows.size());
+      for (auto [first, last] : sequences) ordered.insert(ordered.end(), rows.begin() + first, rows.begin() + last + 1);
+      rows = std::move(ordered);
+    }
+
+    table->directories = { arena.copy(directories), directories.size() };
+    table->files = { arena.copy(files), files.size() };
+    table->rows = { arena.copy(rows), rows.size() };
+    return table;
+  }
+
+ private:
+  // .debug_info up to the end of the unit
+  span<std::byte> unit_span() const { return { dwarf_.info_.data(), unit_.end_ }; }
+
+  const compile_unit& unit_;
+  const dwarf& dwarf_;
+};
+}  // namespace xdb
+
+const xdb::compile_unit::unit_info& xdb::compile_unit::info() const {
+  if (!info_) info_ = unit_reader(*this).read_info();
+  return *info_;
+}
+
+const xdb::die& xdb::compile_unit::root() const {
+  if (!dies_) unit_reader(*this).read_dies();
+  return *dies_;
+}
+
+const xdb::die* xdb::compile_unit::die_at_offset(std::uint64_t offset) const {
+  auto begin = dies_by_offset_;
+  auto end = dies_by_offset_ + n_dies_;
+  auto it = std::lower_bound(begin, end, offset, [](auto entry, auto offset) { return entry->offset < offset; });
+  return it != end && (*it)->offset == offset ? *it : nullptr;
+}
+
+const xdb::line_table& xdb::compile_unit::line_header() const {
+  if (!lines_) lines_ = unit_reader(*this).read_line_table(false);
+  return *lines_;
+}
+
+const xdb::line_table& xdb::compile_unit::lines() const {
+  if (!lines_decoded_) {
+    lines_ = unit_reader(*this).read_line_table(true);
+    lines_decoded_ = true;
+  }
+  return *lines_;
+}
+
+std::filesystem::path xdb::compile_unit::file_path(const line_table& table, std::uint32_t index) const {
+  if (index >= table.files.size()) return {};
+  auto& file = table.files[index];
+  std::filesystem::path path(file.name);
+  if (path.is_relative() && file.directory < table.directories.size()) {
+    path = std::filesystem::path(table.directories[file.directory]) / path;
+  }
+  if (path.is_relative()) path = std::filesystem::path(comp_dir()) / path;
+  return path;
+}
+
+/// Only the unit headers are read here, a few bytes each, plus the first
+/// entry of the units .debug_aranges leaves out.
+xdb::dwarf::dwarf(const elf& file, bool use_aranges) : elf_(&file) {
+  info_ = file.section_contents(".debug_info");
+  abbrev_ = file.section_contents(".debug_abbrev");
+  str_ = file.section_contents(".debug_str");
+  line_str_ = file.section_contents(".debug_line_str");
+  line_ = file.section_contents(".debug_line");
+  str_offsets_ = file.section_contents(".debug_str_offsets");
+  addr_ = file.section_contents(".debug_addr");
+  ranges_ = file.section_contents(".debug_ranges");
+  rnglists_ = file.section_contents(".debug_rnglists");
+
+  cursor cur(info_);
+  while (!cur.finished()) {
+    auto offset = cur.offset();
+    bool is_64bit;
+    auto length = cur.initial_length(is_64bit);
+    auto end = cur.offset() + length;
+    if (end > info_.size()) malformed("unit runs past the end of .debug_info");
+    std::unique_ptr<compile_unit> unit(new compile_unit(*this, offset));
+    unit->is_64bit_ = is_64bit;
+    unit->end_ = end;
+    unit->version_ = cur.u16();
+    std::uint8_t unit_type = DW_UT_compile;
+    if (unit->version_ >= 5) {
+      unit_type = cur.u8();
+      unit->address_size_ = cur.u8();
+      unit->abbrev_offset_ = cur.offset_field(is_64bit);
+      if (unit_type == DW_UT_skeleton || unit_type == DW_UT_split_compile) {
+        cur.skip(8);
+      } else if (unit_type == DW_UT_type || unit_type == DW_UT_split_type) {
+        cur.skip(8 + (is_64bit ? 8 : 4));
+      }
+    } else {
+      unit->abbrev_offset_ = cur.offset_field(is_64bit);
+      unit->address_size_ = cur.u8();
+    }
+    unit->first_die_ = cur.offset();
+    cur.seek(end);
+    // type units have no code
+    if (unit->version_ < 2 || unit->version_ > 5 || unit_type == DW_UT_type || unit_type == DW_UT_split_type) {
+      continue;
+    }
+    units_.push_back(std::move(unit));
+  }
+
+  auto unit_index = [&](std::uint64_t offset) -> std::optional<std::size_t> {
+    auto it = std::lower_bound(units_.begin(), units_.end(), offset,
+                               [](auto& unit, auto offset) { return unit->offset() < offset; });
+    if (it == units_.end() || (*it)->offset() != offset) return std::nullopt;
+    return it - units_.begin();
+  };
+  std::vector<bool> covered(units_.size());
+  cursor sets(use_aranges ? file.section_contents(".debug_aranges") : span<std::byte>{});
+  while (!sets.finished()) {
+    auto set_start = sets.offset();
+    bool is_64bit;
+    auto length = sets.initial_length(is_64bit);
+    auto end = sets.offset() + length;
+    sets.u16();  // version
+    auto index = unit_index(sets.offset_field(is_64bit));
+    auto address_size = sets.u8();
+    auto segment_size = sets.u8();
+    // the tuples start at a multiple of their own size
+    auto tuple_size = 2 * address_size + segment_size;
+    if (tuple_size == 0) malformed("address range set with no address size");
+    sets.skip((tuple_size - (sets.offset() - set_start) % tuple_size) % tuple_size);
+    while (index && sets.offset() + tuple_size <= end) {
+      sets.skip(segment_size);
+      auto address = sets.fixed(address_size);
+      auto size = sets.fixed(address_size);
+      if (address == 0 && size == 0) break;
+      if (size == 0) continue;
+      index_.push_back({ address, address + size, units_[*index].get() });
+      covered[*index] = true;
+    }
+    sets.seek(end);
+  }
+
+  for (std::size_t i = 0; i < units_.size(); ++i) {
+    if (covered[i]) continue;
+    auto unit = units_[i].get();
+    auto& info = unit->info();
+    for (auto& range : info.ranges) index_.push_back({ range.low, range.high, unit });
+    if (info.ranges.empty() && info.low_pc < info.high_pc) index_.push_back({ info.low_pc, info.high_pc, unit });
+  }
+  std::sort(index_.begin(), index_.end(), [](auto& a, auto& b) { return a.low < b.low; });
+}
+
+/// Each abbreviation is a code, a tag, a children flag and a list of
+/// (attribute, form) pairs ended by two zeros; codes are small and dense in
+/// practice, so the table is a vector indexed by them.
+const std::vector<xdb::dwarf::abbrev>& xdb::dwarf::abbrev_table(std::uint64_t offset) const {
+  if (auto it = abbrev_tables_.find(offset); it != abbrev_tables_.end()) return it->second;
+
+  std::vector<abbrev> table;
+  std::vector<attribute_spec> specs;
+  cursor cur(abbrev_, offset);
+  for (auto code = cur.uleb128(); code != 0; code = cur.uleb128()) {
+    if (code >= (1u << 20)) malformed("abbreviation code too large");
+    abbrev entry{};
+    entry.tag = cur.uleb128();
+    entry.has_children = cur.u8() != 0;
+    specs.clear();
+    for (;;) {
+      auto attribute = cur.uleb128();
+      auto form = cur.uleb128();
+      if (attribute == 0 && form == 0) break;
+      std::int64_t implicit_const = form == DW_FORM_implicit_const ? cur.sleb128() : 0;
+      specs.push_back({ attribute, form, implicit_const });
+    }
+    // an abbreviation with no attributes still needs a non-null list
+    entry.specs = specs.empty() ? arena_.make<attribute_spec>() : arena_.copy(specs);
+    entry.n_specs = specs.size();
+    if (code >= table.size()) table.resize(code + 1);
+    table[code] = entry;
+  }
+  return abbrev_tables_.emplace(offset, std::move(table)).first->second;
+}
+
+const xdb::compile_unit* xdb::dwarf::compile_unit_containing_address(virt_addr address) const {
+  auto file_address = address.addr() - elf_->load_bias();
+  auto it = std::upper_bound(index_.begin(), index_.end(), file_address,
+                             [](auto address, auto& range) { return address < range.low; });
+  if (it == index_.begin()) return nullptr;
+  --it;
+  return file_address < it->high ? it->unit : nullptr;
+}
+
+const xdb::die* xdb::dwarf::function_containing_address(virt_addr address) const {
+  auto unit = compile_unit_containing_address(address);
+  if (!unit) return nullptr;
+  auto file_address = address.addr() - elf_->load_bias();
+
+  const die* found = nullptr;
+  // descend into each child whose code holds the address, or which has no
+  // code of its own to say, such as a namespace
+  std::vector<const die*> pending{ &unit->root() };
+  while (!pending.empty()) {
+    auto entry = pending.back();
+    pending.pop_back();
+    for (auto child = entry->first_child; child; child = child->next_sibling) {
+      bool has_code = child->n_ranges > 0 || child->high_pc > child->low_pc;
+      if (has_code && !child->contains_address(file_address)) continue;
+      if (is_function(*child) && has_code) found = child;
+      if (child->first_child) pending.push_back(child);
+    }
+  }
+  return found;
+}
+
+std::optional<xdb::line_entry> xdb::dwarf::line_entry_at_address(virt_addr address) const {
+  auto unit = compile_unit_containing_address(address);
+  if (!unit) return std::nullopt;
+  auto file_address = address.addr() - elf_->load_bias();
+
+  auto& table = unit->lines();
+  auto it = std::upper_bound(table.rows.begin(), table.rows.end(), file_address,
+                             [](auto address, auto& row) { return address < row.address; });
+  if (it == table.rows.begin()) return std::nullopt;
+  --it;
+  // the address past a sequence's last instruction belongs to none; of
+  // several rows at one address, the last is the innermost inlined code
+  if (it->end_sequence) return std::nullopt;
+  return line_entry{ virt_addr{ it->address + elf_->load_bias() }, unit->file_path(table, it->file), it->line,
+                     it->column, it->is_stmt };
+}
+
+std::vector<xdb::virt_addr> xdb::dwarf::addresses_for_line(std::string_view file, std::uint64_t line) const {
+  auto ends_with = [](std::string_view path, std::string_view suffix) {
+    if (suffix.empty() || path.size() < suffix.size()) return false;
+    if (path.substr(path.size() - suffix.size()) != suffix) return false;
+    return path.size() == suffix.size() || suffix.front() == '/' || path[path.size() - suffix.size() - 1] == '/';
+  };
+
+  // a file can only match if its own name ends with the last part of file
+  auto slash = file.rfind('/');
+  auto file_name = slash == std::string_view::npos ? file : file.substr(slash + 1);
+
+  std::vector<virt_addr> addresses;
+  for (auto& unit : units_) {
+    // which of the header's files are this one, before decoding any rows
+    std::vector<bool> matches;
+    bool any = false;
+    auto& header = unit->line_header();
+    for (std::uint32_t i = 0; i < header.files.size(); ++i) {
+      auto& name = header.files[i].name;
+      auto match = !file_name.empty() && name.size() >= file_name.size() &&
+                   name.substr(name.size() - file_name.size()) == file_name &&
+                   (ends_with(name, file) || ends_with(unit->file_path(header, i).string(), file));
+      matches.push_back(match);
+      any = any || match;
+    }
+    if (!any) continue;
+
+    auto& table = unit->lines();
+    for (std::size_t i = 0; i < table.rows.size(); ++i) {
+      auto& row = table.rows[i];
+      if (row.end_sequence || !row.is_stmt || row.line != line) continue;
+      if (row.file >= matches.size() || !matches[row.file]) continue;
+      // only where a run of rows for the line starts
+      if (i > 0) {
+        auto& previous = table.rows[i - 1];
+        if (!previous.end_sequence && previous.line == line && previous.file == row.file) continue;
+      }
+      addresses.push_back(virt_addr{ row.address + elf_->load_bias() });
+    }
+  }
+  std::sort(addresses.begin(), addresses.end());
+  return addresses;
+}
+
+void xdb::dwarf::parse_all() const {
+  for (auto& unit : units_) {
+    unit->root();
+    unit->lines();
+  }
+}
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <libxdb/elf.hpp>
+#include <libxdb/error.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  bool is_address_symbol(const Elf64_Sym& symbol) {
+    auto type = ELF64_ST_TYPE(symbol.st_info);
+    return (type == STT_FUNC || type == STT_OBJECT) && symbol.st_shndx != SHN_UNDEF && symbol.st_value != 0;
+  }
+
+  // of two symbols at one address, the one to name it by: the bigger, then
+  // a global over a local
+  bool is_better_name(const Elf64_Sym& a, const Elf64_Sym& b) {
+    if (a.st_size != b.st_size) return a.st_size > b.st_size;
+    return ELF64_ST_BIND(a.st_info) == STB_GLOBAL && ELF64_ST_BIND(b.st_info) != STB_GLOBAL;
+  }
+
+  std::uint32_t gnu_hash(std::string_view name) {
+    std::uint32_t h = 5381;
+    for (auto c : name) h = h * 33 + static_cast<unsigned char>(c);
+    return h;
+  }
+}
+
+xdb::elf::elf(const std::filesystem::path& path) : path_(path) {
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error::send_errno("Could not open ELF file " + path.string());
+  }
+  struct stat info;
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    error::send_errno("Could not stat ELF file " + path.string());
+  }
+  size_ = info.st_size;
+  if (size_ < sizeof(Elf64_Ehdr)) {
+    close(fd);
+    error::send(path.string() + " is too small to be an ELF file");
+  }
+  // the pages are only read in as they are touched
+  auto mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error::send_errno("Could not map ELF file " + path.string());
+  }
+  data_ = static_cast<std::byte*>(mapping);
+
+  try {
+    header_ = reinterpret_cast<const Elf64_Ehdr*>(data_);
+    if (std::memcmp(header_->e_ident, ELFMAG, SELFMAG) != 0 || header_->e_ident[EI_CLASS] != ELFCLASS64) {
+      error::send(path.string() + " is not a 64-bit ELF file");
+    }
+    if (header_->e_shoff > size_ || header_->e_shnum > (size_ - header_->e_shoff) / sizeof(Elf64_Shdr)) {
+      error::send(path.string() + " has a truncated section header table");
+    }
+    section_headers_ = reinterpret_cast<const Elf64_Shdr*>(data_ + header_->e_shoff);
+    for (auto& section : sections()) {
+      if (section.sh_type != SHT_NOBITS && (section.sh_offset > size_ || section.sh_size > size_ - section.sh_offset)) {
+        error::send(path.string() + " has a section that runs past its end");
+      }
+    }
+    if (header_->e_shstrndx < header_->e_shnum) {
+      for (auto& section : sections()) section_map_.emplace(section_name(section), &section);
+    }
+
+    auto symtab = get_section(".symtab");
+    auto dynsym = get_section(".dynsym");
+    if (dynsym) {
+      dynamic_symbols_ = symbol_table(dynsym);
+      dynamic_strings_ = &section_headers_[dynsym->sh_link];
+    }
+    if (symtab) {
+      symbols_ = symbol_table(symtab);
+      symbol_strings_ = &section_headers_[symtab->sh_link];
+    } else {
+      symbols_ = dynamic_symbols_;
+      symbol_strings_ = dynamic_strings_;
+    }
+    gnu_hash_ = get_section(".gnu.hash");
+    if (gnu_hash_ && (!dynsym || &section_headers_[gnu_hash_->sh_link] != dynsym)) gnu_hash_ = nullptr;
+  } catch (...) {
+    munmap(data_, size_);
+    throw;
+  }
+}
+
+xdb::elf::~elf() {
+  munmap(data_, size_);
+}
+
+std::string_view xdb::elf::section_name(const Elf64_Shdr& section) const {
+  return get_string(section_headers_[header_->e_shstrndx], section.sh_name);
+}
+
+const Elf64_Shdr* xdb::elf::get_section(std::string_view name) const {
+  auto it = section_map_.find(name);
+  return it == section_map_.end() ? nullptr : it->second;
+}
+
+xdb::span<std::byte> xdb::elf::section_contents(const Elf64_Shdr& section) const {
+  if (section.sh_type == SHT_NOBITS) return {};
+  return { data_ + section.sh_offset, section.sh_size };
+}
+
+xdb::span<std::byte> xdb::elf::section_contents(std::string_view name) const {
+  auto section = get_section(name);
+  return section ? section_contents(*section) : span<std::byte>{};
+}
+
+std::string_view xdb::elf::get_string(const Elf64_Shdr& table, std::size_t offset) const {
+  auto contents = section_contents(table);
+  if (offset >= contents.size()) return {};
+  auto start = reinterpret_cast<const char*>(contents.data()) + offset;
+  // strnlen, so a table without its final NUL can't run off the end
+  return { start, strnlen(start, contents.size() - offset) };
+}
+
+xdb::span<Elf64_Phdr> xdb::elf::segments() const {
+  if (header_->e_phoff > size_ || header_->e_phnum > (size_ - header_->e_phoff) / sizeof(Elf64_Phdr)) {
+    error::send(path_.string() + " has a truncated program header table");
+  }
+  return { reinterpret_cast<const Elf64_Phdr*>(data_ + header_->e_phoff), header_->e_phnum };
+}
+
+xdb::span<Elf64_Sym> xdb::elf::symbol_table(const Elf64_Shdr* section) const {
+  if (!section) return {};
+  if (section->sh_link >= header_->e_shnum) {
+    error::send(path_.string() + " has a symbol table without a string table");
+  }
+  auto contents = section_contents(*section);
+  return { reinterpret_cast<const Elf64_Sym*>(contents.data()), contents.size() / sizeof(Elf64_Sym) };
+}
+
+std::string_view xdb::elf::symbol_name(const Elf64_Sym& symbol) const {
+  auto is_dynamic = &symbol >= dynamic_symbols_.begin() && &symbol < dynamic_symbols_.end();
+  return get_string(is_dynamic ? *dynamic_strings_ : *symbol_strings_, symbol.st_name);
+}
+
+std::uint64_t xdb::elf::image_base() const {
+  auto base = UINT64_MAX;
+  for (auto& segment : segments()) {
+    if (segment.p_type == PT_LOAD) base = std::min(base, segment.p_vaddr & ~(page_size - 1));
+  }
+  return base == UINT64_MAX ? 0 : base;
+}
+
+void xdb::elf::notify_loaded(virt_addr base) {
+  load_bias_ = base.addr() - image_base();
+}
+
+/// A note is a header, then its name and its description, each padded to
+/// four bytes; the build id is the description of the GNU note of type
+/// NT_GNU_BUILD_ID, which linkers put in .note.gnu.build-id.
+xdb::span<std::byte> xdb::elf::build_id() const {
+  auto find_in = [](span<std::byte> notes) -> span<std::byte> {
+    std::size_t offset = 0;
+    while (offset + sizeof(Elf64_Nhdr) <= notes.size()) {
+      Elf64_Nhdr note;
+      std::memcpy(&note, notes.data() + offset, sizeof(note));
+      auto name = offset + sizeof(note);
+      auto desc = name + ((note.n_namesz + 3) & ~3u);
+      auto next = desc + ((note.n_descsz + 3) & ~std::uint64_t{ 3 });
+      if (desc + note.n_descsz > notes.size()) break;
+      if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 &&
+          std::memcmp(notes.data() + name, "GNU", 4) == 0) {
+        return { notes.data() + desc, note.n_descsz };
+      }
+      offset = next;
+    }
+    return {};
+  };
+  if (auto section = get_section(".note.gnu.build-id")) return find_in(section_contents(*section));
+  for (auto& segment : segments()) {
+    if (segment.p_type != PT_NOTE || segment.p_offset > size_ || segment.p_filesz > size_ - segment.p_offset) continue;
+    auto id = find_in({ data_ + segment.p_offset, segment.p_filesz });
+    if (!id.empty()) return id;
+  }
+  return {};
+}
+
+void xdb::elf::build_address_index() const {
+  address_index_built_ = true;
+  std::vector<const Elf64_Sym*> sorted;
+  for (auto& symbol : symbols_) {
+    if (is_address_symbol(symbol)) sorted.push_back(&symbol);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) {
+    if (a->st_value != b->st_value) return a->st_value < b->st_value;
+    return is_better_name(*a, *b);
+  });
+
+  // one entry per address, for the first and best named symbol there
+  address_starts_.reserve(sorted.size());
+  address_entries_.reserve(sorted.size());
+  for (auto symbol : sorted) {
+    if (!address_starts_.empty() && address_starts_.back() == symbol->st_value) continue;
+    address_starts_.push_back(symbol->st_value);
+    address_entries_.push_back({ symbol->st_value + std::max<std::uint64_t>(symbol->st_size, 1), symbol });
+  }
+}
+
+/// The search narrows down to the last start at or below the address with
+/// a conditional move per step rather than a branch the CPU would guess
+/// wrong half the time.
+const Elf64_Sym* xdb::elf::symbol_containing_address(virt_addr address) const {
+  if (!address_index_built_) build_address_index();
+  auto file_address = address.addr() - load_bias_;
+  if (address_starts_.empty() || file_address < address_starts_.front()) return nullptr;
+  auto base = address_starts_.data();
+  for (auto n = address_starts_.size(); n > 1;) {
+    auto half = n / 2;
+    base = base[half] <= file_address ? base + half : base;
+    n -= half;
+  }
+  auto& entry = address_entries_[base - address_starts_.data()];
+  return file_address < entry.end ? entry.symbol : nullptr;
+}
+
+/// .gnu.hash is a bloom filter, then buckets of hash chains over the tail
+/// of .dynsym from symoffset on, where each chain ends with a hash whose
+/// lowest bit is set.
+const Elf64_Sym* xdb::elf::gnu_hash_lookup(std::string_view name) const {
+  auto contents = section_contents(*gnu_hash_);
+  auto words = reinterpret_cast<const std::uint32_t*>(contents.data());
+  auto n_words = contents.size() / sizeof(std::uint32_t);
+  if (n_words < 4) return nullptr;
+  auto n_buckets = words[0];
+  auto symoffset = words[1];
+  auto bloom_size = words[2];
+  auto bloom_shift = words[3];
+  if (n_buckets == 0 || bloom_size == 0 || 4 + 2 * std::uint64_t{ bloom_size } + n_buckets > n_words) return nullptr;
+  auto bloom = reinterpret_cast<const std::uint64_t*>(words + 4);
+  auto buckets = words + 4 + 2 * bloom_size;
+  auto chains = buckets + n_buckets;
+  auto n_chains = n_words - (chains - words);
+
+  auto hash = gnu_hash(name);
+  auto word = bloom[(hash / 64) % bloom_size];
+  auto mask = (std::uint64_t{ 1 } << (hash % 64)) | (std::uint64_t{ 1 } << ((hash >> bloom_shift) % 64));
+  if ((word & mask) != mask) return nullptr;
+
+  for (auto index = buckets[hash % n_buckets]; index >= symoffset; ++index) {
+    if (index >= dynamic_symbols_.size() || index - symoffset >= n_chains) return nullptr;
+    auto chain_hash = chains[index - symoffset];
+    if ((chain_hash | 1) == (hash | 1) && symbol_name(dynamic_symbols_[index]) == name) {
+      return &dynamic_symbols_[index];
+    }
+    if (chain_hash & 1) break;
+  }
+  return nullptr;
+}
+
+const Elf64_Sym* xdb::elf::symbol_by_name(std::string_view name) const {
+  if (gnu_hash_) {
+    if (auto symbol = gnu_hash_lookup(name)) return symbol;
+  }
+  if (!name_index_) build_name_index();
+  auto it = std::lower_bound(name_index_->begin(), name_index_->end(), name,
+                             [](auto& entry, std::string_view name) { return entry.first < name; });
+  return it != name_index_->end() && it->first == name ? it->second : nullptr;
+}
+
+void xdb::elf::build_name_index() const {
+  name_index_.emplace();
+  for (auto& symbol : symbols_) {
+    if (symbol.st_name != 0 && symbol.st_shndx != SHN_UNDEF) name_index_->emplace_back(symbol_name(symbol), &symbol);
+  }
+  std::stable_sort(name_index_->begin(), name_index_->end(), [](auto& a, auto& b) { return a.first < b.first; });
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <csignal>
+#include <libxdb/error.hpp>
+#include <libxdb/event_loop.hpp>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+int xdb::sigchld_fd() {
+  static int fd = [] {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    if (pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) {
+      error::send("Could not block SIGCHLD");
+    }
+    auto fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+      error::send_errno("Could not create signalfd");
+    }
+    return fd;
+  }();
+  return fd;
+}
+
+void xdb::drain_sigchld_fd() {
+  signalfd_siginfo info[16];
+  while (read(sigchld_fd(), info, sizeof(info)) > 0) {}
+}
+
+xdb::event_loop::event_loop() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    error::send_errno("Could not create epoll instance");
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = sigchld_fd();
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sigchld_fd(), &event) < 0) {
+    close(epoll_fd_);
+    error::send_errno("Could not watch for SIGCHLD");
+  }
+}
+
+xdb::event_loop::~event_loop() {
+  close(epoll_fd_);
+}
+
+void xdb::event_loop::add_process(process& proc, stop_callback on_stop) {
+  remove_process(proc);
+  processes_.emplace_back(&proc, std::move(on_stop));
+}
+
+void xdb::event_loop::remove_process(const process& proc) {
+  processes_.erase(std::remove_if(processes_.begin(), processes_.end(),
+                                  [&](auto& entry) { return entry.first == &proc; }),
+                   processes_.end());
+}
+
+void xdb::event_loop::add_fd(int fd, fd_callback on_readable) {
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  auto op = fds_.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (epoll_ctl(epoll_fd_, op, fd, &event) < 0) {
+    error::send_errno("Could not watch file descriptor");
+  }
+  fds_[fd] = std::move(on_readable);
+}
+
+void xdb::event_loop::remove_fd(int fd) {
+  if (fds_.erase(fd)) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  }
+}
+
+/// Also run before sleeping, for stops whose SIGCHLD was already read: by
+/// wait_on_signal, or by another loop.
+bool xdb::event_loop::check_processes() {
+  bool any = false;
+  // callbacks may add or remove processes, so work from a copy
+  auto processes = processes_;
+  for (auto& [proc, on_stop] : processes) {
+    auto still_added = std::any_of(processes_.begin(), processes_.end(),
+                                   [&, proc = proc](auto& entry) { return entry.first == proc; });
+    if (!still_added) continue;
+    while (proc->has_running_threads()) {
+      auto reason = proc->poll_stop();
+      if (!reason) break;
+      any = true;
+      on_stop(*proc, *reason);
+    }
+  }
+  return any;
+}
+
+bool xdb::event_loop::run_once(std::optional<std::chrono::milliseconds> timeout) {
+  auto any = check_processes();
+
+  constexpr int max_events = 16;
+  epoll_event events[max_events];
+  int timeout_ms = any ? 0 : timeout ? static_cast<int>(timeout->count()) : -1;
+  int n;
+  do {
+    n = epoll_wait(epoll_fd_, events, max_events, timeout_ms);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    error::send_errno("epoll_wait failed");
+  }
+
+  for (int i = 0; i < n; ++i) {
+    auto fd = events[i].data.fd;
+    if (fd == sigchld_fd()) {
+      drain_sigchld_fd();
+      any |= check_processes();
+    } else if (auto it = fds_.find(fd); it != fds_.end()) {
+      // the callback may remove itself
+      auto on_readable = it->second;
+      on_readable(fd);
+      any = true;
+    }
+  }
+  return any;
+}
+
+void xdb::event_loop::run() {
+  stopped_ = false;
+  while (!stopped_) run_once();
+}
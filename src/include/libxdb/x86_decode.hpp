@@ -0,0 +1,39 @@
+#ifndef XDB_X86_DECODE_HPP
+#define XDB_X86_DECODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace xdb {
+  // How an instruction uses rip, which decides how it can be moved
+  enum class x86_flow {
+    plain,          // falls through; may still address memory rip-relatively
+    jmp_rel,        // jmp rel8/rel32
+    jcc_rel,        // jcc rel8/rel32
+    call_rel,       // call rel32
+    call_indirect,  // call r/m, pushes its own address
+    loop_rel,       // loop/loopcc/jrcxz, rel8 with no long form
+    ret,            // ret/ret imm16; never falls through
+    jmp_indirect,   // jmp r/m; never falls through
+    other           // int3/int n and friends; not worth relocating
+  };
+
+  struct x86_instruction {
+    std::size_t length = 0;
+    x86_flow flow = x86_flow::plain;
+    // offset of the disp32 of a rip-relative memory operand
+    std::optional<std::size_t> rip_disp_offset;
+    // for relative branches: where the displacement sits and how wide it is
+    std::size_t rel_offset = 0;
+    std::size_t rel_size = 0;
+    // the low nibble of a jcc opcode
+    std::uint8_t condition = 0;
+  };
+
+  // Decodes the length and control flow of the 64-bit instruction at code.
+  // Returns nullopt for anything it doesn't recognise.
+  std::optional<x86_instruction> decode_x86(const std::byte* code, std::size_t size);
+}
+
+#endif
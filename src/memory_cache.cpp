@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <cstring>
+#include <libxdb/memory_cache.hpp>
+
+void xdb::memory_cache::set_max_pages(std::size_t max_pages) {
+  max_pages_ = max_pages;
+  while (pages_.size() > max_pages_) {
+    pages_.erase(order_.front());
+    order_.pop_front();
+  }
+}
+
+const xdb::memory_cache::page* xdb::memory_cache::find(virt_addr page_addr) {
+  auto it = pages_.find(page_addr.addr());
+  if (it == pages_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return it->second.get();
+}
+
+void xdb::memory_cache::insert(virt_addr page_addr, const std::byte* data) {
+  auto& entry = pages_[page_addr.addr()];
+  if (!entry) {
+    if (pages_.size() > max_pages_) {
+      pages_.erase(order_.front());
+      order_.pop_front();
+    }
+    entry = std::make_unique<page>();
+    order_.push_back(page_addr.addr());
+  }
+  std::memcpy(entry->data(), data, page_size);
+}
+
+void xdb::memory_cache::invalidate(virt_addr addr, std::size_t size) {
+  if (pages_.empty() || size == 0) return;
+  auto first = addr.addr() & ~(page_size - 1);
+  auto last = (addr.addr() + size - 1) & ~(page_size - 1);
+  for (auto page_addr = first; page_addr <= last; page_addr += page_size) {
+    if (pages_.erase(page_addr)) {
+      order_.erase(std::find(order_.begin(), order_.end(), page_addr));
+    }
+  }
+}
+
+void xdb::memory_cache::clear() {
+  pages_.clear();
+  order_.clear();
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <libxdb/error.hpp>
+#include <libxdb/object_map.hpp>
+#include <map>
+#include <sstream>
+
+namespace {
+  // loading runs behind the prompt, not instead of it
+  constexpr int background_niceness = 19;
+}
+
+bool xdb::loaded_object::is_loaded() const {
+  std::lock_guard lock(mutex_);
+  return state_ == state::loaded || state_ == state::failed;
+}
+
+bool xdb::loaded_object::load() const {
+  {
+    std::lock_guard lock(mutex_);
+    if (state_ != state::queued) return false;
+    state_ = state::loading;
+  }
+  std::unique_ptr<elf> file;
+  std::unique_ptr<symbol_index> index;
+  std::string error;
+  try {
+    file = std::make_unique<elf>(path_);
+    file->notify_loaded(base_);
+    index = cache_dir_ ? symbol_index::load(*file, *cache_dir_) : symbol_index::build(*file);
+  } catch (const std::exception& e) {
+    error = e.what();
+  }
+  {
+    std::lock_guard lock(mutex_);
+    elf_ = std::move(file);
+    index_ = std::move(index);
+    error_ = std::move(error);
+    state_ = index_ ? state::loaded : state::failed;
+  }
+  done_.notify_all();
+  return true;
+}
+
+void xdb::loaded_object::cancel() const {
+  std::lock_guard lock(mutex_);
+  if (state_ != state::queued) return;
+  state_ = state::failed;
+  error_ = "it was unmapped";
+}
+
+/// Waiting on an object no worker has reached yet would mean waiting for
+/// everything queued before it, so the waiter loads it itself.
+void xdb::loaded_object::wait() const {
+  if (load()) return;
+  std::unique_lock lock(mutex_);
+  done_.wait(lock, [&] { return state_ == state::loaded || state_ == state::failed; });
+}
+
+const xdb::elf& xdb::loaded_object::get_elf() const {
+  wait();
+  if (!elf_ || !index_) error::send("Could not load " + path_.string() + ": " + error_);
+  return *elf_;
+}
+
+const xdb::symbol_index& xdb::loaded_object::get_index() const {
+  wait();
+  if (!index_) error::send("Could not load " + path_.string() + ": " + error_);
+  return *index_;
+}
+
+/// Each line of maps is a mapping: "start-end perms offset dev inode path".
+/// The mappings of one file are gathered into one object, based where its
+/// offset-0 mapping starts. Files that are gone, shown as "(deleted)", and
+/// the anonymous and special mappings are left out.
+xdb::object_map::object_map(pid_t pid, std::size_t n_workers, std::optional<std::filesystem::path> cache_dir)
+    : cache_dir_(std::move(cache_dir)), pool_(std::make_unique<thread_pool>(n_workers, background_niceness)) {
+  std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+  if (!maps) error::send("Could not read the mappings of process " + std::to_string(pid));
+
+  struct gathered {
+    std::uint64_t start = UINT64_MAX;
+    std::uint64_t end = 0;
+    std::optional<std::uint64_t> base;
+  };
+  std::map<std::string, gathered> files;
+  std::vector<std::string> order;
+  std::string line;
+  while (std::getline(maps, line)) {
+    std::istringstream fields(line);
+    std::string range, perms, offset, dev, inode;
+    fields >> range >> perms >> offset >> dev >> inode;
+    std::string path;
+    std::getline(fields >> std::ws, path);
+    if (path.empty() || path[0] != '/') continue;
+    if (path.size() > 10 && path.compare(path.size() - 10, 10, " (deleted)") == 0) continue;
+    auto dash = range.find('-');
+    std::uint64_t start = std::stoull(range.substr(0, dash), nullptr, 16);
+    std::uint64_t end = std::stoull(range.substr(dash + 1), nullptr, 16);
+    auto [it, inserted] = files.try_emplace(path);
+    if (inserted) order.push_back(path);
+    auto& file = it->second;
+    file.start = std::min(file.start, start);
+    file.end = std::max(file.end, end);
+    if (!file.base && std::stoull(offset, nullptr, 16) == 0) file.base = start;
+  }
+  // every object is in place before a worker is woken to load one
+  std::vector<thread_pool::task> loads;
+  for (auto& path : order) {
+    auto& file = files[path];
+    auto& object =
+        insert(path, virt_addr{ file.start }, virt_addr{ file.end }, virt_addr{ file.base.value_or(file.start) });
+    loads.push_back([object] { object->load(); });
+  }
+  pool_->submit(std::move(loads));
+}
+
+const std::shared_ptr<xdb::loaded_object>& xdb::object_map::insert(std::filesystem::path path, virt_addr start,
+                                                                   virt_addr end, virt_addr base) {
+  auto object = std::shared_ptr<loaded_object>(new loaded_object(std::move(path), start, end, base, cache_dir_));
+  auto it = std::upper_bound(objects_.begin(), objects_.end(), start,
+                             [](auto start, auto& object) { return start < object->start(); });
+  return *objects_.insert(it, std::move(object));
+}
+
+const xdb::loaded_object& xdb::object_map::add(std::filesystem::path path, virt_addr start, virt_addr end,
+                                               virt_addr base) {
+  auto object = insert(std::move(path), start, end, base);
+  pool_->submit([object] { object->load(); });
+  return *object;
+}
+
+/// Only the ELF header and the program headers are read here; the rest of
+/// the file is left to the worker.
+const xdb::loaded_object& xdb::object_map::add(std::filesystem::path path, virt_addr load_bias) {
+  std::ifstream file(path, std::ios::binary);
+  Elf64_Ehdr header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64) {
+    error::send("Could not read the ELF header of " + path.string());
+  }
+  std::vector<Elf64_Phdr> segments(header.e_phnum);
+  file.seekg(header.e_phoff);
+  if (!file.read(reinterpret_cast<char*>(segments.data()), segments.size() * sizeof(Elf64_Phdr))) {
+    error::send("Could not read the program headers of " + path.string());
+  }
+  std::uint64_t low = UINT64_MAX;
+  std::uint64_t high = 0;
+  for (auto& segment : segments) {
+    if (segment.p_type != PT_LOAD) continue;
+    low = std::min<std::uint64_t>(low, segment.p_vaddr & ~(page_size - 1));
+    high = std::max<std::uint64_t>(high, (segment.p_vaddr + segment.p_memsz + page_size - 1) & ~(page_size - 1));
+  }
+  if (low >= high) error::send(path.string() + " has nothing to load");
+  return add(std::move(path), load_bias + low, load_bias + high, load_bias + low);
+}
+
+/// A worker already loading the object finishes with its own reference to
+/// it; one that hasn't started finds it cancelled.
+void xdb::object_map::remove(virt_addr start) {
+  auto it = std::find_if(objects_.begin(), objects_.end(), [&](auto& object) { return object->start() == start; });
+  if (it == objects_.end()) return;
+  (*it)->cancel();
+  objects_.erase(it);
+}
+
+const xdb::loaded_object* xdb::object_map::object_containing_address(virt_addr address) const {
+  auto it = std::upper_bound(objects_.begin(), objects_.end(), address,
+                             [](auto address, auto& object) { return address < object->start(); });
+  if (it == objects_.begin()) return nullptr;
+  --it;
+  return (*it)->contains_address(address) ? it->get() : nullptr;
+}
+
+std::optional<xdb::object_map::symbol_match> xdb::object_map::symbol_containing_address(virt_addr address) const {
+  auto object = object_containing_address(address);
+  if (!object) return std::nullopt;
+  try {
+    if (auto symbol = object->get_index().symbol_containing_address(address)) return symbol_match{ object, symbol };
+  } catch (const error&) {
+  }
+  return std::nullopt;
+}
+
+std::optional<xdb::line_entry> xdb::object_map::line_entry_at_address(virt_addr address) const {
+  auto object = object_containing_address(address);
+  if (!object) return std::nullopt;
+  try {
+    return object->get_index().line_entry_at_address(address);
+  } catch (const error&) {
+    return std::nullopt;
+  }
+}
+
+std::optional<xdb::object_map::symbol_match> xdb::object_map::symbol_by_name(std::string_view name) const {
+  for (auto& object : objects_) {
+    try {
+      if (auto symbol = object->get_index().symbol_by_name(name)) return symbol_match{ object.get(), symbol };
+    } catch (const error&) {
+    }
+  }
+  return std::nullopt;
+}
+
+bool xdb::object_map::all_loaded() const {
+  return std::all_of(objects_.begin(), objects_.end(), [](auto& object) { return object->is_loaded(); });
+}
+
+void xdb::object_map::wait_all() const {
+  for (auto& object : objects_) object->wait();
+}
@@ -1,12 +1,30 @@
 #include <filesystem>
 #include <libxdb/process.hpp>
 #include <libxdb/error.hpp>
+#include <libxdb/event_loop.hpp>
 #include <libxdb/pipe.hpp>
+#include <libxdb/x86_decode.hpp>
 #include <memory>
+#include <poll.h>
+#include <csignal>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
 #include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <link.h>
+#include <climits>
+#include <cstddef>
+#include <cstring>
 #include <unistd.h>
 #include <algorithm>
+#include <fstream>
 
 using std::make_unique;
 
@@ -35,8 +53,47 @@ xdb::stop_reason::stop_reason(int wait_status) {
   }
 }
 
+namespace {
+  // new threads and processes are followed, and an exec is reported as one
+  constexpr long follow_options = PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK | PTRACE_O_TRACEVFORK | PTRACE_O_TRACEEXEC;
+
+  // Sends the selected syscalls to the tracer and lets every other one
+  // through. Syscalls of other ABIs (i386, x32) aren't selected.
+  std::vector<sock_filter> make_syscall_filter(const std::vector<int>& syscalls) {
+    std::vector<sock_filter> filter = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, arch)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+    };
+    for (auto id : syscalls) {
+      filter.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<std::uint32_t>(id), 0, 1));
+      filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRACE));
+    }
+    filter.push_back(BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW));
+    return filter;
+  }
+}
+
 /// trace: whether to trace the child process (set to false for testing to create a untraced process)
-std::unique_ptr<xdb::process> xdb::process::launch(std::filesystem::path path, bool trace, std::optional<int> stdout_replacement) {
+/// syscalls: install a seccomp filter in the child that stops it on those
+/// syscalls only, and log them
+std::unique_ptr<xdb::process> xdb::process::launch(std::filesystem::path path, bool trace, std::optional<int> stdout_replacement,
+                                                   std::optional<syscall_trace> syscalls) {
+  if (syscalls && !trace) {
+    error::send("Can't trace syscalls of an untraced process");
+  }
+  // built up front: the child shouldn't allocate between fork and exec
+  std::vector<sock_filter> filter;
+  std::shared_ptr<std::ofstream> syscall_log;
+  if (syscalls) {
+    filter = make_syscall_filter(syscalls->syscalls);
+    syscall_log = std::make_shared<std::ofstream>(syscalls->log);
+    if (!*syscall_log) {
+      error::send("Could not open syscall log " + syscalls->log.string());
+    }
+  }
+
   xdb::pipe channel(true); // pass errors from child to parent
   pid_t pid;
   if ((pid = fork()) < 0) {
@@ -51,14 +108,46 @@ std::unique_ptr<xdb::process> xdb::process::launch(std::filesystem::path path, b
         exit_with_error(channel, "Failed to replace stdout");
       }
     }
+    // an event loop in the debugger may have blocked it
+    sigset_t sigchld;
+    sigemptyset(&sigchld);
+    sigaddset(&sigchld, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &sigchld, nullptr);
     if (trace && ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) < 0) {
       exit_with_error(channel, "Failed to PTRACE_TRACEME");
     }
+    if (syscalls) {
+      // until the parent sets PTRACE_O_TRACESECCOMP, a selected syscall
+      // (execlp's, say) would fail with ENOSYS
+      raise(SIGSTOP);
+      sock_fprog program{ static_cast<unsigned short>(filter.size()), filter.data() };
+      if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) < 0) {
+        exit_with_error(channel, "Failed to set no_new_privs");
+      }
+      if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) < 0) {
+        exit_with_error(channel, "Failed to install seccomp filter");
+      }
+    }
     if (execlp(path.c_str(), path.c_str(), nullptr) < 0) {
       exit_with_error(channel, "Failed to execlp");
     }
   }
 
+  long options = follow_options;
+  if (syscalls) {
+    // without PTRACE_O_TRACEEXEC yet, so the exec still stops with a plain SIGTRAP
+    long seccomp_options = PTRACE_O_TRACESECCOMP | PTRACE_O_TRACESYSGOOD;
+    options |= seccomp_options;
+    // the child's SIGSTOP, unless it failed before
+    int wait_status;
+    if (waitpid(pid, &wait_status, 0) == pid && WIFSTOPPED(wait_status) &&
+        (ptrace(PTRACE_SETOPTIONS, pid, nullptr, seccomp_options) < 0 || ptrace(PTRACE_CONT, pid, nullptr, nullptr) < 0)) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+      error::send("Failed to set ptrace options");
+    }
+  }
+
   // get error message from child
   auto err_msg = channel.finish_read();
   if (!err_msg.empty()) {
@@ -68,23 +157,112 @@ std::unique_ptr<xdb::process> xdb::process::launch(std::filesystem::path path, b
   }
 
   std::unique_ptr<process> proc(new process(pid, /*terminate_on_end=*/true, trace));
+  proc->syscall_log_ = std::move(syscall_log);
   if (trace) {
     proc->wait_on_signal();
+    if (ptrace(PTRACE_SETOPTIONS, pid, nullptr, options) < 0) {
+      error::send_errno("Failed to set ptrace options");
+    }
   }
   return proc;
 }
 
 
+
 std::unique_ptr<xdb::process> xdb::process::attach(pid_t pid) {
-  if (pid <= 0) {
-    error::send("Invalid PID");
+  return std::move(attach(std::vector<pid_t>{ pid }).front());
+}
+
+/// PTRACE_SEIZE attaches without sending anything the inferior could see,
+/// and leaves it running. So every thread of every process is seized first,
+/// then all of them are interrupted before waiting for any, and a process is
+/// only paused from its interrupt to the end of attach.
+std::vector<std::unique_ptr<xdb::process>> xdb::process::attach(const std::vector<pid_t>& pids) {
+  std::vector<std::unique_ptr<process>> procs;
+  for (auto pid : pids) {
+    if (pid <= 0) {
+      error::send("Invalid PID");
+    }
+    // the options are set atomically, so no event can slip past before them
+    if (ptrace(PTRACE_SEIZE, pid, nullptr, follow_options) < 0) {
+      error::send_errno("Failed to PTRACE_SEIZE " + std::to_string(pid));
+    }
+    procs.emplace_back(new process(pid, /*terminate_on_end=*/false, true));
+    auto& proc = *procs.back();
+    proc.seized_ = true;
+    proc.threads_.at(pid).state = process_state::running;
+    proc.seize_threads();
   }
-  if (ptrace(PTRACE_ATTACH, pid, nullptr, nullptr) < 0) {
-    error::send_errno("Failed to PTRACE_ATTACH");
+
+  for (auto& proc : procs) {
+    for (auto& [tid, thread] : proc->threads_) proc->request_stop(thread);
+  }
+  for (auto& proc : procs) {
+    proc->stop_running_threads();
+    if (proc->state_ != process_state::stopped) {
+      error::send("Process " + std::to_string(proc->pid_) + " exited while attaching");
+    }
+  }
+  return procs;
+}
+
+/// Repeats until a pass over the task list finds no new threads. Threads
+/// that seized ones create from now on are attached by the kernel, and
+/// show up through their clone events.
+void xdb::process::seize_threads() {
+  auto task_dir = "/proc/" + std::to_string(pid_) + "/task";
+  for (bool found = true; found;) {
+    found = false;
+    for (auto& entry : std::filesystem::directory_iterator(task_dir)) {
+      auto tid = static_cast<pid_t>(std::stoi(entry.path().filename().string()));
+      if (threads_.count(tid)) continue;
+      if (ptrace(PTRACE_SEIZE, tid, nullptr, follow_options) < 0) {
+        continue;  // it exited, or the kernel already attached it for us
+      }
+      add_thread(tid, process_state::running, false);
+      found = true;
+    }
+  }
+}
+
+namespace {
+  // Statuses that one process object's waitpid(-1) collected for threads of
+  // another inferior, waiting for that one to ask
+  struct stashed_status {
+    pid_t tid;
+    pid_t tgid;  // 0 if it couldn't be read
+    int status;
+  };
+  std::vector<stashed_status> g_stashed_statuses;
+  // Exits that waitpid(-1) reaped for children of ours nobody traces, by
+  // pid, for wait_untraced to hand to their owner
+  std::unordered_map<pid_t, int> g_unclaimed_exits;
+  // the status last stashed for tid, as single_step_thread leaves it
+  int last_stashed_status(pid_t tid) {
+    auto it = std::find_if(g_stashed_statuses.rbegin(), g_stashed_statuses.rend(),
+                           [&](auto& stashed) { return stashed.tid == tid; });
+    return it == g_stashed_statuses.rend() ? 0 : it->status;
+  }
+  // the thread group of every thread some process object has, so stashing
+  // another inferior's status rarely needs to read /proc
+  std::unordered_map<pid_t, pid_t> g_thread_groups;
+
+  pid_t thread_group_of(pid_t tid) {
+    std::ifstream status("/proc/" + std::to_string(tid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.rfind("Tgid:", 0) == 0) return std::stoi(line.substr(5));
+    }
+    return 0;
+  }
+
+  // 0 for the exit of a thread nobody knows, such as one an exec took away
+  pid_t thread_group_for(pid_t tid, int wait_status) {
+    if (auto known = g_thread_groups.find(tid); known != g_thread_groups.end()) {
+      return known->second;
+    }
+    return WIFSTOPPED(wait_status) ? thread_group_of(tid) : 0;
   }
-  std::unique_ptr<process> proc(new process(pid, /*terminate_on_end=*/false, true));
-  proc->wait_on_signal();
-  return proc;
 }
 
 xdb::process::~process() {
@@ -93,93 +271,2326 @@ xdb::process::~process() {
 
     // stop it before detaching
     if (is_attached_) {
-      if (state_ == process_state::running) {
-        kill(pid_, SIGSTOP);
-        waitpid(pid_, &status, 0);
+      try {
+        interrupt();
+      } catch (const error&) {}
+      if (state_ == process_state::stopped) {
+        try {
+          // don't leave int3s behind in a process that keeps running
+          if (!terminated_on_end_) {
+            disable_all_breakpoint_sites();
+            watchpoints_.for_each([](auto& point) { point.disable(); });
+            tracepoints_.for_each([](auto& point) { point.disable(); });
+          }
+          // don't lose register writes that haven't been flushed yet
+          for (auto& [tid, thread] : threads_) thread.regs->flush();
+        } catch (const error&) {}
       }
-      // detach and let it continue
-      ptrace(PTRACE_DETACH, pid_, nullptr, nullptr);
-      kill(pid_, SIGCONT);
+      // detach and let it continue, with any signal it was stopped on the
+      // way to; an interrupt still pending when a seized thread is detached
+      // is dropped, but a SIGSTOP isn't
+      for (auto& [tid, thread] : threads_) {
+        ptrace(PTRACE_DETACH, tid, nullptr, reinterpret_cast<void*>(static_cast<long>(thread.pending_signal)));
+      }
+      if (!seized_) kill(pid_, SIGCONT);
     }
 
-    // terminate it if needed
+    // terminate it if needed, reaping the other threads before the leader
     if (terminated_on_end_) {
       kill(pid_, SIGKILL);
-      waitpid(pid_, &status, 0);
+      if (is_attached_ && state_ != process_state::exited && state_ != process_state::terminated) {
+        for (auto& [tid, thread] : threads_) {
+          if (tid != pid_) waitpid(tid, &status, __WALL);
+        }
+      }
+      wait_untraced(pid_, &status, __WALL);
+    }
+  }
+  for (auto& [tid, thread] : threads_) {
+    if (auto it = g_thread_groups.find(tid); it != g_thread_groups.end() && it->second == pid_) {
+      g_thread_groups.erase(it);
     }
   }
+  if (mem_fd_ != -1) {
+    close(mem_fd_);
+  }
 }
 
 void xdb::process::resume() {
-  if (ptrace(PTRACE_CONT, pid_, nullptr, nullptr) < 0) {
-    error::send_errno("Failed to PTRACE_CONT");
+  if (state_ == process_state::exited || state_ == process_state::terminated) {
+    error::send("Process has already terminated");
+  }
+  for (auto& [tid, thread] : threads_) {
+    // a stop nobody has seen yet stays for wait_on_signal to report
+    if (thread.state == process_state::stopped && !thread.pending_stop) resume_thread(thread);
+  }
+  state_ = process_state::running;
+  mem_cache_.clear();
+}
+
+void xdb::process::resume(pid_t tid) {
+  if (state_ == process_state::exited || state_ == process_state::terminated) {
+    error::send("Process has already terminated");
+  }
+  auto it = threads_.find(tid);
+  if (it == threads_.end()) {
+    error::send("No thread with id " + std::to_string(tid));
+  }
+  if (it->second.state != process_state::stopped) {
+    error::send("Thread " + std::to_string(tid) + " is already running");
   }
+  if (it->second.pending_stop) return;
+  resume_thread(it->second);
+  if (!non_stop_ || tid == current_tid_) {
+    state_ = process_state::running;
+  }
+  mem_cache_.clear();
 }
 
+/// Breakpoint hits that a condition or ignore count filters out are resumed
+/// here without returning, so a false hit costs one round trip to the
+/// kernel and whatever the condition reads. In non-stop mode only the thread
+/// that hit it is resumed.
 xdb::stop_reason xdb::process::wait_on_signal() {
-  int wait_status;
-  int options = 0;
-  if (waitpid(pid_, &wait_status, options) < 0) {
-    error::send_errno("Failed to waitpid");
-  }
-  stop_reason reason(wait_status);
-  state_ = reason.reason;
-  
-  if (is_attached_ && state_ == process_state::stopped) {
-    read_all_registers();
-  }
-  
+  auto reason = *wait_for_stop();
+  while (should_resume_from(reason)) {
+    non_stop_ ? resume(current_tid_) : resume();
+    reason = *wait_for_stop();
+  }
   return reason;
 }
 
-void xdb::process::read_all_registers() {
-  // read general purpose registers
-  if (ptrace(PTRACE_GETREGS, pid_, nullptr, &get_registers().data_.regs) < 0) {
-    error::send_errno("Could not read GPR registers");
+std::optional<xdb::stop_reason> xdb::process::wait_on_signal(std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  auto fd = sigchld_fd();
+  for (;;) {
+    // a SIGCHLD that comes after this is still queued for the poll below
+    if (auto reason = poll_stop()) return reason;
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0) return std::nullopt;
+    pollfd sigchld{ fd, POLLIN, 0 };
+    if (poll(&sigchld, 1, static_cast<int>(left.count())) < 0 && errno != EINTR) {
+      error::send_errno("Failed to poll for SIGCHLD");
+    }
+    drain_sigchld_fd();
   }
+}
 
-  // read floating point registers
-  if (ptrace(PTRACE_GETFPREGS, pid_, nullptr, &get_registers().data_.i387) < 0) {
-    error::send_errno("Could not read FPR registers");
+std::optional<xdb::stop_reason> xdb::process::poll_stop() {
+  auto reason = wait_for_stop(false);
+  while (reason && should_resume_from(*reason)) {
+    non_stop_ ? resume(current_tid_) : resume();
+    reason = wait_for_stop(false);
+  }
+  return reason;
+}
+
+void xdb::process::set_non_stop(bool on) {
+  if (non_stop_ && !on) {
+    interrupt();
+  }
+  non_stop_ = on;
+}
+
+void xdb::process::continue_thread(thread_state& thread) {
+  thread.regs->flush();
+  auto signal = reinterpret_cast<void*>(static_cast<long>(std::exchange(thread.pending_signal, 0)));
+  if (thread.stepping) {
+    // the step ends after the syscall, without an exit stop
+    if (thread.in_syscall) log_syscall(thread);
+    if (ptrace(PTRACE_SINGLESTEP, thread.tid, nullptr, signal) < 0) {
+      error::send_errno("Could not single step");
+    }
+  } else if (ptrace(thread.in_syscall ? PTRACE_SYSCALL : PTRACE_CONT, thread.tid, nullptr, signal) < 0) {
+    error::send_errno("Failed to PTRACE_CONT");
+  }
+  thread.state = process_state::running;
+  thread.reported = false;
+  thread.regs->invalidate();
+}
+
+void xdb::process::log_syscall(thread_state& thread) {
+  // a process that forked before the filter was installed has none
+  if (syscall_log_) *syscall_log_ << *thread.in_syscall;
+  thread.in_syscall.reset();
+}
+
+void xdb::process::resume_thread(thread_state& thread) {
+  if (thread.reported && !breakpoint_sites_.empty() && !step_over_breakpoint(thread)) {
+    return;
+  }
+  continue_thread(thread);
+}
+
+bool xdb::process::step_over_breakpoint(thread_state& thread) {
+  auto& regs = *thread.regs;
+  auto pc = virt_addr{ regs.read<register_id::rip>() };
+  if (!breakpoint_sites_.enabled_stoppoint_at_address(pc)) return true;
+  auto& site = breakpoint_sites_.get_by_address(pc);
+  if (site.is_hardware()) {
+    // the resume flag suppresses the instruction breakpoint for one
+    // instruction; the kernel already sets it when the breakpoint was hit
+    set_resume_flag(regs);
+    return true;
+  }
+
+  std::optional<virt_addr> copy;
+  if (step_over_strategy_ == step_over_strategy::displaced) {
+    copy = displaced_copy(thread, site);
+  }
+  if (copy) {
+    regs.write_by_id(register_id::rip, copy->addr());
+    return true;
+  }
+  // no other thread may run past the missing int3 while this one steps
+  bool stepped = false;
+  with_other_threads_stopped([&] {
+    site.disable();
+    regs.flush();
+    stepped = single_step_thread(thread);
+    auto status = stepped ? 0 : last_stashed_status(thread.tid);
+    if (WIFSTOPPED(status) && (status >> 16) == PTRACE_EVENT_EXEC) {
+      // the int3 went with the old image; handle_exec places the site again
+      // if it can
+      site.is_enabled_ = true;
+    } else {
+      try {
+        site.enable();
+      } catch (const error&) {
+        // the whole process went with the thread, and its memory with it
+        if (stepped) throw;
+      }
+    }
+    regs.invalidate();
+  });
+  return stepped;
+}
+
+/// The step goes without the signal, so the instruction runs before the
+/// handler does: a signal delivered with the step would run the handler
+/// with the instruction still ahead of it. Further signals on their way
+/// while one is already pending are sent again once the step is done.
+bool xdb::process::single_step_thread(thread_state& thread) {
+  std::vector<int> requeued;
+  auto requeue = [&] {
+    for (auto signo : requeued) syscall(SYS_tgkill, pid_, thread.tid, signo);
+  };
+  for (;;) {
+    int wait_status;
+    if (ptrace(PTRACE_SINGLESTEP, thread.tid, nullptr, nullptr) < 0) {
+      error::send_errno("Could not single step");
+    }
+    if (waitpid(thread.tid, &wait_status, __WALL) < 0) {
+      error::send_errno("waitpid failed");
+    }
+    if (!WIFSTOPPED(wait_status)) {
+      g_stashed_statuses.push_back({ thread.tid, pid_, wait_status });
+      thread.state = process_state::running;
+      return false;
+    }
+    auto signo = WSTOPSIG(wait_status);
+    auto event = wait_status >> 16;
+    // a stop we asked for earlier may come before the step
+    if (is_interrupt_stop(wait_status) && thread.pending_sigstop) {
+      thread.pending_sigstop = false;
+      continue;
+    }
+    // a seccomp stop comes before the syscall it selects runs; a fork, clone
+    // or exec event is wait_for_stop's to handle, and ends the step there
+    if (event == PTRACE_EVENT_SECCOMP) continue;
+    if (event != 0) {
+      g_stashed_statuses.push_back({ thread.tid, pid_, wait_status });
+      thread.state = process_state::running;
+      return false;
+    }
+    if (signo != SIGTRAP) {
+      if (!thread.pending_signal) {
+        thread.pending_signal = signo;
+      } else if (signo != thread.pending_signal) {
+        requeued.push_back(signo);
+      }
+      continue;
+    }
+    siginfo_t info;
+    if (ptrace(PTRACE_GETSIGINFO, thread.tid, nullptr, &info) < 0) {
+      error::send_errno("Failed to get signal info");
+    }
+    // the kernel's own trap: TRAP_TRACE, or TRAP_BRKPT for a step over a
+    // syscall instruction, which reports from the syscall's exit
+    if (info.si_code > 0) {
+      requeue();
+      return true;
+    }
+    // a SIGTRAP someone sent with kill or tgkill
+    if (!thread.pending_signal) thread.pending_signal = SIGTRAP;
+  }
+}
+
+template <class F>
+void xdb::process::with_other_threads_stopped(F f) {
+  std::vector<pid_t> stopped;
+  for (auto& [tid, thread] : threads_) {
+    if (thread.state == process_state::running) stopped.push_back(tid);
+  }
+  if (stopped.empty()) {
+    f();
+    return;
+  }
+
+  stop_running_threads();
+  if (state_ == process_state::exited || state_ == process_state::terminated) return;
+  auto restart = [&] {
+    for (auto tid : stopped) {
+      auto it = threads_.find(tid);
+      if (it != threads_.end() && it->second.state == process_state::stopped && !it->second.pending_stop) {
+        continue_thread(it->second);
+      }
+    }
+  };
+  try {
+    f();
+  } catch (...) {
+    restart();
+    throw;
+  }
+  restart();
+}
+
+xdb::thread_state& xdb::process::add_thread(pid_t tid, process_state state, bool pending_sigstop) {
+  auto& thread = threads_[tid];
+  // an untraced child only ever reports its exit, which wait_untraced hands out
+  if (is_attached_) g_thread_groups[tid] = pid_;
+  thread.tid = tid;
+  thread.state = state;
+  thread.pending_sigstop = pending_sigstop;
+  thread.regs.reset(new registers(*this, tid));
+  if (state == process_state::stopped) {
+    copy_debug_registers(thread);
+  } else {
+    thread.is_new = true;
+  }
+  return thread;
+}
+
+/// Debug registers aren't inherited by new threads, so each one gets ours
+/// at its first stop.
+void xdb::process::copy_debug_registers(thread_state& thread) {
+  thread.is_new = false;
+  if (hardware_control_ == 0) return;
+  for (int i = 0; i < 4; ++i) {
+    auto id = static_cast<register_id>(static_cast<int>(register_id::dr0) + i);
+    thread.regs->write_by_id(id, hardware_addresses_[i]);
+  }
+  thread.regs->write_by_id(register_id::dr7, hardware_control_);
+}
+
+std::optional<std::pair<pid_t, int>> xdb::process::next_wait_status(bool block) {
+  for (auto it = g_stashed_statuses.begin(); it != g_stashed_statuses.end(); ++it) {
+    if (threads_.count(it->tid) || it->tgid == pid_) {
+      auto ret = std::make_pair(it->tid, it->status);
+      g_stashed_statuses.erase(it);
+      return ret;
+    }
+  }
+  for (;;) {
+    int wait_status;
+    auto tid = waitpid(-1, &wait_status, __WALL | (block ? 0 : WNOHANG));
+    if (tid < 0) {
+      error::send_errno("Failed to waitpid");
+    }
+    if (tid == 0) return std::nullopt;
+    if (threads_.count(tid)) return std::make_pair(tid, wait_status);
+    // a thread whose creation we haven't heard about yet, or someone else's
+    auto tgid = thread_group_for(tid, wait_status);
+    if (tgid == pid_) return std::make_pair(tid, wait_status);
+    if (tgid == 0 && !WIFSTOPPED(wait_status)) {
+      g_unclaimed_exits[tid] = wait_status;
+      continue;
+    }
+    g_stashed_statuses.push_back({ tid, tgid, wait_status });
+  }
+}
+
+pid_t xdb::process::next_pending_thread_group(const std::function<bool(pid_t)>& wanted) {
+  for (;;) {
+    for (auto& stashed : g_stashed_statuses) {
+      if (stashed.tgid != 0 && wanted(stashed.tgid)) return stashed.tgid;
+    }
+    int wait_status;
+    auto tid = waitpid(-1, &wait_status, __WALL);
+    if (tid < 0) {
+      error::send_errno("Failed to waitpid");
+    }
+    auto tgid = thread_group_for(tid, wait_status);
+    if (tgid == 0 && !WIFSTOPPED(wait_status)) {
+      g_unclaimed_exits[tid] = wait_status;
+      continue;
+    }
+    g_stashed_statuses.push_back({ tid, tgid, wait_status });
+  }
+}
+
+pid_t xdb::process::wait_untraced(pid_t pid, int* status, int options) {
+  auto ret = waitpid(pid, status, options);
+  if (ret < 0 && errno == ECHILD) {
+    // asked only once the child is gone, so a stale entry for a reused pid
+    // is never handed out while its new owner still runs
+    if (auto it = g_unclaimed_exits.find(pid); it != g_unclaimed_exits.end()) {
+      if (status) *status = it->second;
+      g_unclaimed_exits.erase(it);
+      return pid;
+    }
+  }
+  return ret;
+}
+
+std::optional<xdb::stop_reason> xdb::process::filter_wait_status(pid_t tid, int wait_status) {
+  if (!threads_.count(tid)) {
+    // the first stop of a new thread, ahead of its creator's clone event
+    auto& thread = add_thread(tid, process_state::stopped, false);
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  auto& thread = threads_.at(tid);
+
+  if (WIFEXITED(wait_status) || WIFSIGNALED(wait_status)) {
+    if (thread.in_syscall) log_syscall(thread);
+    if (tid == pid_) return stop_reason(wait_status);
+    if (tid == current_tid_) {
+      set_current_thread(pid_);
+    }
+    threads_.erase(tid);
+    g_thread_groups.erase(tid);
+    return std::nullopt;
+  }
+
+  thread.state = process_state::stopped;
+  thread.regs->invalidate();
+  if (thread.is_new) copy_debug_registers(thread);
+  if ((wait_status >> 8) == (SIGTRAP | (PTRACE_EVENT_CLONE << 8))) {
+    unsigned long new_tid;
+    if (ptrace(PTRACE_GETEVENTMSG, tid, nullptr, &new_tid) < 0) {
+      error::send_errno("Could not read the new thread's id");
+    }
+    if (!threads_.count(new_tid)) {
+      add_thread(static_cast<pid_t>(new_tid), process_state::running, true);
+    }
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  auto event = wait_status >> 16;
+  if (WSTOPSIG(wait_status) == SIGTRAP && (event == PTRACE_EVENT_FORK || event == PTRACE_EVENT_VFORK)) {
+    unsigned long child_pid;
+    if (ptrace(PTRACE_GETEVENTMSG, tid, nullptr, &child_pid) < 0) {
+      error::send_errno("Could not read the new process's id");
+    }
+    // without a handler the child is detached again right here, once its
+    // inherited int3s are gone
+    auto child = make_child(static_cast<pid_t>(child_pid), event == PTRACE_EVENT_VFORK);
+    if (fork_handler_) {
+      child->terminated_on_end_ = terminated_on_end_;
+      fork_handler_(std::move(child));
+    }
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  if (WSTOPSIG(wait_status) == SIGTRAP && event == PTRACE_EVENT_EXEC) {
+    auto followed_objects = rendezvous_address_.has_value();
+    handle_exec();
+    // the new image's dynamic linker is followed from before it runs
+    if (followed_objects) get_objects();
+    if (keep_running()) continue_thread(threads_.at(pid_));
+    return std::nullopt;
+  }
+  if ((wait_status >> 8) == (SIGTRAP | (PTRACE_EVENT_SECCOMP << 8))) {
+    // the entry of a syscall the filter selected; continue_thread resumes it
+    // with PTRACE_SYSCALL to catch the exit
+    auto& regs = *thread.regs;
+    thread.in_syscall = syscall_record{
+      tid, static_cast<int>(regs.read<register_id::orig_rax>()),
+      { regs.read<register_id::rdi>(), regs.read<register_id::rsi>(), regs.read<register_id::rdx>(),
+        regs.read<register_id::r10>(), regs.read<register_id::r8>(), regs.read<register_id::r9>() },
+      std::nullopt
+    };
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  if (WSTOPSIG(wait_status) == (SIGTRAP | 0x80)) {
+    if (thread.in_syscall) {
+      thread.in_syscall->ret = static_cast<std::int64_t>(thread.regs->read<register_id::rax>());
+      log_syscall(thread);
+    }
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  if (is_interrupt_stop(wait_status) && thread.pending_sigstop) {
+    thread.pending_sigstop = false;
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  // a signal on its way to the thread; one that doesn't stop is delivered,
+  // or thrown away, on the spot
+  auto signo = WSTOPSIG(wait_status);
+  if (event == 0 && signo != SIGTRAP && signo != SIGSTOP) {
+    auto policy = signal_policies_[signo];
+    thread.pending_signal = policy == signal_policy::ignore ? 0 : signo;
+    if (policy == signal_policy::stop) return stop_reason(wait_status);
+    if (policy == signal_policy::print && signal_observer_) signal_observer_(tid, signo);
+    if (keep_running()) continue_thread(thread);
+    return std::nullopt;
+  }
+  return stop_reason(wait_status);
+}
+
+/// Asks every running thread to stop before waiting for any of them, so
+/// they stop in parallel. A thread that reports some other event first keeps
+/// its stop pending, to be swallowed when it is next resumed. That event is
+/// kept for wait_on_signal to report next, except that in all-stop mode a
+/// breakpoint hit is dropped and replayed: an int3's pc is wound back so the
+/// thread hits the breakpoint again when resumed.
+void xdb::process::stop_running_threads() {
+  stopping_threads_ = true;
+  struct reset_flag {
+    bool& flag;
+    ~reset_flag() { flag = false; }
+  } reset{ stopping_threads_ };
+
+  for (auto& [tid, thread] : threads_) request_stop(thread);
+
+  while (has_running_threads()) {
+    auto [tid, wait_status] = *next_wait_status();
+    auto reason = filter_wait_status(tid, wait_status);
+    if (!reason) continue;
+    if (reason->reason != process_state::stopped) {
+      // the whole process went away
+      state_ = reason->reason;
+      for (auto& [id, thread] : threads_) thread.state = state_;
+      return;
+    }
+    if (!non_stop_ && reason->info == SIGTRAP) {
+      // the thread's own breakpoint hit is dropped, and it hits it again
+      // when resumed: the pc goes back over the int3, or the resume flag the
+      // kernel set for a hardware breakpoint is cleared
+      siginfo_t info;
+      auto& regs = *threads_.at(tid).regs;
+      auto pc = virt_addr{ regs.read<register_id::rip>() };
+      if (ptrace(PTRACE_GETSIGINFO, tid, nullptr, &info) < 0) continue;
+      if (info.si_code == SI_KERNEL && breakpoint_sites_.enabled_stoppoint_at_address(pc - 1)) {
+        regs.write_by_id(register_id::rip, (pc - 1).addr());
+        continue;
+      }
+      if (info.si_code == TRAP_HWBKPT && breakpoint_sites_.enabled_stoppoint_at_address(pc)) {
+        constexpr std::uint64_t resume_flag = 1 << 16;
+        regs.write_by_id(register_id::eflags, regs.read<register_id::eflags>() & ~resume_flag);
+        continue;
+      }
+    }
+    // a watchpoint hit or a signal that stops can't be replayed
+    threads_.at(tid).pending_stop = reason;
+  }
+}
+
+void xdb::process::request_stop(thread_state& thread) {
+  if (thread.state != process_state::running || thread.pending_sigstop) return;
+  if (seized_) {
+    if (ptrace(PTRACE_INTERRUPT, thread.tid, nullptr, nullptr) < 0) {
+      error::send_errno("Could not interrupt thread");
+    }
+  } else if (syscall(SYS_tgkill, pid_, thread.tid, SIGSTOP) < 0) {
+    error::send_errno("Could not stop thread");
+  }
+  thread.pending_sigstop = true;
+}
+
+/// A seized thread reports PTRACE_INTERRUPT, and its first stop when the
+/// kernel attaches it, as a PTRACE_EVENT_STOP; others get a real SIGSTOP.
+bool xdb::process::is_interrupt_stop(int wait_status) const {
+  if (seized_) return (wait_status >> 16) == PTRACE_EVENT_STOP;
+  return WSTOPSIG(wait_status) == SIGSTOP;
+}
+
+void xdb::process::interrupt() {
+  if (!has_running_threads()) return;
+  stop_running_threads();
+  if (state_ == process_state::running) {
+    state_ = process_state::stopped;
+  }
+  ++stop_epoch_;
+  mem_cache_.clear();
+}
+
+bool xdb::process::has_running_threads() const {
+  return std::any_of(threads_.begin(), threads_.end(),
+                     [](auto& entry) { return entry.second.state == process_state::running; });
+}
+
+void xdb::process::set_current_thread(pid_t tid) {
+  auto it = threads_.find(tid);
+  if (it == threads_.end()) {
+    error::send("No thread with id " + std::to_string(tid));
+  }
+  current_tid_ = tid;
+  current_regs_ = it->second.regs.get();
+  if (non_stop_ && (state_ == process_state::stopped || state_ == process_state::running)) {
+    state_ = it->second.state;
+  }
+}
+
+xdb::registers& xdb::process::get_registers(pid_t tid) {
+  auto it = threads_.find(tid);
+  if (it == threads_.end()) {
+    error::send("No thread with id " + std::to_string(tid));
+  }
+  return *it->second.regs;
+}
+
+const xdb::registers& xdb::process::get_registers(pid_t tid) const {
+  return const_cast<process*>(this)->get_registers(tid);
+}
+
+/// Waits on all our threads with waitpid(-1, __WALL). Thread creation and
+/// exit are handled here without returning; the first thread to report
+/// anything else becomes the current thread, and in all-stop mode the rest
+/// are stopped.
+std::optional<xdb::stop_reason> xdb::process::wait_for_stop(bool block, pid_t only) {
+  std::optional<stop_reason> reason;
+  pid_t tid = 0;
+  for (auto& [id, thread] : threads_) {
+    if (thread.pending_stop && (!only || id == only)) {
+      tid = id;
+      reason = std::exchange(thread.pending_stop, std::nullopt);
+      break;
+    }
+  }
+  if (!reason && !block && !has_running_threads()) {
+    return std::nullopt;
+  }
+  if (!reason && block && non_stop_ && !has_running_threads()) {
+    error::send("No running threads to wait for");
+  }
+  while (!reason) {
+    auto status = next_wait_status(block);
+    if (!status) return std::nullopt;
+    tid = status->first;
+    reason = filter_wait_status(tid, status->second);
+    if (reason && only && tid != only && reason->reason == process_state::stopped) {
+      threads_.at(tid).pending_stop = std::exchange(reason, std::nullopt);
+    }
+  }
+
+  state_ = reason->reason;
+  ++stop_epoch_;
+  mem_cache_.clear();
+  // whoever looks at the stop may look at the log too
+  if (syscall_log_) syscall_log_->flush();
+  if (state_ != process_state::stopped) {
+    for (auto& [id, thread] : threads_) thread.state = state_;
+    return reason;
+  }
+
+  set_current_thread(tid);
+  threads_.at(tid).reported = true;
+  threads_.at(tid).stepping = false;
+  // the first stop is the only thread there is
+  if (!non_stop_ && is_attached_ && threads_.size() > 1) {
+    stop_running_threads();
+    if (state_ != process_state::stopped) return reason;
+  }
+  if (is_attached_ && reason->info == SIGTRAP) {
+    augment_stop_reason(*reason);
+  }
+  return reason;
+}
+
+std::array<xdb::signal_policy, NSIG> xdb::process::default_signal_policies() {
+  std::array<signal_policy, NSIG> policies;
+  policies.fill(signal_policy::stop);
+  // timers, profilers and job control that programs take in their stride
+  for (auto signo : { SIGALRM, SIGVTALRM, SIGPROF, SIGCHLD, SIGURG, SIGIO, SIGWINCH }) {
+    policies[signo] = signal_policy::pass;
+  }
+  return policies;
+}
+
+void xdb::process::set_signal_policy(int signo, signal_policy policy) {
+  if (signo <= 0 || signo >= NSIG) {
+    error::send("Invalid signal number " + std::to_string(signo));
   }
+  if ((signo == SIGTRAP || signo == SIGSTOP) && policy != signal_policy::stop) {
+    error::send("SIGTRAP and SIGSTOP always stop");
+  }
+  signal_policies_[signo] = policy;
+}
+
+xdb::signal_policy xdb::process::get_signal_policy(int signo) const {
+  if (signo <= 0 || signo >= NSIG) {
+    error::send("Invalid signal number " + std::to_string(signo));
+  }
+  return signal_policies_[signo];
+}
+
+bool xdb::process::should_resume_from(const stop_reason& reason) {
+  if (!reason.trap_reason) return false;
+
+  breakpoint_site* site = nullptr;
+  if (*reason.trap_reason == trap_type::software_break) {
+    auto pc = get_pc();
+    if (breakpoint_sites_.enabled_stoppoint_at_address(pc) && !breakpoint_sites_.get_by_address(pc).is_hardware()) {
+      site = &breakpoint_sites_.get_by_address(pc);
+    }
+  } else if (*reason.trap_reason == trap_type::hardware_break) {
+    auto id = get_current_hardware_stoppoint();
+    if (id.index() == 0) {
+      site = &breakpoint_sites_.get_by_id(std::get<0>(id));
+    }
+  }
+  if (!site) return false;
+  if (rendezvous_address_ && site->address() == *rendezvous_address_) update_shared_objects();
+  // one a child inherited from the middle of a step_out, say
+  if (site->is_internal()) return true;
+
+  if (site->condition_) {
+    try {
+      if (!site->condition_->evaluate(*this)) return true;
+    } catch (error&) {
+      // a condition that can't be evaluated stops, so the user sees why
+      return false;
+    }
+  }
+  ++site->hit_count_;
+  if (site->ignore_count_ > 0) {
+    --site->ignore_count_;
+    return true;
+  }
+  return false;
+}
+
+void xdb::process::set_resume_flag(registers& regs) {
+  constexpr std::uint64_t resume_flag = 1 << 16;
+  auto flags = regs.read<register_id::eflags>();
+  if (!(flags & resume_flag)) {
+    regs.write_by_id(register_id::eflags, flags | resume_flag);
+  }
+}
+
+void xdb::process::augment_stop_reason(stop_reason& reason) {
+  siginfo_t info;
+  if (ptrace(PTRACE_GETSIGINFO, current_tid_, nullptr, &info) < 0) {
+    error::send_errno("Failed to get signal info");
+  }
+
+  reason.trap_reason = trap_type::unknown;
+  if (info.si_code == TRAP_TRACE) {
+    reason.trap_reason = trap_type::single_step;
+  } else if (info.si_code == SI_KERNEL) {
+    reason.trap_reason = trap_type::software_break;
+    // after an int3 the pc is one past the breakpoint; move it back so the
+    // stop shows the breakpoint address and resume() knows to step over it
+    auto instr_begin = get_pc() - 1;
+    if (breakpoint_sites_.enabled_stoppoint_at_address(instr_begin) &&
+        !breakpoint_sites_.get_by_address(instr_begin).is_hardware()) {
+      current_regs_->write_by_id(register_id::rip, instr_begin.addr());
+    }
+  } else if (info.si_code == TRAP_HWBKPT) {
+    reason.trap_reason = trap_type::hardware_break;
+    auto id = get_current_hardware_stoppoint();
+    if (id.index() == 1) {
+      watchpoints_.get_by_id(std::get<1>(id)).update_data();
+    }
+  }
+}
+
+xdb::stop_reason xdb::process::step_instruction() {
+  auto& thread = threads_.at(current_tid_);
+  if (thread.state != process_state::stopped) {
+    error::send("Thread " + std::to_string(current_tid_) + " is running");
+  }
+  breakpoint_site* to_reenable = nullptr;
+  auto pc = get_pc();
+  if (breakpoint_sites_.enabled_stoppoint_at_address(pc)) {
+    auto& site = breakpoint_sites_.get_by_address(pc);
+    if (site.is_hardware()) {
+      set_resume_flag(*current_regs_);
+    } else {
+      to_reenable = &site;
+    }
+  }
+
+  // only the current thread runs
+  std::optional<stop_reason> reason;
+  auto step = [&] {
+    if (to_reenable) to_reenable->disable();
+    thread.stepping = true;
+    continue_thread(thread);
+    state_ = process_state::running;
+    reason = wait_for_stop(true, current_tid_);
+    if (to_reenable && state_ == process_state::stopped) {
+      to_reenable->enable();
+    }
+  };
+  if (to_reenable) {
+    with_other_threads_stopped(step);
+  } else {
+    step();
+  }
+  return *reason;
+}
 
-  // read debug registers
-  for (int i = 0; i < 8; ++i) {
-    auto id = static_cast<int>(register_id::dr0) + i;
-    auto info = register_info_by_id(static_cast<register_id>(id));
+/// Stepping after a reported stop goes through step_instruction, which steps
+/// over a breakpoint under the pc. Every other step skips wait_for_stop: it
+/// waits on the one thread, and a stop that isn't a plain single-step trap is
+/// stashed for wait_for_stop to take apart the usual way.
+xdb::step_result xdb::process::step_instructions(std::uint64_t count, const std::function<bool()>& until) {
+  if (count == 0) {
+    error::send("Step count must be positive");
+  }
+  auto tid = current_tid_;
+  std::uint64_t steps = 0;
+  bool step_over = true;
+  for (;;) {
+    std::optional<stop_reason> reason;
+    if (step_over) {
+      reason = step_instruction();
+    } else {
+      auto& thread = threads_.at(tid);
+      thread.stepping = true;
+      continue_thread(thread);
+      int wait_status;
+      if (waitpid(tid, &wait_status, __WALL) < 0) {
+        error::send_errno("waitpid failed");
+      }
+      siginfo_t info;
+      if (WIFSTOPPED(wait_status) && WSTOPSIG(wait_status) == SIGTRAP && (wait_status >> 16) == 0 &&
+          ptrace(PTRACE_GETSIGINFO, tid, nullptr, &info) == 0 && info.si_code == TRAP_TRACE) {
+        thread.state = process_state::stopped;
+        thread.reported = true;
+        thread.stepping = false;
+        ++stop_epoch_;
+        mem_cache_.clear();
+        reason.emplace(wait_status);
+        reason->trap_reason = trap_type::single_step;
+      } else {
+        state_ = process_state::running;
+        g_stashed_statuses.push_back({ tid, pid_, wait_status });
+        reason = wait_for_stop(true, tid);
+      }
+    }
 
-    errno = 0;
-    std::int64_t data = ptrace(PTRACE_PEEKUSER, pid_, info.offset, nullptr);
-    if (errno != 0) {
-      error::send_errno("Could not read debug register");
+    if (reason->reason != process_state::stopped) return { *reason, steps };
+    if (reason->trap_reason == trap_type::single_step) {
+      ++steps;
+      step_over = false;
+      if (steps < count && !(until && until())) continue;
+    } else if (should_resume_from(*reason)) {
+      // a breakpoint whose condition or ignore count lets it go
+      step_over = true;
+      continue;
     }
+    if (syscall_log_) syscall_log_->flush();
+    return { *reason, steps };
+  }
+}
+
+void xdb::process::read_gprs(pid_t tid, user_regs_struct& gprs) const {
+  if (ptrace(PTRACE_GETREGS, tid, nullptr, &gprs) < 0) {
+    error::send_errno("Could not read GPR registers");
+  }
+}
+
+void xdb::process::read_fprs(pid_t tid, user_fpregs_struct& fprs) const {
+  if (ptrace(PTRACE_GETFPREGS, tid, nullptr, &fprs) < 0) {
+    error::send_errno("Could not read FPR registers");
+  }
+}
 
-    get_registers().data_.u_debugreg[i] = data;
+std::uint64_t xdb::process::read_user_area(pid_t tid, std::size_t offset) const {
+  errno = 0;
+  std::int64_t data = ptrace(PTRACE_PEEKUSER, tid, offset, nullptr);
+  if (errno != 0) {
+    error::send_errno("Could not read user area");
   }
+  return data;
 }
 
-void xdb::process::write_user_area(std::size_t offset, std::uint64_t data) {
-  if (ptrace(PTRACE_POKEUSER, pid_, offset, data) < 0) {
+void xdb::process::write_user_area(pid_t tid, std::size_t offset, std::uint64_t data) {
+  if (ptrace(PTRACE_POKEUSER, tid, offset, data) < 0) {
     error::send_errno("Could not write to user area");
   }
 }
 
-void xdb::process::write_fprs(const user_fpregs_struct& fprs) {
-  if (ptrace(PTRACE_SETFPREGS, pid_, nullptr, &fprs) < 0) {
+void xdb::process::write_fprs(pid_t tid, const user_fpregs_struct& fprs) {
+  if (ptrace(PTRACE_SETFPREGS, tid, nullptr, &fprs) < 0) {
     error::send_errno("Could not write FPR registers");
   }
 }
 
-void xdb::process::write_gprs(const user_regs_struct& gprs) {
-  if (ptrace(PTRACE_SETREGS, pid_, nullptr, &gprs) < 0) {
+void xdb::process::write_gprs(pid_t tid, const user_regs_struct& gprs) {
+  if (ptrace(PTRACE_SETREGS, tid, nullptr, &gprs) < 0) {
     error::send_errno("Could not write GPR registers");
   }
 }
 
-xdb::breakpoint_site& xdb::process::create_breakpoint_site(xdb::virt_addr addr) {
-  auto site = std::unique_ptr<breakpoint_site>(new breakpoint_site(*this, addr));
+xdb::breakpoint_site& xdb::process::create_breakpoint_site(xdb::virt_addr addr, bool hardware, bool internal) {
+  if (breakpoint_sites_.contains(addr)) {
+    error::send("Breakpoint site already created at address " + std::to_string(addr.addr()));
+  }
+  // an exec moves sites relative to where the executable was
+  executable_range();
+  auto site = std::unique_ptr<breakpoint_site>(new breakpoint_site(*this, addr, hardware, internal));
   return breakpoint_sites_.push(std::move(site));
 }
 
+const xdb::process::executable_mapping& xdb::process::executable_range() {
+  if (executable_) return *executable_;
+  auto exe = "/proc/" + std::to_string(pid_) + "/exe";
+  struct stat info;
+  std::error_code ec;
+  auto path = std::filesystem::read_symlink(exe, ec);
+  if (ec || stat(exe.c_str(), &info) < 0) {
+    error::send("Could not find the executable of process " + std::to_string(pid_));
+  }
+
+  // start-end perms offset device inode path
+  executable_mapping range{ virt_addr{ UINT64_MAX }, virt_addr{ 0 }, info.st_dev, info.st_ino };
+  std::ifstream maps("/proc/" + std::to_string(pid_) + "/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    auto name = line.find('/');
+    if (name == std::string::npos || line.compare(name, std::string::npos, path.string()) != 0) continue;
+    auto dash = line.find('-');
+    auto start = virt_addr{ std::stoull(line.substr(0, dash), nullptr, 16) };
+    auto end = virt_addr{ std::stoull(line.substr(dash + 1), nullptr, 16) };
+    range.start = std::min(range.start, start);
+    range.end = std::max(range.end, end);
+  }
+  executable_ = range;
+  return *executable_;
+}
+
+xdb::elf& xdb::process::get_elf() {
+  if (elf_) return *elf_;
+  // the link still opens the file when it has been deleted or replaced
+  auto elf = std::make_unique<xdb::elf>("/proc/" + std::to_string(pid_) + "/exe");
+  elf->notify_loaded(executable_range().start);
+  elf_ = std::move(elf);
+  return *elf_;
+}
+
+const xdb::dwarf& xdb::process::get_dwarf() {
+  if (!dwarf_) dwarf_ = std::make_unique<xdb::dwarf>(get_elf());
+  return *dwarf_;
+}
+
+const xdb::symbol_index& xdb::process::get_symbol_index() {
+  if (!symbol_index_) {
+    symbol_index_ = symbol_cache_dir_ ? symbol_index::load(get_elf(), *symbol_cache_dir_)
+                                      : symbol_index::build(get_elf());
+  }
+  return *symbol_index_;
+}
 
+xdb::object_map& xdb::process::get_objects() {
+  if (!objects_) {
+    objects_ = std::make_unique<object_map>(pid_, 0, symbol_cache_dir_);
+    track_shared_objects();
+    // breakpoints left pending by an exec may be in what is mapped already
+    if (!pending_breakpoints_.empty()) {
+      std::vector<const loaded_object*> mapped;
+      for (auto& object : objects_->objects()) mapped.push_back(object.get());
+      resolve_pending_breakpoints(mapped);
+    }
+  }
+  return *objects_;
+}
 
+namespace {
+  // where the kernel loaded the program interpreter, from the auxiliary
+  // vector; 0 for a static executable
+  std::uint64_t interpreter_base(pid_t pid) {
+    std::ifstream auxv("/proc/" + std::to_string(pid) + "/auxv", std::ios::binary);
+    Elf64_auxv_t entry;
+    while (auxv.read(reinterpret_cast<char*>(&entry), sizeof(entry)) && entry.a_type != AT_NULL) {
+      if (entry.a_type == AT_BASE) return entry.a_un.a_val;
+    }
+    return 0;
+  }
+
+  // a list that loops back on itself is cut off here
+  constexpr std::size_t max_linked_objects = 1 << 16;
+}
+
+/// At a launch's exec stop the dynamic linker is mapped but hasn't run, so
+/// r_debug isn't set up yet and DT_DEBUG is still 0; _dl_debug_state is the
+/// function r_brk will point to. Failing to find either leaves objects_ as
+/// the maps had it.
+void xdb::process::track_shared_objects() {
+  try {
+    r_debug_address_ = find_r_debug();
+    if (r_debug_address_) {
+      rendezvous_address_ = virt_addr{ read_memory_as<r_debug>(*r_debug_address_).r_brk };
+    } else if (auto linker = objects_->object_containing_address(virt_addr{ interpreter_base(pid_) })) {
+      if (auto symbol = linker->get_index().symbol_by_name("_dl_debug_state")) {
+        rendezvous_address_ = virt_addr{ symbol->st_value + linker->get_elf().load_bias() };
+      }
+    }
+    if (!rendezvous_address_) return;
+    // a forked child inherits its parent's
+    if (!breakpoint_sites_.contains(*rendezvous_address_)) {
+      create_breakpoint_site(*rendezvous_address_, false, true).enable();
+    }
+    update_shared_objects();
+  } catch (const error&) {
+    rendezvous_address_.reset();
+  }
+}
+
+std::optional<xdb::virt_addr> xdb::process::find_r_debug() {
+  auto& executable = get_elf();
+  for (auto& segment : executable.segments()) {
+    if (segment.p_type != PT_DYNAMIC) continue;
+    auto dynamic = read_memory(virt_addr{ segment.p_vaddr + executable.load_bias() }, segment.p_memsz);
+    auto entries = reinterpret_cast<const Elf64_Dyn*>(dynamic.data());
+    for (std::size_t i = 0; i < dynamic.size() / sizeof(Elf64_Dyn) && entries[i].d_tag != DT_NULL; ++i) {
+      if (entries[i].d_tag == DT_DEBUG && entries[i].d_un.d_ptr != 0) return virt_addr{ entries[i].d_un.d_ptr };
+    }
+  }
+  return std::nullopt;
+}
+
+/// The linker calls r_brk with r_state at RT_ADD or RT_DELETE before it
+/// changes the list, and at RT_CONSISTENT once it is done, so every dlopen
+/// and dlclose is seen between two consistent lists. Entries already seen are
+/// known by their l_ld, which is unique among loaded objects, so only the new
+/// ones are looked at, and only those not already in the maps read at the
+/// start have their name read and are added. Only the base namespace is followed, not the ones
+/// dlmopen makes.
+void xdb::process::update_shared_objects() {
+  if (!objects_) return;
+  if (!r_debug_address_) r_debug_address_ = find_r_debug();
+  if (!r_debug_address_) return;
+  auto debug = read_memory_as<r_debug>(*r_debug_address_);
+  if (debug.r_state != r_debug::RT_CONSISTENT) return;
+
+  struct entry {
+    std::uint64_t dynamic;
+    std::uint64_t load_bias;
+    std::uint64_t name;
+  };
+  std::vector<entry> fresh;
+  std::unordered_map<std::uint64_t, std::optional<virt_addr>> linked;
+  auto next = reinterpret_cast<std::uint64_t>(debug.r_map);
+  for (std::size_t n = 0; next != 0 && n < max_linked_objects; ++n) {
+    auto map = read_memory_as<link_map>(virt_addr{ next });
+    next = reinterpret_cast<std::uint64_t>(map.l_next);
+    auto dynamic = reinterpret_cast<std::uint64_t>(map.l_ld);
+    if (auto known = linked_objects_.find(dynamic); known != linked_objects_.end()) {
+      linked.insert(*known);
+    } else {
+      fresh.push_back({ dynamic, map.l_addr, reinterpret_cast<std::uint64_t>(map.l_name) });
+    }
+  }
+  for (auto& [dynamic, start] : linked_objects_) {
+    if (!start || linked.count(dynamic)) continue;
+    if (auto object = objects_->object_containing_address(*start)) {
+      unload_breakpoint_sites(object->start(), object->end());
+    }
+    objects_->remove(*start);
+  }
+
+  std::vector<const loaded_object*> added;
+  for (auto& entry : fresh) {
+    auto& start = linked[entry.dynamic];
+    if (auto object = objects_->object_containing_address(virt_addr{ entry.dynamic })) {
+      start = object->start();
+      continue;
+    }
+    std::string name;
+    for (auto address = virt_addr{ entry.name }; entry.name != 0 && name.size() < PATH_MAX;) {
+      // up to the end of the page, which is as far as it is sure to be mapped
+      auto chunk = read_memory(address, page_size - (address.addr() & (page_size - 1)));
+      auto text = reinterpret_cast<const char*>(chunk.data());
+      auto length = strnlen(text, chunk.size());
+      name.append(text, length);
+      if (length < chunk.size()) break;
+      address += chunk.size();
+    }
+    // the vdso's name isn't a path; a relative one is from the working
+    // directory dlopen was called in
+    if (name.find('/') == std::string::npos) continue;
+    std::filesystem::path path = name;
+    if (path.is_relative()) {
+      std::error_code ec;
+      path = std::filesystem::read_symlink("/proc/" + std::to_string(pid_) + "/cwd", ec) / path;
+    }
+    try {
+      auto& object = objects_->add(path, virt_addr{ entry.load_bias });
+      start = object.start();
+      added.push_back(&object);
+    } catch (const error&) {
+      // a file gone since it was opened, say; there's nothing to load
+    }
+  }
+  linked_objects_ = std::move(linked);
+  resolve_pending_breakpoints(added);
+}
+
+/// The object's code is unmapped, int3s and all, so its sites are marked
+/// disabled without writing to it. Those made for a symbol are removed, and
+/// the symbol goes back to pending to resolve in the next object defining it.
+void xdb::process::unload_breakpoint_sites(virt_addr low, virt_addr high) {
+  for (auto site : breakpoint_sites_.get_in_range(low, high)) {
+    // the debug registers don't go with the code
+    if (site->is_hardware()) site->disable();
+    site->is_enabled_ = false;
+    displaced_copies_.erase(site->id());
+    if (auto it = symbol_sites_.find(site->id()); it != symbol_sites_.end()) {
+      pending_breakpoints_.push_back(std::move(it->second));
+      symbol_sites_.erase(it);
+      breakpoint_sites_.remove_by_id(site->id());
+    }
+  }
+}
+
+void xdb::process::resolve_pending_breakpoints(const std::vector<const loaded_object*>& added) {
+  for (auto it = pending_breakpoints_.begin(); it != pending_breakpoints_.end();) {
+    breakpoint_site* site = nullptr;
+    for (auto object : added) {
+      try {
+        if (auto symbol = object->get_index().symbol_by_name(it->symbol)) {
+          site = &create_breakpoint_site(virt_addr{ symbol->st_value + object->get_elf().load_bias() }, it->hardware);
+          break;
+        }
+      } catch (const error&) {
+      }
+    }
+    if (!site) {
+      ++it;
+      continue;
+    }
+    site->enable();
+    auto symbol = it->symbol;
+    symbol_sites_[site->id()] = std::move(*it);
+    it = pending_breakpoints_.erase(it);
+    if (resolve_observer_) resolve_observer_(symbol, *site);
+  }
+}
+
+xdb::breakpoint_site* xdb::process::create_breakpoint_at_symbol(std::string name, bool hardware) {
+  if (auto match = get_objects().symbol_by_name(name)) {
+    auto& site = create_breakpoint_site(
+        virt_addr{ match->symbol->st_value + match->object->get_elf().load_bias() }, hardware);
+    site.enable();
+    symbol_sites_[site.id()] = { std::move(name), hardware };
+    return &site;
+  }
+  pending_breakpoints_.push_back({ std::move(name), hardware });
+  return nullptr;
+}
+
+void xdb::process::remove_breakpoint_at_symbol(std::string_view symbol) {
+  auto it = std::find_if(pending_breakpoints_.begin(), pending_breakpoints_.end(),
+                         [&](auto& pending) { return pending.symbol == symbol; });
+  if (it != pending_breakpoints_.end()) {
+    pending_breakpoints_.erase(it);
+    return;
+  }
+  auto placed = std::find_if(symbol_sites_.begin(), symbol_sites_.end(),
+                             [&](auto& entry) { return entry.second.symbol == symbol; });
+  if (placed == symbol_sites_.end()) error::send("No breakpoint on " + std::string(symbol));
+  remove_breakpoint_site(placed->first);
+}
+
+void xdb::process::remove_breakpoint_site(breakpoint_site::id_t id) {
+  breakpoint_sites_.remove_by_id(id);
+  symbol_sites_.erase(id);
+}
+
+/// A forked child has a copy of our memory, int3s included, so it gets
+/// copies of our sites with the same ids; debug registers aren't inherited,
+/// so its threads get ours at their first stop. A vfork child shares our
+/// memory until it execs or exits, and gets no sites: they are ours. The
+/// child is detached when dropped, its sites disabled first; the fork
+/// handler's copy is then given our terminated_on_end_.
+std::unique_ptr<xdb::process> xdb::process::make_child(pid_t pid, bool vfork) {
+  std::unique_ptr<process> child(new process(pid, false, true));
+  child->seized_ = seized_;
+  child->non_stop_ = non_stop_;
+  child->step_over_strategy_ = step_over_strategy_;
+  child->fork_handler_ = fork_handler_;
+  child->signal_policies_ = signal_policies_;
+  child->signal_observer_ = signal_observer_;
+  child->syscall_log_ = syscall_log_;
+  child->executable_ = executable_;
+  child->state_ = process_state::running;
+  // its first stop comes from the kernel attaching it
+  auto& leader = child->threads_.at(pid);
+  leader.state = process_state::running;
+  leader.pending_sigstop = true;
+  leader.is_new = true;
+  if (vfork) return child;
+
+  breakpoint_sites_.for_each([&](breakpoint_site& site) {
+    auto copy = std::unique_ptr<breakpoint_site>(new breakpoint_site(*child, site.addr_, site.is_hardware_, site.is_internal_));
+    copy->id_ = site.id_;
+    copy->is_enabled_ = site.is_enabled_;
+    copy->hardware_register_index_ = site.hardware_register_index_;
+    copy->data_ = site.data_;
+    copy->condition_ = site.condition_;
+    copy->ignore_count_ = site.ignore_count_;
+    child->breakpoint_sites_.push(std::move(copy));
+  });
+  watchpoints_.for_each([&](watchpoint& point) {
+    auto copy = std::unique_ptr<watchpoint>(new watchpoint(*child, point.address_, point.mode_, point.size_));
+    copy->id_ = point.id_;
+    copy->is_enabled_ = point.is_enabled_;
+    copy->hardware_register_index_ = point.hardware_register_index_;
+    copy->data_ = point.data_;
+    copy->previous_data_ = point.previous_data_;
+    child->watchpoints_.push(std::move(copy));
+  });
+  child->hardware_addresses_ = hardware_addresses_;
+  child->hardware_control_ = hardware_control_;
+  return child;
+}
+
+/// The new image has replaced everything: threads other than the one that
+/// called exec are gone (it now has the leader's tid), as is everything we
+/// put into memory and the debug registers. When the executable is the same
+/// file again, as for a server re-executing itself, sites inside it move by
+/// however far its load address moved and are enabled again; the others
+/// can't be placed, and are left disabled, unless one is in the way of a
+/// moved site. Sites made for a symbol go back to pending, to be placed by
+/// it in the new image.
+void xdb::process::handle_exec() {
+  for (auto it = threads_.begin(); it != threads_.end();) {
+    if (it->first == pid_) {
+      ++it;
+      continue;
+    }
+    g_thread_groups.erase(it->first);
+    it = threads_.erase(it);
+  }
+  set_current_thread(pid_);
+
+  if (mem_fd_ != -1) {
+    close(mem_fd_);
+    mem_fd_ = -1;
+  }
+  mem_cache_.clear();
+  scratch_blocks_.clear();
+  displaced_copies_.clear();
+  trace_buffer_.reset();
+  objects_.reset();
+  linked_objects_.clear();
+  r_debug_address_.reset();
+  // its int3 went with the old image
+  if (auto old = std::exchange(rendezvous_address_, std::nullopt); old && breakpoint_sites_.contains(*old)) {
+    auto& site = breakpoint_sites_.get_by_address(*old);
+    site.is_enabled_ = false;
+    if (site.is_internal()) breakpoint_sites_.remove_by_address(*old);
+  }
+  symbol_index_.reset();
+  dwarf_.reset();
+  elf_.reset();
+  tracepoints_.for_each([](tracepoint& point) {
+    point.is_enabled_ = false;
+    point.trampoline_.reset();
+    point.original_code_.clear();
+  });
+  hardware_addresses_ = {};
+  hardware_control_ = 0;
+  watchpoints_.for_each([](watchpoint& point) {
+    point.is_enabled_ = false;
+    point.hardware_register_index_ = -1;
+  });
+
+  for (auto& [id, pending] : symbol_sites_) {
+    if (breakpoint_sites_.contains(id)) {
+      breakpoint_sites_.get_by_id(id).is_enabled_ = false;
+      breakpoint_sites_.remove_by_id(id);
+    }
+    pending_breakpoints_.push_back(std::move(pending));
+  }
+  symbol_sites_.clear();
+
+  auto old = std::exchange(executable_, std::nullopt);
+  if (breakpoint_sites_.empty()) return;
+  auto& now = executable_range();
+  bool same_file = old && old->device == now.device && old->inode == now.inode;
+  if (same_file) {
+    // addresses must stay distinct, so a site left behind where one moves to
+    // is dropped
+    std::vector<breakpoint_site::id_t> in_the_way;
+    for (auto site : breakpoint_sites_.get_in_range(now.start, now.end)) {
+      auto from = virt_addr{ old->start.addr() + (site->addr_.addr() - now.start.addr()) };
+      if (!(site->addr_ >= old->start && site->addr_ < old->end) && breakpoint_sites_.contains(from)) {
+        in_the_way.push_back(site->id());
+      }
+    }
+    for (auto id : in_the_way) {
+      breakpoint_sites_.get_by_id(id).is_enabled_ = false;
+      breakpoint_sites_.remove_by_id(id);
+    }
+  }
+  std::vector<breakpoint_site*> moved;
+  breakpoint_sites_.for_each([&](breakpoint_site& site) {
+    bool was_enabled = site.is_enabled_;
+    site.is_enabled_ = false;
+    site.hardware_register_index_ = -1;
+    if (same_file && site.addr_ >= old->start && site.addr_ < old->end) {
+      site.addr_ = now.start + (site.addr_.addr() - old->start.addr());
+      if (was_enabled) moved.push_back(&site);
+    }
+  });
+  breakpoint_sites_.reindex();
+  enable_breakpoint_sites(std::move(moved));
+}
+
+xdb::watchpoint& xdb::process::create_watchpoint(virt_addr address, stoppoint_mode mode, std::size_t size) {
+  if (watchpoints_.contains(address)) {
+    error::send("Watchpoint already created at address " + std::to_string(address.addr()));
+  }
+  auto point = std::unique_ptr<watchpoint>(new watchpoint(*this, address, mode, size));
+  return watchpoints_.push(std::move(point));
+}
+
+int xdb::process::set_hardware_breakpoint(virt_addr address) {
+  return set_hardware_stoppoint(address, stoppoint_mode::execute, 1);
+}
+
+int xdb::process::set_watchpoint(virt_addr address, stoppoint_mode mode, std::size_t size) {
+  return set_hardware_stoppoint(address, mode, size);
+}
+
+namespace {
+  std::uint64_t encode_hardware_stoppoint_mode(xdb::stoppoint_mode mode) {
+    switch (mode) {
+      case xdb::stoppoint_mode::write: return 0b01;
+      case xdb::stoppoint_mode::read_write: return 0b11;
+      case xdb::stoppoint_mode::execute: return 0b00;
+    }
+    xdb::error::send("Invalid stoppoint mode");
+  }
+
+  std::uint64_t encode_hardware_stoppoint_size(std::size_t size) {
+    switch (size) {
+      case 1: return 0b00;
+      case 2: return 0b01;
+      case 4: return 0b11;
+      case 8: return 0b10;
+    }
+    xdb::error::send("Invalid stoppoint size");
+  }
+
+  // a slot is free while its local and global enable bits in dr7 are clear
+  int find_free_stoppoint_register(std::uint64_t control_register) {
+    for (int i = 0; i < 4; ++i) {
+      if ((control_register & (0b11 << (i * 2))) == 0) {
+        return i;
+      }
+    }
+    xdb::error::send("No remaining hardware debug registers");
+  }
+
+  xdb::register_id debug_register(int index) {
+    return static_cast<xdb::register_id>(static_cast<int>(xdb::register_id::dr0) + index);
+  }
+}
+
+/// dr7 holds, for slot i, an enable bit at 2i and the mode and length at
+/// 16 + 4i and 18 + 4i. The debug registers are per thread, so we keep the
+/// values in hardware_addresses_ and hardware_control_ and write them to every
+/// thread; the writes only reach the inferior on resume, and the flush writes
+/// dr0-dr3 before dr7.
+int xdb::process::set_hardware_stoppoint(virt_addr address, stoppoint_mode mode, std::size_t size) {
+  if (mode == stoppoint_mode::execute && size != 1) {
+    error::send("Hardware breakpoints must have size 1");
+  }
+  auto index = find_free_stoppoint_register(hardware_control_);
+  hardware_addresses_[index] = address.addr();
+
+  auto enable_bit = std::uint64_t{ 1 } << (index * 2);
+  auto mode_bits = encode_hardware_stoppoint_mode(mode) << (index * 4 + 16);
+  auto size_bits = encode_hardware_stoppoint_size(size) << (index * 4 + 18);
+  auto clear_mask = (std::uint64_t{ 0b11 } << (index * 2)) | (std::uint64_t{ 0b1111 } << (index * 4 + 16));
+  hardware_control_ = (hardware_control_ & ~clear_mask) | enable_bit | mode_bits | size_bits;
+  with_other_threads_stopped([&] {
+    for (auto& [tid, thread] : threads_) {
+      if (thread.is_new) continue;
+      thread.regs->write_by_id(debug_register(index), address.addr());
+      thread.regs->write_by_id(register_id::dr7, hardware_control_);
+    }
+  });
+  return index;
+}
+
+void xdb::process::clear_hardware_stoppoint(int index) {
+  hardware_addresses_[index] = 0;
+  auto clear_mask = (std::uint64_t{ 0b11 } << (index * 2)) | (std::uint64_t{ 0b1111 } << (index * 4 + 16));
+  hardware_control_ &= ~clear_mask;
+  with_other_threads_stopped([&] {
+    for (auto& [tid, thread] : threads_) {
+      if (thread.is_new) continue;
+      thread.regs->write_by_id(debug_register(index), std::uint64_t{ 0 });
+      thread.regs->write_by_id(register_id::dr7, hardware_control_);
+    }
+  });
+}
+
+std::variant<xdb::breakpoint_site::id_t, xdb::watchpoint::id_t> xdb::process::get_current_hardware_stoppoint() const {
+  auto status = current_regs_->read<register_id::dr6>();
+  int index = -1;
+  for (int i = 0; i < 4; ++i) {
+    if (status & (1 << i)) {
+      index = i;
+      break;
+    }
+  }
+  if (index < 0) {
+    error::send("No hardware stoppoint hit");
+  }
+
+  std::variant<breakpoint_site::id_t, watchpoint::id_t> ret;
+  bool found = false;
+  breakpoint_sites_.for_each([&](auto& site) {
+    if (site.is_hardware() && site.is_enabled() && site.hardware_register_index_ == index) {
+      ret.emplace<0>(site.id());
+      found = true;
+    }
+  });
+  watchpoints_.for_each([&](auto& point) {
+    if (point.is_enabled() && point.hardware_register_index_ == index) {
+      ret.emplace<1>(point.id());
+      found = true;
+    }
+  });
+  if (!found) {
+    error::send("Hardware stoppoint hit in an unused slot");
+  }
+  return ret;
+}
+
+int xdb::process::mem_fd() const {
+  if (mem_fd_ == -1) {
+    auto path = "/proc/" + std::to_string(pid_) + "/mem";
+    mem_fd_ = open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (mem_fd_ < 0) {
+      error::send_errno("Could not open " + path);
+    }
+  }
+  return mem_fd_;
+}
+
+void xdb::process::read_proc_mem(virt_addr address, std::byte* data, std::size_t size) const {
+  auto ret = pread(mem_fd(), data, size, address.addr());
+  if (ret < 0) {
+    error::send_errno("Could not read process memory");
+  }
+  // a short count leaves errno as it was
+  if (static_cast<std::size_t>(ret) != size) {
+    error::send("Short read of process memory at address " + std::to_string(address.addr()));
+  }
+}
+
+void xdb::process::write_proc_mem(virt_addr address, const std::byte* data, std::size_t size) {
+  auto ret = pwrite(mem_fd(), data, size, address.addr());
+  if (ret < 0) {
+    error::send_errno("Could not write process memory");
+  }
+  // a short count leaves errno as it was
+  if (static_cast<std::size_t>(ret) != size) {
+    error::send("Short write of process memory at address " + std::to_string(address.addr()));
+  }
+}
+
+namespace {
+  // Moves [address, address + size) with a process_vm_readv/writev-like call
+  // in batches of up to IOV_MAX pages. The remote side is split at page
+  // boundaries so that a short transfer stops exactly at the first page it
+  // couldn't access; that page then goes through the fallback. The batch is
+  // built on the stack, so small reads don't allocate.
+  template <class Transfer, class Fallback>
+  void transfer_pages(xdb::virt_addr address, std::byte* data, std::size_t size, Transfer transfer, Fallback fallback) {
+    std::array<iovec, IOV_MAX> remote;
+    std::size_t done = 0;
+    while (done < size) {
+      std::size_t count = 0;
+      std::size_t batch_size = 0;
+      for (auto addr = address + done, end = address + size; addr < end && count < remote.size(); ++count) {
+        auto up_to_next_page = xdb::page_size - (addr.addr() & (xdb::page_size - 1));
+        auto chunk = std::min<std::uint64_t>(end.addr() - addr.addr(), up_to_next_page);
+        remote[count] = {reinterpret_cast<void*>(addr.addr()), chunk};
+        batch_size += chunk;
+        addr += chunk;
+      }
+
+      iovec local{data + done, batch_size};
+      auto ret = transfer(&local, remote.data(), count);
+      if (ret < 0 && errno != EFAULT && errno != ENOSYS && errno != EPERM) {
+        xdb::error::send_errno("Could not access process memory");
+      }
+      auto moved = static_cast<std::size_t>(std::max<ssize_t>(ret, 0));
+      std::size_t i = 0;
+      for (; i != count && moved >= remote[i].iov_len; ++i) {
+        done += remote[i].iov_len;
+        moved -= remote[i].iov_len;
+      }
+      if (i != count) {
+        fallback(xdb::virt_addr{reinterpret_cast<std::uint64_t>(remote[i].iov_base)}, data + done, remote[i].iov_len);
+        done += remote[i].iov_len;
+      }
+    }
+  }
+}
+
+/// Reads while the inferior is stopped are served from the page cache when
+/// they fit in it; misses are fetched a whole page at a time.
+std::vector<std::byte> xdb::process::read_memory(virt_addr address, std::size_t amount) const {
+  std::vector<std::byte> ret(amount);
+  read_memory(address, ret.data(), amount);
+  return ret;
+}
+
+void xdb::process::read_memory(virt_addr address, std::byte* data, std::size_t amount) const {
+  if (amount == 0) return;
+
+  auto first_page = virt_addr{address.addr() & ~(page_size - 1)};
+  auto last_page = virt_addr{(address.addr() + amount - 1) & ~(page_size - 1)};
+  auto n_pages = (last_page.addr() - first_page.addr()) / page_size + 1;
+  // in non-stop mode other threads may be changing memory under us
+  auto all_stopped = state_ == process_state::stopped && (!non_stop_ || !has_running_threads());
+  if (!mem_cache_.enabled() || !all_stopped || n_pages > mem_cache_.max_pages()) {
+    read_memory_direct(address, data, amount);
+    return;
+  }
+
+  memory_cache::page page_buf;
+  std::size_t done = 0;
+  for (auto page = first_page; page <= last_page; page += page_size) {
+    auto cached = mem_cache_.find(page);
+    const std::byte* page_data;
+    if (cached) {
+      page_data = cached->data();
+    } else {
+      read_memory_direct(page, page_buf.data(), page_size);
+      mem_cache_.insert(page, page_buf.data());
+      page_data = page_buf.data();
+    }
+    auto offset = page == first_page ? address.addr() - first_page.addr() : 0;
+    auto chunk = std::min(page_size - offset, amount - done);
+    std::copy(page_data + offset, page_data + offset + chunk, data + done);
+    done += chunk;
+  }
+}
+
+/// Pages process_vm_readv refuses (e.g. PROT_NONE guard pages) are read through /proc/<pid>/mem.
+void xdb::process::read_memory_direct(virt_addr address, std::byte* data, std::size_t amount) const {
+  transfer_pages(address, data, amount,
+    [this](iovec* local, iovec* remote, std::size_t count) {
+      return process_vm_readv(pid_, local, 1, remote, count, 0);
+    },
+    [this](virt_addr addr, std::byte* data, std::size_t size) {
+      read_proc_mem(addr, data, size);
+    });
+}
+
+/// Pages the inferior can't write itself, such as read-only text, are written through /proc/<pid>/mem.
+void xdb::process::write_memory(virt_addr address, const std::byte* data, std::size_t size) {
+  mem_cache_.invalidate(address, size);
+  transfer_pages(address, const_cast<std::byte*>(data), size,
+    [this](iovec* local, iovec* remote, std::size_t count) {
+      return process_vm_writev(pid_, local, 1, remote, count, 0);
+    },
+    [this](virt_addr addr, std::byte* data, std::size_t size) {
+      write_proc_mem(addr, data, size);
+    });
+}
+
+std::vector<std::byte> xdb::process::read_memory_without_traps(virt_addr address, std::size_t amount) const {
+  std::vector<std::byte> memory(amount);
+  read_memory_without_traps(address, memory.data(), amount);
+  return memory;
+}
+
+void xdb::process::read_memory_without_traps(virt_addr address, std::byte* data, std::size_t amount) const {
+  read_memory(address, data, amount);
+  breakpoint_sites_.for_each_in_range(address, address + amount, [&](const breakpoint_site& site) {
+    if (site.is_enabled() && !site.is_hardware()) {
+      data[site.address().addr() - address.addr()] = site.data_;
+    }
+  });
+  if (!tracepoints_.empty()) {
+    // a tracepoint's jump can start before address and reach into the range
+    auto low = virt_addr{ address.addr() - std::min<std::uint64_t>(address.addr(), 15) };
+    tracepoints_.for_each_in_range(low, address + amount, [&](const tracepoint& point) {
+      if (!point.is_enabled()) return;
+      auto& original = point.original_code_;
+      for (std::size_t i = 0; i < original.size(); ++i) {
+        auto addr = point.address().addr() + i;
+        if (addr >= address.addr() && addr < address.addr() + amount) {
+          data[addr - address.addr()] = original[i];
+        }
+      }
+    });
+  }
+}
+
+namespace {
+  bool overlaps_tracepoint(const xdb::stoppoint_manager<xdb::tracepoint>& tracepoints, xdb::virt_addr addr) {
+    auto low = xdb::virt_addr{ addr.addr() - std::min<std::uint64_t>(addr.addr(), 15) };
+    for (auto point : tracepoints.get_in_range(low, addr + 1)) {
+      if (point->is_enabled() && addr.addr() < point->address().addr() + point->patch_size()) return true;
+    }
+    return false;
+  }
+}
+
+void xdb::process::enable_breakpoint_sites(std::vector<breakpoint_site*> sites) {
+  patch_breakpoint_sites(sites, true);
+}
+
+void xdb::process::disable_breakpoint_sites(std::vector<breakpoint_site*> sites) {
+  patch_breakpoint_sites(sites, false);
+}
+
+void xdb::process::enable_all_breakpoint_sites() {
+  std::vector<breakpoint_site*> sites;
+  breakpoint_sites_.for_each([&](auto& site) { sites.push_back(&site); });
+  enable_breakpoint_sites(std::move(sites));
+}
+
+void xdb::process::disable_all_breakpoint_sites() {
+  std::vector<breakpoint_site*> sites;
+  breakpoint_sites_.for_each([&](auto& site) { sites.push_back(&site); });
+  disable_breakpoint_sites(std::move(sites));
+}
+
+/// Sites are grouped by page; for each page we read the span between its
+/// first and last site once, patch every site in it and write it back once.
+/// Breakpoints almost always live in read-only text, so the write goes
+/// straight to /proc/<pid>/mem instead of trying process_vm_writev first.
+void xdb::process::patch_breakpoint_sites(std::vector<breakpoint_site*>& sites, bool enable) {
+  sites.erase(std::remove_if(sites.begin(), sites.end(), [enable](auto site) { return site->is_enabled() == enable; }),
+              sites.end());
+  auto hardware_end = std::partition(sites.begin(), sites.end(), [](auto site) { return site->is_hardware(); });
+  for (auto it = sites.begin(); it != hardware_end; ++it) {
+    if (enable) {
+      (*it)->hardware_register_index_ = set_hardware_breakpoint((*it)->address());
+    } else {
+      clear_hardware_stoppoint((*it)->hardware_register_index_);
+    }
+    (*it)->is_enabled_ = enable;
+  }
+  sites.erase(sites.begin(), hardware_end);
+  if (enable) {
+    for (auto site : sites) {
+      if (overlaps_tracepoint(tracepoints_, site->address())) {
+        error::send("Breakpoint site is inside an enabled tracepoint");
+      }
+    }
+  }
+  std::sort(sites.begin(), sites.end(), [](auto lhs, auto rhs) { return lhs->address() < rhs->address(); });
+
+  std::vector<std::byte> span;
+  for (auto first = sites.begin(); first != sites.end();) {
+    auto page_addr = virt_addr{ (*first)->address().addr() & ~(page_size - 1) };
+    auto last = std::find_if(first, sites.end(), [&](auto site) { return site->address() >= page_addr + page_size; });
+
+    auto low = (*first)->address();
+    auto size = (*(last - 1))->address().addr() - low.addr() + 1;
+    span.resize(size);
+    // a lone site being disabled only needs its saved byte
+    if (enable || size > 1) {
+      read_memory_direct(low, span.data(), size);
+    }
+
+    for (auto it = first; it != last; ++it) {
+      auto& byte = span[(*it)->address().addr() - low.addr()];
+      if (enable) {
+        (*it)->data_ = byte;
+        byte = std::byte{ 0xcc };
+      } else {
+        byte = (*it)->data_;
+      }
+      (*it)->is_enabled_ = enable;
+    }
+
+    mem_cache_.invalidate(low, size);
+    write_proc_mem(low, span.data(), size);
+    first = last;
+  }
+}
+
+/// The code and registers are put back however the step ends. A signal that
+/// comes first waits in pending_signal, and the step is tried again. Other
+/// threads are stopped meanwhile, as they could run into the borrowed bytes.
+std::int64_t xdb::process::inject_syscall(thread_state& thread, std::uint64_t number,
+                                          std::initializer_list<std::uint64_t> args) {
+  std::int64_t ret = 0;
+  bool ran = false;
+  with_other_threads_stopped([&] {
+    ret = inject_syscall_stopped(thread, number, args);
+    ran = true;
+  });
+  if (!ran) error::send("Process exited before an injected syscall could run");
+  return ret;
+}
+
+std::int64_t xdb::process::inject_syscall_stopped(thread_state& thread, std::uint64_t number,
+                                                  std::initializer_list<std::uint64_t> args) {
+  auto& regs = *thread.regs;
+  regs.ensure_fetched(register_type::gpr);
+  auto saved_regs = regs.data_.regs;
+  auto pc = virt_addr{ saved_regs.rip };
+
+  // borrow the two bytes under the pc for a syscall instruction
+  std::byte saved_code[2];
+  read_memory_direct(pc, saved_code, 2);
+  const std::byte syscall_code[] = { std::byte{ 0x0f }, std::byte{ 0x05 } };
+  write_proc_mem(pc, syscall_code, 2);
+
+  bool exited = false;
+  bool stashed = false;
+  auto restore = [&] {
+    try {
+      write_proc_mem(pc, saved_code, 2);
+    } catch (const error&) {
+      // the whole process is gone, and its memory with it
+      if (!exited) throw;
+    }
+    if (exited) return;
+    regs.data_.regs = saved_regs;
+    regs.dirty_ |= registers::class_bit(register_type::gpr);
+    // the stashed stop's handling starts from fresh registers
+    if (stashed) regs.flush();
+  };
+
+  user_regs_struct after;
+  try {
+    auto& gprs = regs.data_.regs;
+    unsigned long long* arg_regs[] = { &gprs.rdi, &gprs.rsi, &gprs.rdx, &gprs.r10, &gprs.r8, &gprs.r9 };
+    std::size_t i = 0;
+    for (auto arg : args) *arg_regs[i++] = arg;
+    gprs.rax = number;
+    // keep the kernel from treating this as an interrupted syscall to restart
+    gprs.orig_rax = -1;
+    regs.dirty_ |= registers::class_bit(register_type::gpr);
+    regs.flush();
+
+    // a syscall the seccomp filter selects isn't logged: we made it, not
+    // the program
+    if (!single_step_thread(thread)) {
+      stashed = WIFSTOPPED(last_stashed_status(thread.tid));
+      exited = !stashed;
+      error::send("Thread " + std::to_string(thread.tid) +
+                  (exited ? " exited" : " stopped for an event") + " while running an injected syscall");
+    }
+    read_gprs(thread.tid, after);
+  } catch (...) {
+    restore();
+    throw;
+  }
+  restore();
+  return static_cast<std::int64_t>(after.rax);
+}
+
+/// Hands out space from mmaped blocks. A new block is mapped with
+/// MAP_FIXED_NOREPLACE at addresses stepping away from near until one is free.
+xdb::virt_addr xdb::process::allocate_scratch(thread_state& thread, virt_addr near, std::size_t size) {
+  constexpr std::int64_t max_distance = 0x40000000;  // well inside rel32 reach
+  for (auto& block : scratch_blocks_) {
+    auto distance = static_cast<std::int64_t>(block.base.addr() - near.addr());
+    if (std::abs(distance) < max_distance && block.size - block.used >= size) {
+      auto ret = block.base + block.used;
+      block.used += size;
+      return ret;
+    }
+  }
+
+  constexpr std::size_t block_size = 0x10000;
+  constexpr std::uint64_t step = 0x1000000;
+  auto near_page = near.addr() & ~(page_size - 1);
+  for (std::uint64_t k = 1; k * step < max_distance; ++k) {
+    for (auto hint : { near_page - k * step, near_page + k * step }) {
+      auto ret = inject_syscall(thread, SYS_mmap, { hint, block_size, PROT_READ | PROT_EXEC,
+                                                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                                                    static_cast<std::uint64_t>(-1), 0 });
+      if (ret < 0 && ret >= -4095) continue;
+      if (std::abs(static_cast<std::int64_t>(ret - near.addr())) >= max_distance) {
+        // an old kernel took the flag as a mere hint
+        inject_syscall(thread, SYS_munmap, { static_cast<std::uint64_t>(ret), block_size });
+        continue;
+      }
+      scratch_blocks_.push_back({ virt_addr{ static_cast<std::uint64_t>(ret) }, block_size, size });
+      return virt_addr{ static_cast<std::uint64_t>(ret) };
+    }
+  }
+  error::send("Could not allocate scratch memory in the inferior");
+}
+
+namespace {
+  void emit(std::vector<std::byte>& code, std::initializer_list<std::uint8_t> bytes) {
+    for (auto b : bytes) code.push_back(std::byte{ b });
+  }
+
+  template <class T>
+  void emit_value(std::vector<std::byte>& code, T value) {
+    auto bytes = xdb::as_bytes(value);
+    code.insert(code.end(), bytes, bytes + sizeof(T));
+  }
+
+  // jmp [rip+0]; .quad target -- reaches anywhere, clobbers nothing
+  void emit_jump(std::vector<std::byte>& code, std::uint64_t target) {
+    emit(code, { 0xff, 0x25, 0, 0, 0, 0 });
+    emit_value(code, target);
+  }
+
+  std::int64_t read_rel(const std::vector<std::byte>& code, const xdb::x86_instruction& inst) {
+    if (inst.rel_size == 1) return xdb::from_bytes<std::int8_t>(code.data() + inst.rel_offset);
+    return xdb::from_bytes<std::int32_t>(code.data() + inst.rel_offset);
+  }
+}
+
+namespace {
+  // Appends to out a copy of inst, read from `from`, that does the same thing
+  // when it runs at to. Relative branches become absolute jumps, a call
+  // pushes the original return address itself, and rip-relative operands get
+  // their displacement adjusted. A fall-through continues with whatever is
+  // appended next, except that the last copy ends by jumping back to the
+  // instruction after the original. Returns false for instructions that
+  // can't be moved.
+  bool relocate_instruction(std::vector<std::byte> code, const xdb::x86_instruction& inst, std::uint64_t from,
+                            std::uint64_t to, bool last, std::vector<std::byte>& out) {
+    auto next = from + inst.length;
+    switch (inst.flow) {
+      case xdb::x86_flow::plain:
+      case xdb::x86_flow::ret:
+      case xdb::x86_flow::jmp_indirect:
+        if (inst.rip_disp_offset) {
+          auto disp = xdb::from_bytes<std::int32_t>(code.data() + *inst.rip_disp_offset);
+          auto target = next + disp;
+          auto new_disp = static_cast<std::int64_t>(target - (to + inst.length));
+          if (new_disp != static_cast<std::int32_t>(new_disp)) return false;
+          auto fixed = static_cast<std::int32_t>(new_disp);
+          std::memcpy(code.data() + *inst.rip_disp_offset, &fixed, 4);
+        }
+        out.insert(out.end(), code.begin(), code.end());
+        if (last && inst.flow == xdb::x86_flow::plain) emit_jump(out, next);
+        return true;
+      case xdb::x86_flow::jmp_rel:
+        emit_jump(out, next + read_rel(code, inst));
+        return true;
+      case xdb::x86_flow::jcc_rel:
+        // jcc over a short jump that skips the taken branch's long jump
+        emit(out, { static_cast<std::uint8_t>(0x70 | inst.condition), 2, 0xeb, 14 });
+        emit_jump(out, next + read_rel(code, inst));
+        if (last) emit_jump(out, next);
+        return true;
+      case xdb::x86_flow::call_rel:
+        // lea rsp, [rsp-8]; mov dword [rsp], lo; mov dword [rsp+4], hi; jmp target
+        emit(out, { 0x48, 0x8d, 0x64, 0x24, 0xf8 });
+        emit(out, { 0xc7, 0x04, 0x24 });
+        emit_value(out, static_cast<std::uint32_t>(next));
+        emit(out, { 0xc7, 0x44, 0x24, 0x04 });
+        emit_value(out, static_cast<std::uint32_t>(next >> 32));
+        emit_jump(out, next + read_rel(code, inst));
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // up to max_size bytes of code at addr, stopping short at an unmapped page
+  std::vector<std::byte> read_code(const xdb::process& proc, xdb::virt_addr addr, std::size_t max_size) {
+    try {
+      return proc.read_memory_without_traps(addr, max_size);
+    } catch (const xdb::error&) {
+      auto to_page_end = xdb::page_size - (addr.addr() & (xdb::page_size - 1));
+      return proc.read_memory_without_traps(addr, std::min(max_size, to_page_end));
+    }
+  }
+}
+
+/// Builds a copy of the instruction that ends by jumping back to the
+/// instruction after the original, so stepping over the breakpoint is just
+/// pointing rip at the copy and continuing.
+std::optional<xdb::virt_addr> xdb::process::displaced_copy(thread_state& thread, const breakpoint_site& site) {
+  auto it = displaced_copies_.find(site.id());
+  if (it != displaced_copies_.end()) return it->second;
+  auto& copy = displaced_copies_[site.id()];
+
+  auto addr = site.address();
+  auto code = read_code(*this, addr, 15);
+  auto inst = decode_x86(code.data(), code.size());
+  if (!inst || inst->flow == x86_flow::call_indirect || inst->flow == x86_flow::loop_rel ||
+      inst->flow == x86_flow::other) {
+    return copy;
+  }
+  code.resize(inst->length);
+
+  constexpr std::size_t slot_size = 64;
+  auto slot = allocate_scratch(thread, addr, slot_size);
+  std::vector<std::byte> out;
+  if (!relocate_instruction(code, *inst, addr.addr(), slot.addr(), true, out)) return copy;
+
+  write_proc_mem(slot, out.data(), out.size());
+  copy = slot;
+  return copy;
+}
+
+namespace {
+  // the encoding number of a 64-bit general purpose register, -1 for others
+  int gpr_number(xdb::register_id id) {
+    using xdb::register_id;
+    switch (id) {
+      case register_id::rax: return 0;
+      case register_id::rcx: return 1;
+      case register_id::rdx: return 2;
+      case register_id::rbx: return 3;
+      case register_id::rsp: return 4;
+      case register_id::rbp: return 5;
+      case register_id::rsi: return 6;
+      case register_id::rdi: return 7;
+      case register_id::r8: return 8;
+      case register_id::r9: return 9;
+      case register_id::r10: return 10;
+      case register_id::r11: return 11;
+      case register_id::r12: return 12;
+      case register_id::r13: return 13;
+      case register_id::r14: return 14;
+      case register_id::r15: return 15;
+      default: return -1;
+    }
+  }
+
+  void patch_rel32(std::vector<std::byte>& code, std::size_t at, std::size_t target) {
+    auto rel = static_cast<std::int32_t>(target - (at + 4));
+    std::memcpy(code.data() + at, &rel, 4);
+  }
+}
+
+xdb::tracepoint& xdb::process::create_tracepoint(virt_addr address, std::vector<trace_field> fields) {
+  if (tracepoints_.contains(address)) {
+    error::send("Tracepoint already created at address " + std::to_string(address.addr()));
+  }
+  for (auto& field : fields) {
+    if (gpr_number(field.reg) < 0 && field.reg != register_id::rip && field.reg != register_id::eflags) {
+      error::send("Tracepoints can only record 64-bit general purpose registers, rip and eflags");
+    }
+  }
+  auto point = std::unique_ptr<tracepoint>(new tracepoint(*this, address, std::move(fields)));
+  return tracepoints_.push(std::move(point));
+}
+
+/// The inferior creates a memfd, sizes it and maps it shared; we then map the
+/// same file through /proc/<pid>/fd and close the inferior's descriptor.
+xdb::trace_buffer& xdb::process::get_trace_buffer() {
+  if (trace_buffer_) return *trace_buffer_;
+
+  auto size = trace_buffer::size_for(trace_buffer_capacity);
+  auto failed = [](std::int64_t ret) { return ret < 0 && ret >= -4095; };
+
+  auto& thread = threads_.at(current_tid_);
+  auto name = allocate_scratch(thread, get_pc(), 16);
+  const char name_text[16] = "xdb-trace";
+  write_proc_mem(name, reinterpret_cast<const std::byte*>(name_text), sizeof(name_text));
+  auto fd = inject_syscall(thread, SYS_memfd_create, { name.addr(), MFD_CLOEXEC });
+  if (failed(fd)) error::send("Could not create trace buffer in the inferior");
+  auto fd_arg = static_cast<std::uint64_t>(fd);
+
+  auto ret = inject_syscall(thread, SYS_ftruncate, { fd_arg, size });
+  std::int64_t address = -1;
+  if (!failed(ret)) {
+    address = inject_syscall(thread, SYS_mmap, { 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_arg, 0 });
+  }
+  int local_fd = -1;
+  if (!failed(ret) && !failed(address)) {
+    auto path = "/proc/" + std::to_string(pid_) + "/fd/" + std::to_string(fd);
+    local_fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+  }
+  inject_syscall(thread, SYS_close, { fd_arg });
+  if (local_fd < 0) error::send("Could not map trace buffer");
+
+  try {
+    trace_buffer_ = std::make_unique<trace_buffer>(local_fd, trace_buffer_capacity);
+  } catch (...) {
+    close(local_fd);
+    throw;
+  }
+  close(local_fd);
+
+  trace_buffer_address_ = virt_addr{ static_cast<std::uint64_t>(address) };
+  std::uint64_t layout[] = { trace_buffer_capacity, trace_buffer::record_size };
+  write_memory(trace_buffer_address_ + 24, reinterpret_cast<const std::byte*>(layout), sizeof(layout));
+  return *trace_buffer_;
+}
+
+/// Reserves a record with a cmpxchg loop on the head, or counts a drop if the
+/// consumer is a whole buffer behind; fills in the fields; publishes the
+/// record by writing its sequence number; then runs the relocated code. It
+/// stays below the red zone and restores every register and the flags it
+/// touches. The flags are saved with lahf/seto, which is far cheaper than
+/// pushfq/popfq, unless eflags itself is recorded.
+std::vector<std::byte> xdb::process::build_trampoline(const tracepoint& point, const std::vector<std::byte>& code,
+                                                      virt_addr slot) {
+  auto at = point.address();
+  std::vector<std::byte> out;
+  constexpr std::uint8_t red_zone = 128;
+  // bytes pushed below the red zone: rax, flags, rcx, rdx, rsi
+  constexpr std::uint32_t pushed = 5 * 8;
+  auto full_flags = std::any_of(point.fields().begin(), point.fields().end(),
+                                [](auto& field) { return field.reg == register_id::eflags; });
+
+  // lea rsp, [rsp-128]; push rax
+  emit(out, { 0x48, 0x8d, 0x64, 0x24, static_cast<std::uint8_t>(-red_zone), 0x50 });
+  if (full_flags) {
+    // pushfq
+    emit(out, { 0x9c });
+  } else {
+    // lahf; seto al; push rax
+    emit(out, { 0x9f, 0x0f, 0x90, 0xc0, 0x50 });
+  }
+  // push rcx; push rdx; push rsi
+  emit(out, { 0x51, 0x52, 0x56 });
+  // movabs rcx, header
+  emit(out, { 0x48, 0xb9 });
+  emit_value(out, trace_buffer_address_.addr());
+
+  auto retry = out.size();
+  // mov rax, [rcx]; mov rdx, rax; sub rdx, [rcx+tail]; cmp rdx, capacity; jae drop
+  emit(out, { 0x48, 0x8b, 0x01, 0x48, 0x89, 0xc2, 0x48, 0x2b, 0x51, trace_buffer::tail_offset });
+  emit(out, { 0x48, 0x81, 0xfa });
+  emit_value(out, static_cast<std::uint32_t>(trace_buffer_capacity));
+  emit(out, { 0x0f, 0x83, 0, 0, 0, 0 });
+  auto jump_to_drop = out.size() - 4;
+  // lea rdx, [rax+1]; lock cmpxchg [rcx], rdx; jne retry
+  emit(out, { 0x48, 0x8d, 0x50, 0x01, 0xf0, 0x48, 0x0f, 0xb1, 0x11, 0x0f, 0x85, 0, 0, 0, 0 });
+  patch_rel32(out, out.size() - 4, retry);
+
+  // rsi = header + header_size + (index & (capacity - 1)) * record_size
+  emit(out, { 0x48, 0x89, 0xc6, 0x48, 0x81, 0xe6 });
+  emit_value(out, static_cast<std::uint32_t>(trace_buffer_capacity - 1));
+  emit(out, { 0x48, 0x69, 0xf6 });
+  emit_value(out, static_cast<std::uint32_t>(trace_buffer::record_size));
+  emit(out, { 0x48, 0x8d, 0x74, 0x31, trace_buffer::header_size });
+
+  // movabs rax, id; mov [rsi+8], rax
+  emit(out, { 0x48, 0xb8 });
+  emit_value(out, static_cast<std::uint64_t>(point.id()));
+  emit(out, { 0x48, 0x89, 0x46, 0x08 });
+
+  for (std::size_t i = 0; i < point.fields().size(); ++i) {
+    auto& field = point.fields()[i];
+    auto number = gpr_number(field.reg);
+    // the registers the trampoline clobbers are read back from where they were saved
+    auto saved = [&](std::uint8_t offset) { emit(out, { 0x48, 0x8b, 0x44, 0x24, offset }); };
+    if (field.reg == register_id::rip) {
+      emit(out, { 0x48, 0xb8 });
+      emit_value(out, at.addr());
+    } else if (field.reg == register_id::eflags) {
+      saved(24);
+    } else if (number == 0) {
+      saved(32);
+    } else if (number == 1) {
+      saved(16);
+    } else if (number == 2) {
+      saved(8);
+    } else if (number == 6) {
+      emit(out, { 0x48, 0x8b, 0x04, 0x24 });
+    } else if (number == 4) {
+      // lea rax, [rsp + pushed + red zone]
+      emit(out, { 0x48, 0x8d, 0x84, 0x24 });
+      emit_value(out, pushed + red_zone);
+    } else {
+      // mov rax, reg
+      emit(out, { static_cast<std::uint8_t>(0x48 | (number >= 8 ? 0x04 : 0)), 0x89,
+                  static_cast<std::uint8_t>(0xc0 | ((number & 7) << 3)) });
+    }
+    if (field.deref) {
+      // mov rax, [rax + deref]
+      emit(out, { 0x48, 0x8b, 0x80 });
+      emit_value(out, *field.deref);
+    }
+    // mov [rsi + 16 + 8i], rax
+    emit(out, { 0x48, 0x89, 0x86 });
+    emit_value(out, static_cast<std::uint32_t>(16 + 8 * i));
+  }
+
+  // mov [rsi], rdx publishes the record; jmp done
+  emit(out, { 0x48, 0x89, 0x16, 0xe9, 0, 0, 0, 0 });
+  auto jump_to_done = out.size() - 4;
+  patch_rel32(out, jump_to_drop, out.size());
+  // lock inc qword [rcx+dropped]
+  emit(out, { 0xf0, 0x48, 0xff, 0x41, trace_buffer::dropped_offset });
+  patch_rel32(out, jump_to_done, out.size());
+
+  // pop rsi; pop rdx; pop rcx
+  emit(out, { 0x5e, 0x5a, 0x59 });
+  if (full_flags) {
+    // popfq
+    emit(out, { 0x9d });
+  } else {
+    // pop rax; add al, 0x7f (sets OF back from seto); sahf
+    emit(out, { 0x58, 0x04, 0x7f, 0x9e });
+  }
+  // pop rax; lea rsp, [rsp+128]
+  emit(out, { 0x58, 0x48, 0x8d, 0xa4, 0x24 });
+  emit_value(out, static_cast<std::uint32_t>(red_zone));
+
+  // then the instructions the jump replaced
+  std::size_t offset = 0;
+  while (offset < code.size()) {
+    auto inst = decode_x86(code.data() + offset, code.size() - offset);
+    std::vector<std::byte> bytes(code.begin() + offset, code.begin() + offset + inst->length);
+    auto last = offset + inst->length == code.size();
+    if (!relocate_instruction(bytes, *inst, at.addr() + offset, slot.addr() + out.size(), last, out)) {
+      error::send("Could not relocate the instructions under the tracepoint");
+    }
+    offset += inst->length;
+  }
+  return out;
+}
+
+void xdb::process::enable_tracepoint(tracepoint& point) {
+  auto addr = point.address();
+  if (!point.trampoline_) {
+    // whole instructions adding up to the five bytes of a jmp rel32
+    constexpr std::size_t jump_size = 5;
+    auto code = read_code(*this, addr, 32);
+    std::size_t size = 0;
+    while (size < jump_size) {
+      auto inst = decode_x86(code.data() + size, code.size() - size);
+      if (!inst || inst->flow == x86_flow::call_indirect || inst->flow == x86_flow::loop_rel ||
+          inst->flow == x86_flow::other) {
+        error::send("Can't relocate the instructions under the tracepoint");
+      }
+      auto ends_block = inst->flow == x86_flow::jmp_rel || inst->flow == x86_flow::jmp_indirect ||
+                        inst->flow == x86_flow::ret || inst->flow == x86_flow::call_rel;
+      size += inst->length;
+      if (ends_block && size < jump_size) {
+        error::send("Tracepoint needs five bytes of code before the end of a block");
+      }
+    }
+    code.resize(size);
+
+    get_trace_buffer();
+    constexpr std::size_t slot_size = 512;
+    auto slot = allocate_scratch(threads_.at(current_tid_), addr, slot_size);
+    auto trampoline = build_trampoline(point, code, slot);
+    if (trampoline.size() > slot_size) {
+      error::send("Tracepoint trampoline is too large");
+    }
+    write_proc_mem(slot, trampoline.data(), trampoline.size());
+    point.trampoline_ = slot;
+    point.original_code_ = std::move(code);
+  }
+
+  auto end = addr + point.original_code_.size();
+  for (auto site : breakpoint_sites_.get_in_range(addr, end)) {
+    if (site->is_enabled() && !site->is_hardware()) {
+      error::send("Tracepoint overlaps an enabled breakpoint site");
+    }
+  }
+
+  // jmp trampoline, with int3s after it so a jump into the middle traps
+  std::vector<std::byte> patch(point.original_code_.size(), std::byte{ 0xcc });
+  patch[0] = std::byte{ 0xe9 };
+  auto rel = static_cast<std::int32_t>(point.trampoline_->addr() - (addr.addr() + 5));
+  std::memcpy(patch.data() + 1, &rel, 4);
+  // the patch is more than one byte, so no thread may run through it while
+  // it is written, or be stopped halfway through it
+  with_other_threads_stopped([&] {
+    for (auto& [tid, thread] : threads_) {
+      auto pc = virt_addr{ thread.regs->read<register_id::rip>() };
+      if (pc > addr && pc < end) {
+        error::send("Can't enable a tracepoint while a thread is stopped inside its code");
+      }
+    }
+    write_memory(addr, patch);
+  });
+}
+
+void xdb::process::disable_tracepoint(tracepoint& point) {
+  with_other_threads_stopped([&] { write_memory(point.address(), point.original_code_); });
+}
+
+namespace {
+  // whether addr is in an executable mapping of the process, as a return
+  // address found by heuristics had better be before an int3 goes there
+  bool is_code_address(pid_t pid, xdb::virt_addr addr) {
+    // start-end perms offset device inode path
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+      auto dash = line.find('-');
+      auto space = line.find(' ');
+      auto start = std::stoull(line.substr(0, dash), nullptr, 16);
+      auto end = std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+      if (addr.addr() >= start && addr.addr() < end) return line[space + 3] == 'x';
+    }
+    return false;
+  }
+}
+
+std::optional<xdb::virt_addr> xdb::process::return_address_slot() const {
+  auto& regs = get_registers();
+  auto rsp = virt_addr{ regs.read<register_id::rsp>() };
+  auto code = read_code(*this, get_pc(), 4);
+  auto starts_with = [&](std::initializer_list<std::uint8_t> bytes) {
+    return code.size() >= bytes.size() &&
+           std::equal(bytes.begin(), bytes.end(), code.begin(), [](auto a, auto b) { return std::byte{ a } == b; });
+  };
+  std::vector<virt_addr> candidates;
+  // endbr64, push rbp, ret, ret imm16
+  if (starts_with({ 0xf3, 0x0f, 0x1e, 0xfa }) || starts_with({ 0x55 }) || starts_with({ 0xc3 }) ||
+      starts_with({ 0xc2 })) {
+    candidates = { rsp };
+  }
+  // mov rbp, rsp
+  else if (starts_with({ 0x48, 0x89, 0xe5 })) {
+    candidates = { rsp + 8 };
+  }
+  // a frame pointer, or else a leaf that keeps none and hasn't moved rsp
+  else {
+    candidates = { virt_addr{ regs.read<register_id::rbp>() } + 8, rsp };
+  }
+  for (auto slot : candidates) {
+    try {
+      if (is_code_address(pid_, virt_addr{ read_memory_as<std::uint64_t>(slot) })) return slot;
+    } catch (error&) {
+      // not a stack address
+    }
+  }
+  return std::nullopt;
+}
+
+/// A target that already has an enabled site of its own needs nothing more.
+/// The others get an internal site, or their disabled one enabled, until the
+/// run is over, and hits on those that aren't the one being waited for are
+/// stepped over.
+xdb::process::target_run xdb::process::run_to_targets(const std::vector<virt_addr>& targets,
+                                                       const std::function<bool(virt_addr)>& accept) {
+  auto tid = current_tid_;
+  std::vector<breakpoint_site*> placed;
+  std::vector<breakpoint_site::id_t> created;
+  for (auto target : targets) {
+    if (!breakpoint_sites_.contains(target)) {
+      auto& site = create_breakpoint_site(target, false, true);
+      created.push_back(site.id());
+      placed.push_back(&site);
+    } else if (auto& site = breakpoint_sites_.get_by_address(target); !site.is_enabled()) {
+      placed.push_back(&site);
+    }
+  }
+  auto is_placed = [&](virt_addr pc) {
+    return std::any_of(placed.begin(), placed.end(), [&](auto site) { return site->address() == pc; });
+  };
+  auto restore = [&] {
+    auto gone = state_ == process_state::exited || state_ == process_state::terminated;
+    std::vector<breakpoint_site*> enabled;
+    for (auto site : placed) {
+      // a process that is gone has no memory left to put the bytes back into
+      if (gone) site->is_enabled_ = false;
+      if (site->is_enabled()) enabled.push_back(site);
+    }
+    disable_breakpoint_sites(enabled);
+    for (auto id : created) breakpoint_sites_.remove_by_id(id);
+  };
+
+  try {
+    enable_breakpoint_sites(placed);
+    for (;;) {
+      non_stop_ ? resume(tid) : resume();
+      auto reason = *wait_for_stop(true, non_stop_ ? tid : 0);
+      auto at_breakpoint = reason.reason == process_state::stopped &&
+                           (reason.trap_reason == trap_type::software_break ||
+                            reason.trap_reason == trap_type::hardware_break);
+      if (at_breakpoint) {
+        auto pc = get_pc();
+        auto is_target = std::find(targets.begin(), targets.end(), pc) != targets.end();
+        if (is_target && current_tid_ == tid && accept(pc)) {
+          restore();
+          return { reason, true };
+        }
+        if (is_target && is_placed(pc)) continue;
+      }
+      if (should_resume_from(reason)) continue;
+      restore();
+      return { reason, false };
+    }
+  } catch (...) {
+    restore();
+    throw;
+  }
+}
+
+xdb::stop_reason xdb::process::run_until(virt_addr address) {
+  std::vector<virt_addr> targets{ address };
+  // with no frame to find, only the address stops it
+  auto slot = return_address_slot();
+  if (slot) targets.push_back(virt_addr{ read_memory_as<std::uint64_t>(*slot) });
+  return run_to_targets(targets, [&](virt_addr pc) {
+    return pc == address || (slot && get_registers().read<register_id::rsp>() > slot->addr());
+  }).reason;
+}
+
+xdb::stop_reason xdb::process::step_out() {
+  auto slot = return_address_slot();
+  if (!slot) error::send("Could not find the return address of the current function");
+  auto return_address = virt_addr{ read_memory_as<std::uint64_t>(*slot) };
+  // a recursive call returns to the same place from deeper down the stack
+  return run_to_targets({ return_address }, [&](virt_addr) {
+    return get_registers().read<register_id::rsp>() > slot->addr();
+  }).reason;
+}
+
+/// The range can be left by falling off its end, by a relative branch to
+/// outside it, or by an instruction whose target decoding can't tell (ret,
+/// an indirect jump); those are stopped at and single-stepped. Calls need
+/// nothing, as they come back into the range. A recursive call that reaches
+/// one of the exits stops there, for want of frame information.
+xdb::stop_reason xdb::process::step_over_range(virt_addr low, virt_addr high) {
+  auto code = read_memory_without_traps(low, high.addr() - low.addr());
+  std::vector<virt_addr> exits{ high };
+  std::vector<virt_addr> opaque;
+  for (std::size_t offset = 0; offset < code.size();) {
+    auto inst = decode_x86(code.data() + offset, code.size() - offset);
+    auto addr = low + offset;
+    if (!inst) {
+      error::send("Could not decode the instruction at address " + std::to_string(addr.addr()));
+    }
+    if (inst->flow == x86_flow::jmp_rel || inst->flow == x86_flow::jcc_rel || inst->flow == x86_flow::loop_rel) {
+      std::vector<std::byte> bytes(code.begin() + offset, code.begin() + offset + inst->length);
+      auto target = addr + inst->length + read_rel(bytes, *inst);
+      if ((target < low || target >= high) && std::find(exits.begin(), exits.end(), target) == exits.end()) {
+        exits.push_back(target);
+      }
+    } else if (inst->flow == x86_flow::ret || inst->flow == x86_flow::jmp_indirect || inst->flow == x86_flow::other) {
+      opaque.push_back(addr);
+    }
+    offset += inst->length;
+  }
+
+  auto targets = exits;
+  targets.insert(targets.end(), opaque.begin(), opaque.end());
+  auto in_range = [&] { return get_pc() >= low && get_pc() < high; };
+  for (;;) {
+    if (std::find(opaque.begin(), opaque.end(), get_pc()) != opaque.end()) {
+      auto reason = step_instruction();
+      if (reason.trap_reason != trap_type::single_step || !in_range()) return reason;
+      continue;
+    }
+    auto run = run_to_targets(targets, [](virt_addr) { return true; });
+    if (!run.reached || !in_range()) return run.reason;
+  }
+}
+
+xdb::stop_reason xdb::process::step_over_instruction() {
+  auto pc = get_pc();
+  auto code = read_code(*this, pc, 15);
+  auto inst = decode_x86(code.data(), code.size());
+  if (inst && (inst->flow == x86_flow::call_rel || inst->flow == x86_flow::call_indirect)) {
+    return step_over_range(pc, pc + inst->length);
+  }
+  return step_instruction();
+}
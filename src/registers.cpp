@@ -29,7 +29,36 @@ namespace xdb {
   }
 }
 
+void xdb::registers::fetch(register_type type) const {
+  auto bit = class_bit(type);
+
+  switch (type) {
+    case register_type::gpr:
+    case register_type::sub_gpr:
+      proc_->read_gprs(tid_, data_.regs);
+      ++syscall_count_;
+      break;
+    case register_type::fpr:
+      proc_->read_fprs(tid_, data_.i387);
+      ++syscall_count_;
+      break;
+    case register_type::dr:
+      for (std::size_t i = 0; i < 8; ++i) {
+        if (!(valid_drs_ & (1u << i))) fetch_dr(i);
+      }
+      break;
+  }
+  valid_ |= bit;
+}
+
+void xdb::registers::fetch_dr(std::size_t index) const {
+  data_.u_debugreg[index] = proc_->read_user_area(tid_, offsetof(user, u_debugreg) + index * 8);
+  ++syscall_count_;
+  valid_drs_ |= 1u << index;
+}
+
 xdb::value xdb::registers::read(const register_info& info) const {
+  ensure_fetched(info);
   auto bytes = as_bytes(data_);
   if (info.format == register_format::uint) {
     switch(info.size) {
@@ -62,6 +91,8 @@ xdb::value xdb::registers::read(const register_info& info) const {
 }
 
 void xdb::registers::write(const xdb::register_info& info, xdb::value value) {
+  // the rest of the register block is written back along with this one
+  ensure_fetched(info);
   auto bytes = as_bytes(data_);
   std::visit([&](auto& v){
     if (sizeof(v) <= info.size) {
@@ -76,13 +107,29 @@ void xdb::registers::write(const xdb::register_info& info, xdb::value value) {
     }
   }, value);
 
-  // use PTRACE_SETFPREGS to write floating point registers
-  if (info.type == register_type::fpr) {
-    proc_->write_fprs(data_.i387);
+  if (info.type == register_type::dr) {
+    dirty_drs_ |= 1u << dr_index(info);
   } else {
-    // align the offset to 8 bytes
-    auto aligned_offset = info.offset & ~0b111;
-    proc_->write_user_area(aligned_offset, 
-      from_bytes<std::uint64_t>(bytes + aligned_offset));
+    dirty_ |= class_bit(info.type);
+  }
+}
+
+void xdb::registers::flush() {
+  if (dirty_ & class_bit(register_type::gpr)) {
+    proc_->write_gprs(tid_, data_.regs);
+    ++syscall_count_;
+  }
+  if (dirty_ & class_bit(register_type::fpr)) {
+    proc_->write_fprs(tid_, data_.i387);
+    ++syscall_count_;
+  }
+  // in index order, so dr7 enables a slot only after its address is set
+  for (int i = 0; i < 8; ++i) {
+    if (dirty_drs_ & (1u << i)) {
+      proc_->write_user_area(tid_, offsetof(user, u_debugreg) + i * 8, data_.u_debugreg[i]);
+      ++syscall_count_;
+    }
   }
+  dirty_ = 0;
+  dirty_drs_ = 0;
 }
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <libxdb/error.hpp>
+#include <libxdb/session.hpp>
+
+xdb::process& xdb::session::add(std::unique_ptr<process> proc) {
+  proc->set_fork_handler([this](std::unique_ptr<process> child) { add(std::move(child)); });
+  by_pid_[proc->pid()] = proc.get();
+  processes_.push_back(std::move(proc));
+  return *processes_.back();
+}
+
+void xdb::session::remove(const process& proc) {
+  auto it = std::find_if(processes_.begin(), processes_.end(), [&](auto& entry) { return entry.get() == &proc; });
+  if (it == processes_.end()) {
+    error::send("Process " + std::to_string(proc.pid()) + " isn't part of the session");
+  }
+  by_pid_.erase(proc.pid());
+  // swap with the last and pop, so removing each of many children is O(1)
+  std::iter_swap(it, processes_.end() - 1);
+  processes_.pop_back();
+}
+
+xdb::process* xdb::session::find(pid_t pid) const {
+  auto it = by_pid_.find(pid);
+  return it == by_pid_.end() ? nullptr : it->second;
+}
+
+/// Each status is routed to the inferior it belongs to by its thread group,
+/// so a wakeup costs one waitpid however many inferiors there are. A child's
+/// first stop may come before its parent's fork event; it waits in the stash
+/// until the child has joined the session.
+std::pair<xdb::process&, xdb::stop_reason> xdb::session::wait_on_signal() {
+  if (std::none_of(processes_.begin(), processes_.end(), [](auto& proc) { return proc->has_running_threads(); })) {
+    error::send("No running processes to wait for");
+  }
+  // a stopped process has nothing to report, and takes its statuses later
+  auto wanted = [this](pid_t tgid) {
+    auto it = by_pid_.find(tgid);
+    return it != by_pid_.end() && it->second->has_running_threads();
+  };
+  for (;;) {
+    auto pid = process::next_pending_thread_group(wanted);
+    auto& proc = *by_pid_.at(pid);
+    if (auto reason = proc.poll_stop()) return { proc, *reason };
+  }
+}
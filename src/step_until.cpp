@@ -0,0 +1,29 @@
+#include <libxdb/bits.hpp>
+#include <libxdb/process.hpp>
+#include <libxdb/step_until.hpp>
+
+namespace {
+  // the register's bytes, so a NaN that stays put isn't a change
+  xdb::byte128 register_bytes(const xdb::process& proc, const xdb::register_info& info) {
+    return std::visit([](auto v) { return xdb::as_byte128(v); }, proc.get_registers().read(info));
+  }
+}
+
+xdb::step_predicate xdb::pc_outside(const process& proc, virt_addr low, virt_addr high) {
+  return [&proc, low, high] {
+    auto pc = proc.get_pc();
+    return pc < low || pc >= high;
+  };
+}
+
+xdb::step_predicate xdb::register_changes(const process& proc, const register_info& info) {
+  return [&proc, &info, start = register_bytes(proc, info)] {
+    return register_bytes(proc, info) != start;
+  };
+}
+
+xdb::step_predicate xdb::memory_changes(const process& proc, virt_addr address, std::size_t size) {
+  return [&proc, address, size, start = proc.read_memory_without_traps(address, size)] {
+    return proc.read_memory_without_traps(address, size) != start;
+  };
+}
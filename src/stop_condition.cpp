@@ -0,0 +1,308 @@
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <libxdb/error.hpp>
+#include <libxdb/parse.hpp>
+#include <libxdb/process.hpp>
+#include <libxdb/stop_condition.hpp>
+
+namespace xdb {
+// Recursive descent over the text, emitting code as it goes. Precedence from
+// loosest: ||, &&, comparisons, |, ^, &, + -, unary ! - ~.
+class condition_compiler {
+ public:
+  using opcode = stop_condition::opcode;
+
+  explicit condition_compiler(std::string_view text) : text_(text) {}
+
+  std::vector<stop_condition::instruction> compile() {
+    parse_or();
+    skip_space();
+    if (pos_ != text_.size()) {
+      error::send("Unexpected '" + std::string(text_.substr(pos_)) + "' in condition");
+    }
+    if (max_depth_ > stop_condition::max_stack) {
+      error::send("Condition is too complex");
+    }
+    return std::move(code_);
+  }
+
+ private:
+  void skip_space() {
+    while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+  }
+
+  // consumes op if it comes next (and isn't the start of a longer operator)
+  bool accept(std::string_view op) {
+    skip_space();
+    if (text_.substr(pos_, op.size()) != op) return false;
+    auto next = pos_ + op.size() < text_.size() ? text_[pos_ + op.size()] : '\0';
+    if (op.size() == 1 && (op == "&" || op == "|") && next == op[0]) return false;
+    if (op.size() == 1 && (op == "<" || op == ">" || op == "!") && next == '=') return false;
+    pos_ += op.size();
+    return true;
+  }
+
+  void expect(std::string_view op) {
+    if (!accept(op)) error::send("Expected '" + std::string(op) + "' in condition");
+  }
+
+  void emit(opcode op, std::uint64_t operand = 0, std::uint8_t size = 0) {
+    code_.push_back({ op, size, operand });
+    switch (op) {
+      case opcode::push:
+      case opcode::reg:
+        max_depth_ = std::max(max_depth_, ++depth_);
+        break;
+      case opcode::load:
+      case opcode::logical_not:
+      case opcode::negate:
+      case opcode::complement:
+      case opcode::to_bool:
+        break;
+      default:
+        // binary operators, and the jumps on their fall-through path
+        --depth_;
+        break;
+    }
+  }
+
+  void parse_or() {
+    parse_and();
+    while (accept("||")) {
+      auto jump = code_.size();
+      emit(opcode::or_jump);
+      parse_and();
+      emit(opcode::to_bool);
+      code_[jump].operand = code_.size();
+    }
+  }
+
+  void parse_and() {
+    parse_comparison();
+    while (accept("&&")) {
+      auto jump = code_.size();
+      emit(opcode::and_jump);
+      parse_comparison();
+      emit(opcode::to_bool);
+      code_[jump].operand = code_.size();
+    }
+  }
+
+  void parse_comparison() {
+    parse_bit_or();
+    static constexpr std::pair<std::string_view, opcode> ops[] = {
+      { "==", opcode::eq }, { "!=", opcode::ne }, { "<=", opcode::le },
+      { ">=", opcode::ge }, { "<", opcode::lt }, { ">", opcode::gt },
+    };
+    for (bool matched = true; matched;) {
+      matched = false;
+      for (auto [text, op] : ops) {
+        if (accept(text)) {
+          parse_bit_or();
+          emit(op);
+          matched = true;
+          break;
+        }
+      }
+    }
+  }
+
+  void parse_bit_or() {
+    parse_bit_xor();
+    while (accept("|")) {
+      parse_bit_xor();
+      emit(opcode::bit_or);
+    }
+  }
+
+  void parse_bit_xor() {
+    parse_bit_and();
+    while (accept("^")) {
+      parse_bit_and();
+      emit(opcode::bit_xor);
+    }
+  }
+
+  void parse_bit_and() {
+    parse_additive();
+    while (accept("&")) {
+      parse_additive();
+      emit(opcode::bit_and);
+    }
+  }
+
+  void parse_additive() {
+    parse_unary();
+    for (;;) {
+      if (accept("+")) {
+        parse_unary();
+        emit(opcode::add);
+      } else if (accept("-")) {
+        parse_unary();
+        emit(opcode::sub);
+      } else {
+        return;
+      }
+    }
+  }
+
+  void parse_unary() {
+    if (accept("!")) {
+      parse_unary();
+      emit(opcode::logical_not);
+    } else if (accept("-")) {
+      parse_unary();
+      emit(opcode::negate);
+    } else if (accept("~")) {
+      parse_unary();
+      emit(opcode::complement);
+    } else {
+      parse_primary();
+    }
+  }
+
+  void parse_load(std::uint8_t size) {
+    parse_or();
+    expect("]");
+    emit(opcode::load, 0, size);
+  }
+
+  void parse_primary() {
+    skip_space();
+    if (accept("(")) {
+      parse_or();
+      expect(")");
+      return;
+    }
+    if (accept("[")) {
+      parse_load(8);
+      return;
+    }
+
+    auto start = pos_;
+    while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) {
+      ++pos_;
+    }
+    auto word = text_.substr(start, pos_ - start);
+    if (word.empty()) {
+      error::send("Expected a value in condition");
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(word[0]))) {
+      auto value = to_integer<std::uint64_t>(word);
+      if (!value) error::send("Invalid number '" + std::string(word) + "' in condition");
+      emit(opcode::push, *value);
+      return;
+    }
+
+    static constexpr std::pair<std::string_view, std::uint8_t> widths[] = {
+      { "byte", 1 }, { "word", 2 }, { "dword", 4 }, { "qword", 8 },
+    };
+    for (auto [name, size] : widths) {
+      if (word == name) {
+        expect("[");
+        parse_load(size);
+        return;
+      }
+    }
+
+    const register_info* info = nullptr;
+    try {
+      info = &register_info_by_name(word);
+    } catch (error&) {
+      error::send("Unknown register '" + std::string(word) + "' in condition");
+    }
+    if (info->format != register_format::uint || info->size > 8) {
+      error::send("Register '" + std::string(word) + "' can't be used in a condition");
+    }
+    emit(opcode::reg, static_cast<std::uint64_t>(info->id));
+  }
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+  std::vector<stop_condition::instruction> code_;
+  std::size_t depth_ = 0;
+  std::size_t max_depth_ = 0;
+};
+}  // namespace xdb
+
+xdb::stop_condition xdb::stop_condition::compile(std::string_view text) {
+  stop_condition ret;
+  ret.code_ = condition_compiler(text).compile();
+  ret.text_ = std::string(text);
+  return ret;
+}
+
+bool xdb::stop_condition::evaluate(const process& proc) const {
+  std::array<std::uint64_t, max_stack> stack;
+  std::size_t top = 0;
+  auto& regs = proc.get_registers();
+
+  for (std::size_t pc = 0; pc < code_.size(); ++pc) {
+    auto& inst = code_[pc];
+    switch (inst.op) {
+      case opcode::push:
+        stack[top++] = inst.operand;
+        break;
+      case opcode::reg: {
+        auto& info = register_info_by_id(static_cast<register_id>(inst.operand));
+        stack[top++] = std::visit([](auto v) -> std::uint64_t {
+          if constexpr (std::is_integral_v<decltype(v)>) {
+            return static_cast<std::uint64_t>(v);
+          } else {
+            return 0;
+          }
+        }, regs.read(info));
+        break;
+      }
+      case opcode::load: {
+        std::array<std::byte, sizeof(std::uint64_t)> data;
+        proc.read_memory_without_traps(virt_addr{ stack[top - 1] }, data.data(), inst.size);
+        std::uint64_t value = 0;
+        std::memcpy(&value, data.data(), inst.size);
+        stack[top - 1] = value;
+        break;
+      }
+      case opcode::logical_not: stack[top - 1] = !stack[top - 1]; break;
+      case opcode::negate: stack[top - 1] = -stack[top - 1]; break;
+      case opcode::complement: stack[top - 1] = ~stack[top - 1]; break;
+      case opcode::to_bool: stack[top - 1] = stack[top - 1] != 0; break;
+      case opcode::and_jump:
+        if (stack[top - 1] == 0) {
+          pc = inst.operand - 1;
+        } else {
+          --top;
+        }
+        break;
+      case opcode::or_jump:
+        if (stack[top - 1] != 0) {
+          stack[top - 1] = 1;
+          pc = inst.operand - 1;
+        } else {
+          --top;
+        }
+        break;
+      default: {
+        auto rhs = stack[--top];
+        auto& lhs = stack[top - 1];
+        switch (inst.op) {
+          case opcode::add: lhs += rhs; break;
+          case opcode::sub: lhs -= rhs; break;
+          case opcode::bit_and: lhs &= rhs; break;
+          case opcode::bit_or: lhs |= rhs; break;
+          case opcode::bit_xor: lhs ^= rhs; break;
+          case opcode::eq: lhs = lhs == rhs; break;
+          case opcode::ne: lhs = lhs != rhs; break;
+          case opcode::lt: lhs = lhs < rhs; break;
+          case opcode::le: lhs = lhs <= rhs; break;
+          case opcode::gt: lhs = lhs > rhs; break;
+          case opcode::ge: lhs = lhs >= rhs; break;
+          default: break;
+        }
+        break;
+      }
+    }
+  }
+  return top > 0 && stack[top - 1] != 0;
+}
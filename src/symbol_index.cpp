@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <libxdb/symbol_index.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+  constexpr char image_magic[8] = { 'X', 'D', 'B', 'I', 'N', 'D', 'E', 'X' };
+
+  enum table_id {
+    starts_table,
+    symbols_table,
+    names_table,
+    rows_table,
+    files_table,
+    strings_table,
+    n_tables,
+  };
+
+  // count elements of the table's type, from offset in the image
+  struct table_ref {
+    std::uint64_t offset;
+    std::uint64_t count;
+  };
+
+  struct image_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t build_id_size;
+    std::uint8_t build_id[64];
+    // of the whole image, and the checksum of all of it after this header
+    std::uint64_t size;
+    std::uint64_t checksum;
+    // what the symbol numbers index, which they are checked against
+    std::uint64_t n_elf_symbols;
+    table_ref tables[n_tables];
+  };
+
+  // the end and symbol number of each start in the starts table
+  struct symbol_entry {
+    std::uint64_t end;
+    std::uint64_t symbol;
+  };
+
+  struct row_entry {
+    std::uint64_t address;
+    std::uint32_t file;
+    std::uint32_t line;
+    std::uint32_t column;
+    std::uint8_t is_stmt;
+    std::uint8_t end_sequence;
+    std::uint16_t padding;
+  };
+
+  // a path in the strings table
+  struct file_entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  constexpr std::size_t element_sizes[n_tables] = {
+    sizeof(std::uint64_t), sizeof(symbol_entry), sizeof(std::uint32_t),
+    sizeof(row_entry),     sizeof(file_entry),   1,
+  };
+
+  /// Four independent lanes of multiply and xor, so the checksum runs at
+  /// memory speed rather than at the latency of one long chain of multiplies.
+  std::uint64_t checksum(const std::byte* data, std::size_t size) {
+    constexpr std::uint64_t prime = 0x9e3779b97f4a7c15;
+    std::uint64_t lanes[4] = { 1, 2, 3, 4 };
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+      for (int lane = 0; lane < 4; ++lane) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i + lane * 8, 8);
+        lanes[lane] = (lanes[lane] ^ word) * prime;
+        lanes[lane] ^= lanes[lane] >> 31;
+      }
+    }
+    std::uint64_t hash = size;
+    for (auto lane : lanes) hash = (hash ^ lane) * prime;
+    for (; i < size; ++i) hash = (hash ^ static_cast<std::uint8_t>(data[i])) * prime;
+    return hash ^ (hash >> 29);
+  }
+
+  std::string to_hex(xdb::span<std::byte> bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (auto byte : bytes) {
+      hex += digits[static_cast<std::uint8_t>(byte) >> 4];
+      hex += digits[static_cast<std::uint8_t>(byte) & 0xf];
+    }
+    return hex;
+  }
+
+  bool ends_with_path(std::string_view path, std::string_view suffix) {
+    if (suffix.empty() || path.size() < suffix.size()) return false;
+    if (path.substr(path.size() - suffix.size()) != suffix) return false;
+    return path.size() == suffix.size() || suffix.front() == '/' || path[path.size() - suffix.size() - 1] == '/';
+  }
+}
+
+std::filesystem::path xdb::symbol_index::default_cache_dir() {
+  if (auto cache = std::getenv("XDG_CACHE_HOME"); cache && *cache) return std::filesystem::path(cache) / "xdb";
+  if (auto home = std::getenv("HOME"); home && *home) return std::filesystem::path(home) / ".cache" / "xdb";
+  return std::filesystem::temp_directory_path() / "xdb";
+}
+
+/// The symbol tables are the elf's own indexes as they are in memory, with
+/// pointers turned into symbol numbers. The line table is every unit's
+/// sequences, sorted by start and concatenated, with each unit's file
+/// numbers mapped to one table of full paths.
+std::vector<std::byte> xdb::symbol_index::build_image(const elf& file) {
+  if (!file.address_index_built_) file.build_address_index();
+  if (!file.name_index_) file.build_name_index();
+  auto symbols = file.symbols();
+  auto symbol_number = [&](const Elf64_Sym* symbol) -> std::uint64_t { return symbol - symbols.data(); };
+
+  std::vector<symbol_entry> entries;
+  entries.reserve(file.address_entries_.size());
+  for (auto& entry : file.address_entries_) entries.push_back({ entry.end, symbol_number(entry.symbol) });
+  std::vector<std::uint32_t> names;
+  names.reserve(file.name_index_->size());
+  for (auto& [name, symbol] : *file.name_index_) names.push_back(static_cast<std::uint32_t>(symbol_number(symbol)));
+
+  std::vector<row_entry> rows;
+  std::vector<file_entry> files;
+  std::string strings;
+  if (file.get_section(".debug_info")) {
+    dwarf info(file);
+    std::unordered_map<std::string, std::uint32_t> file_ids;
+    struct sequence {
+      const compile_unit* unit;
+      const line_row* first;
+      const line_row* last;
+    };
+    std::vector<sequence> sequences;
+    for (auto& unit : info.compile_units()) {
+      auto& table = unit->lines();
+      auto first = table.rows.begin();
+      for (auto row = table.rows.begin(); row != table.rows.end(); ++row) {
+        if (!row->end_sequence) continue;
+        sequences.push_back({ unit.get(), first, row });
+        first = row + 1;
+      }
+    }
+    std::stable_sort(sequences.begin(), sequences.end(),
+                     [](auto& a, auto& b) { return a.first->address < b.first->address; });
+
+    const compile_unit* last_unit = nullptr;
+    std::vector<std::optional<std::uint32_t>> unit_files;
+    for (auto& [unit, first, last] : sequences) {
+      auto& table = unit->lines();
+      if (unit != last_unit) {
+        unit_files.assign(table.files.size(), std::nullopt);
+        last_unit = unit;
+      }
+      for (auto row = first; row <= last; ++row) {
+        std::uint32_t id = 0;
+        if (row->file < unit_files.size()) {
+          auto& cached = unit_files[row->file];
+          if (!cached) {
+            auto path = unit->file_path(table, row->file).string();
+            auto [it, inserted] = file_ids.emplace(path, static_cast<std::uint32_t>(files.size()));
+            if (inserted) {
+              files.push_back({ strings.size(), path.size() });
+              strings += path;
+            }
+            cached = it->second;
+          }
+          id = *cached;
+        }
+        rows.push_back({ row->address, id, row->line, row->column, row->is_stmt, row->end_sequence, 0 });
+      }
+    }
+  }
+
+  image_header header{};
+  std::memcpy(header.magic, image_magic, sizeof(image_magic));
+  header.version = format_version;
+  auto id = file.build_id();
+  header.build_id_size = static_cast<std::uint32_t>(std::min(id.size(), sizeof(header.build_id)));
+  std::memcpy(header.build_id, id.data(), header.build_id_size);
+  header.n_elf_symbols = symbols.size();
+
+  std::vector<std::byte> image(sizeof(header));
+  auto append = [&](table_id which, const void* data, std::size_t count) {
+    image.resize((image.size() + 7) & ~std::size_t{ 7 });
+    header.tables[which] = { image.size(), count };
+    auto bytes = static_cast<const std::byte*>(data);
+    image.insert(image.end(), bytes, bytes + count * element_sizes[which]);
+  };
+  append(starts_table, file.address_starts_.data(), file.address_starts_.size());
+  append(symbols_table, entries.data(), entries.size());
+  append(names_table, names.data(), names.size());
+  append(rows_table, rows.data(), rows.size());
+  append(files_table, files.data(), files.size());
+  append(strings_table, strings.data(), strings.size());
+  image.resize((image.size() + 7) & ~std::size_t{ 7 });
+
+  header.size = image.size();
+  header.checksum = checksum(image.data() + sizeof(header), image.size() - sizeof(header));
+  std::memcpy(image.data(), &header, sizeof(header));
+  return image;
+}
+
+bool xdb::symbol_index::is_sound(const elf& file, const std::byte* data, std::size_t size) {
+  if (size < sizeof(image_header)) return false;
+  image_header header;
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, image_magic, sizeof(image_magic)) != 0) return false;
+  if (header.version != format_version || header.size != size) return false;
+  auto id = file.build_id();
+  if (header.build_id_size != id.size() || header.build_id_size > sizeof(header.build_id) ||
+      std::memcmp(header.build_id, id.data(), id.size()) != 0) {
+    return false;
+  }
+  if (header.n_elf_symbols != file.symbols().size()) return false;
+  for (int which = 0; which < n_tables; ++which) {
+    auto [offset, count] = header.tables[which];
+    if (offset % 8 != 0 || offset < sizeof(header) || offset > size) return false;
+    if (count > (size - offset) / element_sizes[which]) return false;
+  }
+  if (header.tables[starts_table].count != header.tables[symbols_table].count) return false;
+  return checksum(data + sizeof(header), size - sizeof(header)) == header.checksum;
+}
+
+std::unique_ptr<xdb::symbol_index> xdb::symbol_index::build(const elf& file) {
+  std::unique_ptr<symbol_index> index(new symbol_index(file));
+  index->built_ = build_image(file);
+  index->data_ = index->built_.data();
+  index->size_ = index->built_.size();
+  return index;
+}
+
+/// An image that can't be used is rebuilt and replaced. A new image is
+/// written beside its final name and renamed over it, so another xdb
+/// starting at the same time maps the old file or the new, never half of
+/// one; if the cache can't be written the index is still used from memory.
+std::unique_ptr<xdb::symbol_index> xdb::symbol_index::load(const elf& file, const std::filesystem::path& cache_dir) {
+  auto id = file.build_id();
+  if (id.empty()) return build(file);
+  auto path = cache_dir / (to_hex(id) + ".index");
+
+  if (auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0) {
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (mapping != MAP_FAILED) {
+      auto data = static_cast<const std::byte*>(mapping);
+      if (is_sound(file, data, info.st_size)) {
+        std::unique_ptr<symbol_index> index(new symbol_index(file));
+        index->mapping_ = mapping;
+        index->data_ = data;
+        index->size_ = info.st_size;
+        index->cache_path_ = path;
+        return index;
+      }
+      munmap(mapping, info.st_size);
+    }
+  }
+
+  auto index = build(file);
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir, ec);
+  auto temporary = path;
+  temporary += ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(index->data_), index->size_);
+    if (!out.good()) {
+      out.close();
+      std::filesystem::remove(temporary, ec);
+      return index;
+    }
+  }
+  std::filesystem::rename(temporary, path, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+  } else {
+    index->cache_path_ = path;
+  }
+  return index;
+}
+
+xdb::symbol_index::~symbol_index() {
+  if (mapping_) munmap(mapping_, size_);
+}
+
+template <class T>
+xdb::span<T> xdb::symbol_index::table(std::size_t which) const {
+  // the image is page aligned when mapped and vector aligned when built
+  auto [offset, count] = reinterpret_cast<const image_header*>(data_)->tables[which];
+  return { reinterpret_cast<const T*>(data_ + offset), count };
+}
+
+std::string_view xdb::symbol_index::file_name(std::uint32_t file) const {
+  auto files = table<file_entry>(files_table);
+  auto strings = table<char>(strings_table);
+  if (file >= files.size()) return {};
+  auto [offset, size] = files[file];
+  if (offset > strings.size() || size > strings.size() - offset) return {};
+  return { strings.data() + offset, size };
+}
+
+/// The same branchless search as elf::symbol_containing_address, over the
+/// starts the elf sorted when the image was built.
+const Elf64_Sym* xdb::symbol_index::symbol_containing_address(virt_addr address) const {
+  auto starts = table<std::uint64_t>(starts_table);
+  auto entries = table<symbol_entry>(symbols_table);
+  auto file_address = address.addr() - elf_->load_bias();
+  if (starts.empty() || file_address < starts[0]) return nullptr;
+  auto base = starts.data();
+  for (auto n = starts.size(); n > 1;) {
+    auto half = n / 2;
+    base = base[half] <= file_address ? base + half : base;
+    n -= half;
+  }
+  auto& entry = entries[base - starts.data()];
+  auto symbols = elf_->symbols();
+  return file_address < entry.end && entry.symbol < symbols.size() ? &symbols[entry.symbol] : nullptr;
+}
+
+const Elf64_Sym* xdb::symbol_index::symbol_by_name(std::string_view name) const {
+  auto names = table<std::uint32_t>(names_table);
+  auto symbols = elf_->symbols();
+  auto name_of = [&](std::uint32_t number) {
+    return number < symbols.size() ? elf_->symbol_name(symbols[number]) : std::string_view{};
+  };
+  auto it = std::lower_bound(names.begin(), names.end(), name,
+                             [&](std::uint32_t number, std::string_view name) { return name_of(number) < name; });
+  return it != names.end() && name_of(*it) == name ? &symbols[*it] : nullptr;
+}
+
+std::optional<xdb::line_entry> xdb::symbol_index::line_entry_at_address(virt_addr address) const {
+  auto rows = table<row_entry>(rows_table);
+  auto file_address = address.addr() - elf_->load_bias();
+  auto it = std::upper_bound(rows.begin(), rows.end(), file_address,
+                             [](auto address, auto& row) { return address < row.address; });
+  if (it == rows.begin()) return std::nullopt;
+  --it;
+  if (it->end_sequence) return std::nullopt;
+  return line_entry{ virt_addr{ it->address + elf_->load_bias() }, std::filesystem::path(file_name(it->file)),
+                     it->line, it->column, it->is_stmt != 0 };
+}
+
+std::vector<xdb::virt_addr> xdb::symbol_index::addresses_for_line(std::string_view file, std::uint64_t line) const {
+  auto files = table<file_entry>(files_table);
+  std::vector<bool> matches(files.size());
+  bool any = false;
+  for (std::uint32_t i = 0; i < files.size(); ++i) {
+    matches[i] = ends_with_path(file_name(i), file);
+    any = any || matches[i];
+  }
+  std::vector<virt_addr> addresses;
+  if (!any) return addresses;
+
+  auto rows = table<row_entry>(rows_table);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    auto& row = rows[i];
+    if (row.end_sequence || !row.is_stmt || row.line != line) continue;
+    if (row.file >= matches.size() || !matches[row.file]) continue;
+    if (i > 0) {
+      auto& previous = rows[i - 1];
+      if (!previous.end_sequence && previous.line == line && previous.file == row.file) continue;
+    }
+    addresses.push_back(virt_addr{ row.address + elf_->load_bias() });
+  }
+  std::sort(addresses.begin(), addresses.end());
+  return addresses;
+}
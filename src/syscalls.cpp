@@ -0,0 +1,74 @@
+#include <libxdb/error.hpp>
+#include <libxdb/syscalls.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace {
+  struct syscall_entry {
+    std::string_view name;
+    int id;
+  };
+
+  constexpr syscall_entry g_syscalls[] = {
+    #define DEFINE_SYSCALL(name, id) { #name, id }
+    #include <libxdb/detail/syscalls.inc>
+    #undef DEFINE_SYSCALL
+  };
+
+  const std::unordered_map<std::string_view, int>& syscalls_by_name() {
+    static const auto table = [] {
+      std::unordered_map<std::string_view, int> table;
+      for (auto& entry : g_syscalls) table.emplace(entry.name, entry.id);
+      return table;
+    }();
+    return table;
+  }
+
+  const std::unordered_map<int, std::string_view>& syscalls_by_id() {
+    static const auto table = [] {
+      std::unordered_map<int, std::string_view> table;
+      for (auto& entry : g_syscalls) table.emplace(entry.id, entry.name);
+      return table;
+    }();
+    return table;
+  }
+}
+
+std::string_view xdb::syscall_id_to_name(int id) {
+  auto it = syscalls_by_id().find(id);
+  if (it == syscalls_by_id().end()) {
+    error::send("No syscall with number " + std::to_string(id));
+  }
+  return it->second;
+}
+
+int xdb::syscall_name_to_id(std::string_view name) {
+  auto it = syscalls_by_name().find(name);
+  if (it == syscalls_by_name().end()) {
+    error::send("No such syscall: " + std::string(name));
+  }
+  return it->second;
+}
+
+/// The number of arguments a syscall takes isn't in the table, so all six
+/// argument registers are printed.
+std::ostream& xdb::operator<<(std::ostream& out, const syscall_record& record) {
+  out << record.tid << ' ';
+  auto& names = syscalls_by_id();
+  if (auto it = names.find(record.id); it != names.end()) {
+    out << it->second;
+  } else {
+    out << "syscall_" << record.id;
+  }
+  out << std::hex << '(';
+  for (std::size_t i = 0; i < record.args.size(); ++i) {
+    out << (i ? ", 0x" : "0x") << record.args[i];
+  }
+  out << std::dec << ") = ";
+  if (record.ret) {
+    out << *record.ret;
+  } else {
+    out << '?';
+  }
+  return out << '\n';
+}
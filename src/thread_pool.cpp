@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <csignal>
+#include <libxdb/thread_pool.hpp>
+#include <sys/resource.h>
+#include <unistd.h>
+
+xdb::thread_pool::thread_pool(std::size_t n_workers, int niceness) {
+  if (n_workers == 0) n_workers = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t i = 0; i < n_workers; ++i) workers_.push_back(std::make_unique<worker>());
+  // threads inherit the mask they are started with
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  for (std::size_t i = 0; i < n_workers; ++i) {
+    workers_[i]->thread = std::thread([this, i, niceness] { run(i, niceness); });
+  }
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+}
+
+xdb::thread_pool::~thread_pool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) worker->thread.join();
+}
+
+void xdb::thread_pool::submit(task work) {
+  auto& target = *workers_[next_++ % workers_.size()];
+  // counted as pending before anyone can run it, and as queued only once
+  // it can be found
+  {
+    std::lock_guard lock(mutex_);
+    ++pending_;
+  }
+  {
+    std::lock_guard lock(target.mutex);
+    target.tasks.push_back(std::move(work));
+  }
+  {
+    std::lock_guard lock(mutex_);
+    ++queued_;
+  }
+  wake_.notify_one();
+}
+
+void xdb::thread_pool::submit(std::vector<task> batch) {
+  {
+    std::lock_guard lock(mutex_);
+    pending_ += batch.size();
+  }
+  for (auto& work : batch) {
+    auto& target = *workers_[next_++ % workers_.size()];
+    std::lock_guard lock(target.mutex);
+    target.tasks.push_back(std::move(work));
+  }
+  {
+    std::lock_guard lock(mutex_);
+    queued_ += batch.size();
+  }
+  wake_.notify_all();
+}
+
+void xdb::thread_pool::wait_idle() {
+  std::unique_lock lock(mutex_);
+  idle_.wait(lock, [&] { return pending_ == 0; });
+}
+
+/// queued_ is dropped with the deque still locked, so it never says a deque
+/// is empty while it still holds the task; it can dip below zero when a task
+/// is taken before submit has counted it.
+bool xdb::thread_pool::pop(std::size_t self, task& work) {
+  auto take = [&](worker& from, bool newest) {
+    std::lock_guard lock(from.mutex);
+    if (from.tasks.empty()) return false;
+    if (newest) {
+      work = std::move(from.tasks.back());
+      from.tasks.pop_back();
+    } else {
+      work = std::move(from.tasks.front());
+      from.tasks.pop_front();
+    }
+    std::lock_guard count(mutex_);
+    --queued_;
+    return true;
+  };
+  if (take(*workers_[self], true)) return true;
+  for (std::size_t i = 1; i < workers_.size(); ++i) {
+    if (take(*workers_[(self + i) % workers_.size()], false)) return true;
+  }
+  return false;
+}
+
+void xdb::thread_pool::run(std::size_t self, int niceness) {
+  // on Linux a nice value belongs to the thread, not the process
+  if (niceness > 0) setpriority(PRIO_PROCESS, gettid(), getpriority(PRIO_PROCESS, gettid()) + niceness);
+  for (;;) {
+    task work;
+    if (pop(self, work)) {
+      work();
+      std::lock_guard lock(mutex_);
+      if (--pending_ == 0) idle_.notify_all();
+      continue;
+    }
+    std::unique_lock lock(mutex_);
+    wake_.wait(lock, [&] { return stopping_ || queued_ > 0; });
+    if (stopping_) return;
+  }
+}
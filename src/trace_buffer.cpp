@@ -0,0 +1,18 @@
+#include <libxdb/error.hpp>
+#include <libxdb/trace_buffer.hpp>
+#include <sys/mman.h>
+
+xdb::trace_buffer::trace_buffer(int fd, std::size_t capacity) : capacity_(capacity) {
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+    error::send("Trace buffer capacity must be a power of two");
+  }
+  mapping_ = mmap(nullptr, size_for(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping_ == MAP_FAILED) {
+    error::send_errno("Could not map trace buffer");
+  }
+  records_ = reinterpret_cast<record*>(static_cast<char*>(mapping_) + header_size);
+}
+
+xdb::trace_buffer::~trace_buffer() {
+  munmap(mapping_, size_for(capacity_));
+}
@@ -0,0 +1,29 @@
+#include <libxdb/process.hpp>
+#include <libxdb/trace_buffer.hpp>
+#include <libxdb/tracepoint.hpp>
+
+namespace {
+  auto get_next_id() {
+    static xdb::tracepoint::id_t id = 0;
+    return ++id;
+  }
+}
+
+xdb::tracepoint::tracepoint(process& proc, virt_addr address, std::vector<trace_field> fields)
+  : id_(get_next_id()), process_(proc), address_(address), fields_(std::move(fields)) {
+  if (fields_.size() > trace_buffer::max_fields) {
+    error::send("Too many tracepoint fields");
+  }
+}
+
+void xdb::tracepoint::enable() {
+  if (is_enabled_) return;
+  process_.enable_tracepoint(*this);
+  is_enabled_ = true;
+}
+
+void xdb::tracepoint::disable() {
+  if (!is_enabled_) return;
+  process_.disable_tracepoint(*this);
+  is_enabled_ = false;
+}
@@ -0,0 +1,44 @@
+#include <cstring>
+#include <libxdb/process.hpp>
+#include <libxdb/watchpoint.hpp>
+#include <utility>
+
+namespace {
+  auto get_next_id() {
+    static xdb::watchpoint::id_t id = 0;
+    return ++id;
+  }
+}
+
+xdb::watchpoint::watchpoint(process& proc, virt_addr address, stoppoint_mode mode, std::size_t size)
+  : id_(get_next_id()), process_(proc), address_(address), mode_(mode), size_(size) {
+  if (size != 1 && size != 2 && size != 4 && size != 8) {
+    error::send("Invalid watchpoint size");
+  }
+  if (mode == stoppoint_mode::execute && size != 1) {
+    error::send("Execute watchpoints must have size 1");
+  }
+  if ((address.addr() & (size - 1)) != 0) {
+    error::send("Watchpoint must be aligned to size");
+  }
+  update_data();
+}
+
+void xdb::watchpoint::enable() {
+  if (is_enabled_) return;
+  hardware_register_index_ = process_.set_watchpoint(address_, mode_, size_);
+  is_enabled_ = true;
+}
+
+void xdb::watchpoint::disable() {
+  if (!is_enabled_) return;
+  process_.clear_hardware_stoppoint(hardware_register_index_);
+  is_enabled_ = false;
+}
+
+void xdb::watchpoint::update_data() {
+  std::uint64_t new_data = 0;
+  auto read = process_.read_memory(address_, size_);
+  std::memcpy(&new_data, read.data(), size_);
+  previous_data_ = std::exchange(data_, new_data);
+}
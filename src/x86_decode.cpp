@@ -0,0 +1,210 @@
+#include <libxdb/x86_decode.hpp>
+
+namespace {
+  bool in(std::uint8_t op, std::uint8_t low, std::uint8_t high) {
+    return op >= low && op <= high;
+  }
+
+  // one-byte opcodes taking a ModRM byte
+  bool has_modrm_1(std::uint8_t op) {
+    if (op < 0x40) return (op & 0x07) < 4;
+    return op == 0x63 || op == 0x69 || op == 0x6b || in(op, 0x80, 0x8f) ||
+           op == 0xc0 || op == 0xc1 || op == 0xc6 || op == 0xc7 ||
+           in(op, 0xd0, 0xd3) || in(op, 0xd8, 0xdf) ||
+           op == 0xf6 || op == 0xf7 || op == 0xfe || op == 0xff;
+  }
+
+  // opcodes in the 0F map without a ModRM byte
+  bool has_modrm_0f(std::uint8_t op) {
+    return !(in(op, 0x05, 0x09) || op == 0x0b || op == 0x0e || in(op, 0x30, 0x37) ||
+             op == 0x77 || in(op, 0x80, 0x8f) || in(op, 0xa0, 0xa2) || in(op, 0xa8, 0xaa) ||
+             in(op, 0xc8, 0xcf));
+  }
+
+  bool has_imm8_0f(std::uint8_t op) {
+    return in(op, 0x70, 0x73) || op == 0xa4 || op == 0xac || op == 0xba || op == 0xc2 || in(op, 0xc4, 0xc6);
+  }
+
+  bool invalid_in_64_bit(std::uint8_t op) {
+    switch (op) {
+      case 0x06: case 0x07: case 0x0e: case 0x16: case 0x17: case 0x1e: case 0x1f:
+      case 0x27: case 0x2f: case 0x37: case 0x3f: case 0x60: case 0x61: case 0x82:
+      case 0x9a: case 0xd4: case 0xd5: case 0xd6: case 0xea:
+        return true;
+      default:
+        return false;
+    }
+  }
+}
+
+std::optional<xdb::x86_instruction> xdb::decode_x86(const std::byte* code, std::size_t size) {
+  x86_instruction inst;
+  std::size_t pos = 0;
+  auto byte_at = [&](std::size_t i) -> std::optional<std::uint8_t> {
+    if (i >= size || i >= 15) return std::nullopt;
+    return static_cast<std::uint8_t>(code[i]);
+  };
+
+  // legacy prefixes
+  bool operand_size_16 = false;
+  bool address_size_32 = false;
+  for (;;) {
+    auto b = byte_at(pos);
+    if (!b) return std::nullopt;
+    if (*b == 0x66) {
+      operand_size_16 = true;
+    } else if (*b == 0x67) {
+      address_size_32 = true;
+    } else if (!(*b == 0xf0 || *b == 0xf2 || *b == 0xf3 || *b == 0x2e || *b == 0x36 ||
+                 *b == 0x3e || *b == 0x26 || *b == 0x64 || *b == 0x65)) {
+      break;
+    }
+    ++pos;
+  }
+
+  bool rex_w = false;
+  if (auto b = byte_at(pos); b && (*b & 0xf0) == 0x40) {
+    rex_w = *b & 0x08;
+    ++pos;
+  }
+
+  // map: 1 = one-byte, 2 = 0F, 3 = 0F38, 4 = 0F3A
+  int map = 1;
+  bool modrm = false;
+  std::size_t imm_size = 0;
+  auto op_byte = byte_at(pos);
+  if (!op_byte) return std::nullopt;
+  std::uint8_t op = *op_byte;
+
+  if (op == 0xc4 || op == 0xc5 || op == 0x62) {
+    // VEX/EVEX: the prefix encodes the map, and the opcode always has a ModRM
+    // (except vzeroupper/vzeroall, which is 77 with no ModRM)
+    if (op == 0xc5) {
+      map = 2;
+      pos += 2;
+    } else {
+      auto p0 = byte_at(pos + 1);
+      if (!p0) return std::nullopt;
+      auto mm = *p0 & (op == 0x62 ? 0x07 : 0x1f);
+      if (mm < 1 || mm > 3) return std::nullopt;
+      map = mm + 1;
+      pos += op == 0x62 ? 4 : 3;
+    }
+    op_byte = byte_at(pos);
+    if (!op_byte) return std::nullopt;
+    op = *op_byte;
+    ++pos;
+    modrm = !(map == 2 && op == 0x77);
+    if (map == 4 || (map == 2 && has_imm8_0f(op))) imm_size = 1;
+  } else if (op == 0x0f) {
+    auto op2 = byte_at(pos + 1);
+    if (!op2) return std::nullopt;
+    if (*op2 == 0x38 || *op2 == 0x3a) {
+      map = *op2 == 0x38 ? 3 : 4;
+      op_byte = byte_at(pos + 2);
+      if (!op_byte) return std::nullopt;
+      op = *op_byte;
+      pos += 3;
+      modrm = true;
+      imm_size = map == 4 ? 1 : 0;
+    } else {
+      map = 2;
+      op = *op2;
+      pos += 2;
+      if (op == 0x0f) return std::nullopt;  // 3DNow!
+      modrm = has_modrm_0f(op);
+      if (has_imm8_0f(op)) imm_size = 1;
+      if (in(op, 0x80, 0x8f)) {
+        inst.flow = x86_flow::jcc_rel;
+        inst.condition = op & 0x0f;
+        imm_size = 4;
+      }
+    }
+  } else {
+    ++pos;
+    if (invalid_in_64_bit(op)) return std::nullopt;
+    modrm = has_modrm_1(op);
+    auto imm_z = operand_size_16 ? 2 : 4;
+    if ((op < 0x40 && (op & 0x07) == 4) || op == 0x6a || op == 0x6b || op == 0x80 || op == 0x83 ||
+        op == 0xa8 || in(op, 0xb0, 0xb7) || op == 0xc0 || op == 0xc1 || op == 0xc6 || op == 0xcd) {
+      imm_size = 1;
+    } else if ((op < 0x40 && (op & 0x07) == 5) || op == 0x68 || op == 0x69 || op == 0x81 || op == 0xa9 || op == 0xc7) {
+      imm_size = imm_z;
+    } else if (in(op, 0xb8, 0xbf)) {
+      imm_size = rex_w ? 8 : imm_z;
+    } else if (in(op, 0xa0, 0xa3)) {
+      imm_size = address_size_32 ? 4 : 8;
+    } else if (op == 0xca) {
+      imm_size = 2;
+    } else if (op == 0xc8) {
+      imm_size = 3;
+    } else if (in(op, 0x70, 0x7f)) {
+      inst.flow = x86_flow::jcc_rel;
+      inst.condition = op & 0x0f;
+      imm_size = 1;
+    } else if (op == 0xeb) {
+      inst.flow = x86_flow::jmp_rel;
+      imm_size = 1;
+    } else if (op == 0xe9) {
+      inst.flow = x86_flow::jmp_rel;
+      imm_size = 4;
+    } else if (op == 0xe8) {
+      inst.flow = x86_flow::call_rel;
+      imm_size = 4;
+    } else if (in(op, 0xe0, 0xe3)) {
+      inst.flow = x86_flow::loop_rel;
+      imm_size = 1;
+    } else if (in(op, 0xe4, 0xe7)) {
+      imm_size = 1;
+    } else if (op == 0xc3 || op == 0xc2) {
+      inst.flow = x86_flow::ret;
+      if (op == 0xc2) imm_size = 2;
+    } else if (op == 0xcc || op == 0xce || op == 0xcf || op == 0xf1) {
+      inst.flow = x86_flow::other;
+    }
+    if (op == 0xcd) inst.flow = x86_flow::other;
+  }
+
+  if (modrm) {
+    auto m = byte_at(pos);
+    if (!m) return std::nullopt;
+    ++pos;
+    auto mod = *m >> 6;
+    auto reg = (*m >> 3) & 0x07;
+    auto rm = *m & 0x07;
+
+    if (map == 1 && (op == 0xf6 || op == 0xf7) && reg < 2) {
+      imm_size = op == 0xf6 ? 1 : (operand_size_16 ? 2 : 4);
+    }
+    if (map == 1 && op == 0xff && (reg == 2 || reg == 3)) {
+      inst.flow = x86_flow::call_indirect;
+    }
+    if (map == 1 && op == 0xff && (reg == 4 || reg == 5)) {
+      inst.flow = x86_flow::jmp_indirect;
+    }
+
+    if (mod != 3) {
+      if (rm == 4) {
+        auto sib = byte_at(pos);
+        if (!sib) return std::nullopt;
+        ++pos;
+        if (mod == 0 && (*sib & 0x07) == 5) pos += 4;
+      } else if (mod == 0 && rm == 5) {
+        inst.rip_disp_offset = pos;
+        pos += 4;
+      }
+      if (mod == 1) pos += 1;
+      if (mod == 2) pos += 4;
+    }
+  }
+
+  if (inst.flow == x86_flow::jmp_rel || inst.flow == x86_flow::jcc_rel ||
+      inst.flow == x86_flow::call_rel || inst.flow == x86_flow::loop_rel) {
+    inst.rel_offset = pos;
+    inst.rel_size = imm_size;
+  }
+  pos += imm_size;
+  if (pos > size || pos > 15) return std::nullopt;
+  inst.length = pos;
+  return inst;
+}
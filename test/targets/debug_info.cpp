@@ -0,0 +1,25 @@
+#include <csignal>
+#include <unistd.h>
+
+namespace shapes {
+  struct square {
+    int side;
+    int area() const;
+  };
+  int perimeter(const square& shape);
+}
+
+__attribute__((noinline)) int twice(int value) {
+  return value * 2;
+}
+
+// Built from two units with -g; reports twice's address and stops, then
+// calls into the other unit
+int main() {
+  auto address = &twice;
+  write(STDOUT_FILENO, &address, sizeof(void*));
+  raise(SIGTRAP);
+
+  shapes::square shape{ twice(3) };
+  return shape.area() + shapes::perimeter(shape) == 60 ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+namespace shapes {
+  struct square {
+    int side;
+    int area() const;
+  };
+
+  int square::area() const {
+    return side * side;
+  }
+
+  int perimeter(const square& shape) {
+    return 4 * shape.side;
+  }
+}
@@ -0,0 +1,36 @@
+#include <cstring>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+__attribute__((noinline)) void marker() {
+  asm volatile("" ::: "memory");
+}
+
+// Forks three children that each pass the marker and exit with their number,
+// writes how each of them ended, then re-executes itself, and passes the
+// marker once as the new image
+int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "again") == 0) {
+    marker();
+    return 0;
+  }
+
+  auto address = &marker;
+  write(STDOUT_FILENO, &address, sizeof(void*));
+  raise(SIGTRAP);
+
+  for (int i = 1; i <= 3; ++i) {
+    if (fork() == 0) {
+      marker();
+      _exit(i);
+    }
+  }
+  int status;
+  while (wait(&status) > 0) {
+    char code = WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status);
+    write(STDOUT_FILENO, &code, 1);
+  }
+  execl("/proc/self/exe", argv[0], "again", nullptr);
+  return 1;
+}
@@ -0,0 +1,31 @@
+#include <cstdio>
+#include <cstring>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+void write_address(const void* address) {
+  write(STDOUT_FILENO, &address, sizeof(void*));
+  fflush(stdout);
+  raise(SIGTRAP);
+}
+
+int main() {
+  unsigned long long a = 0xcafecafe;
+  write_address(&a);
+
+  char b[12] = {0};
+  write_address(&b);
+  printf("%s", b);
+  fflush(stdout);
+  raise(SIGTRAP);
+
+  // two pages filled with their page index, the second one read-only
+  auto pages = static_cast<char*>(mmap(nullptr, 0x2000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  std::memset(pages, 1, 0x1000);
+  std::memset(pages + 0x1000, 2, 0x1000);
+  mprotect(pages + 0x1000, 0x1000, PROT_READ);
+  write_address(pages);
+  printf("%d", pages[0x1000]);
+  fflush(stdout);
+}
@@ -0,0 +1,34 @@
+#include <cstdint>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+volatile std::uint64_t counter = 0;
+volatile bool done = false;
+
+__attribute__((noinline)) void marker() {
+  asm volatile("" ::: "memory");
+}
+
+void* spin(void*) {
+  while (!done) counter = counter + 1;
+  return nullptr;
+}
+
+void* hit(void*) {
+  marker();
+  return nullptr;
+}
+
+int main() {
+  void* addresses[] = { reinterpret_cast<void*>(&marker), const_cast<std::uint64_t*>(&counter) };
+  write(STDOUT_FILENO, addresses, sizeof(addresses));
+  raise(SIGTRAP);
+
+  pthread_t spinner, hitter;
+  pthread_create(&spinner, nullptr, spin, nullptr);
+  pthread_create(&hitter, nullptr, hit, nullptr);
+  pthread_join(hitter, nullptr);
+  done = true;
+  pthread_join(spinner, nullptr);
+}
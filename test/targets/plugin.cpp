@@ -0,0 +1,4 @@
+// Loaded by shared_objects with dlopen, so nothing links against it
+extern "C" int plugin_entry() {
+  return 42;
+}
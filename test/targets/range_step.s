@@ -0,0 +1,89 @@
+.global main
+
+.section .data
+
+# addresses for the debugger to step between
+sites:
+  .quad call_site
+  .quad after_call
+  .quad after_loop
+  .quad after_second
+  .quad work_loop
+  .quad recurse_call
+  .quad recurse_return
+  .quad after_recurse
+sites_end:
+
+.section .text
+
+  # call kill(pid, 5)
+  .macro trap
+    movq $62, %rax
+    movq %r12, %rdi
+    movq $5, %rsi
+    syscall
+  .endm
+
+  # a hundred thousand trips round a loop
+  work:
+    push %rbp
+    movq %rsp, %rbp
+    movq $100000, %rcx
+  work_loop:
+    decq %rcx
+    jnz work_loop
+    popq %rbp
+    ret
+
+  # calls itself %rdi more times
+  recurse:
+    push %rbp
+    movq %rsp, %rbp
+    testq %rdi, %rdi
+    jz recurse_done
+    decq %rdi
+  recurse_call:
+    call recurse
+  recurse_return:
+    nop
+  recurse_done:
+    popq %rbp
+    ret
+
+  main:
+    push %rbp
+    movq %rsp, %rbp
+    push %r12
+    push %r13
+
+    # save pid to %r12
+    movq $39, %rax
+    syscall
+    movq %rax, %r12
+
+    # write(1, sites, sites_end - sites)
+    movq $1, %rax
+    movq $1, %rdi
+    leaq sites(%rip), %rsi
+    movq $(sites_end - sites), %rdx
+    syscall
+    trap
+
+  call_site:
+    call work
+  after_call:
+    movq $1000, %r13
+  loop:
+    decq %r13
+    jnz loop
+  after_loop:
+    call work
+  after_second:
+    movq $3, %rdi
+    call recurse
+  after_recurse:
+    pop %r13
+    pop %r12
+    popq %rbp
+    movq $0, %rax
+    ret
@@ -0,0 +1,26 @@
+#include <csignal>
+#include <dlfcn.h>
+#include <limits.h>
+#include <string>
+#include <unistd.h>
+
+// Loads libplugin.so from its own directory, calls into it and unloads it,
+// then stops, does it all again, and exits with what the plugin returned
+int main() {
+  char self[PATH_MAX];
+  auto length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+  if (length < 0) return 1;
+  std::string path(self, length);
+  path = path.substr(0, path.rfind('/')) + "/libplugin.so";
+
+  int result = 1;
+  for (int i = 0; i < 2; ++i) {
+    auto plugin = dlopen(path.c_str(), RTLD_NOW);
+    if (!plugin) return 1;
+    auto entry = reinterpret_cast<int (*)()>(dlsym(plugin, "plugin_entry"));
+    result = entry ? entry() : 1;
+    dlclose(plugin);
+    if (i == 0) raise(SIGTRAP);
+  }
+  return result;
+}
@@ -0,0 +1,16 @@
+#include <signal.h>
+
+volatile sig_atomic_t usr1_count = 0;
+volatile sig_atomic_t usr2_count = 0;
+
+// Raises SIGUSR1 three times and SIGUSR2 once, and exits with how many of
+// each its handlers saw: the SIGUSR1s in the units, the SIGUSR2 in the tens
+int main() {
+  signal(SIGUSR1, [](int) { usr1_count = usr1_count + 1; });
+  signal(SIGUSR2, [](int) { usr2_count = usr2_count + 1; });
+  raise(SIGTRAP);
+
+  for (int i = 0; i < 3; ++i) raise(SIGUSR1);
+  raise(SIGUSR2);
+  return usr1_count + 10 * usr2_count;
+}
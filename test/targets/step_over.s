@@ -0,0 +1,83 @@
+.global main
+
+.section .data
+
+value: .quad 40
+format: .asciz "%lld"
+
+# addresses for the debugger to put breakpoints on
+sites:
+  .quad load_site
+  .quad call_site
+  .quad jcc_site
+  .quad jmp_site
+  .quad ret_site
+sites_end:
+
+.section .text
+
+  # call kill(pid, 5)
+  .macro trap
+    movq $62, %rax
+    movq %r12, %rdi
+    movq $5, %rsi
+    syscall
+  .endm
+
+  add_two:
+    addq $2, %rbx
+  ret_site:
+    ret
+
+  main:
+    push %rbp
+    movq %rsp, %rbp
+    push %rbx
+    push %r12
+    push %r13
+    subq $8, %rsp
+
+    # save pid to %r12
+    movq $39, %rax
+    syscall
+    movq %rax, %r12
+
+    # write(1, sites, sites_end - sites)
+    movq $1, %rax
+    movq $1, %rdi
+    leaq sites(%rip), %rsi
+    movq $(sites_end - sites), %rdx
+    syscall
+    trap
+
+    xorq %rbx, %rbx
+    movq $3, %r13
+  loop:
+  load_site:
+    movq value(%rip), %rax
+    addq %rax, %rbx
+  call_site:
+    call add_two
+    decq %r13
+  jcc_site:
+    jnz loop
+  jmp_site:
+    jmp done
+    ud2
+
+  done:
+    # print the value of %rbx
+    leaq format(%rip), %rdi
+    movq %rbx, %rsi
+    movq $0, %rax
+    call printf@plt
+    movq $0, %rdi
+    call fflush@plt
+
+    addq $8, %rsp
+    pop %r13
+    pop %r12
+    pop %rbx
+    popq %rbp
+    movq $0, %rax
+    ret
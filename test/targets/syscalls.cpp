@@ -0,0 +1,8 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+int main() {
+  for (int i = 0; i < 3; ++i) getppid();
+  write(STDOUT_FILENO, "traced", 6);
+  close(open("/nonexistent", O_RDONLY));
+}
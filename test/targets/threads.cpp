@@ -0,0 +1,22 @@
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+__attribute__((noinline)) void marker() {
+  asm volatile("" ::: "memory");
+}
+
+void* run(void*) {
+  marker();
+  return nullptr;
+}
+
+int main() {
+  auto address = &marker;
+  write(STDOUT_FILENO, &address, sizeof(void*));
+  raise(SIGTRAP);
+
+  pthread_t threads[4];
+  for (auto& thread : threads) pthread_create(&thread, nullptr, run, nullptr);
+  for (auto& thread : threads) pthread_join(thread, nullptr);
+}
@@ -0,0 +1,78 @@
+.global main
+
+.section .data
+
+counter: .quad 0
+format: .asciz "%lld"
+
+# addresses for the debugger to put tracepoints on
+sites:
+  .quad traced
+  .quad traced_add
+  .quad too_short
+sites_end:
+
+.section .text
+
+  # call kill(pid, 5)
+  .macro trap
+    movq $62, %rax
+    movq %r12, %rdi
+    movq $5, %rsi
+    syscall
+  .endm
+
+  # counter += rdi
+  traced:
+    movq counter(%rip), %rax
+  traced_add:
+    addq %rdi, %rax
+    movq %rax, counter(%rip)
+    ret
+
+  # too little code before the ret for a jump
+  too_short:
+    ret
+
+  main:
+    push %rbp
+    movq %rsp, %rbp
+    push %rbx
+    push %r12
+
+    # save pid to %r12
+    movq $39, %rax
+    syscall
+    movq %rax, %r12
+
+    # write(1, sites, sites_end - sites)
+    movq $1, %rax
+    movq $1, %rdi
+    leaq sites(%rip), %rsi
+    movq $(sites_end - sites), %rdx
+    syscall
+    trap
+
+    # traced(1) ... traced(100)
+    movq $1, %rbx
+  loop:
+    movq %rbx, %rdi
+    call traced
+    call too_short
+    incq %rbx
+    cmpq $100, %rbx
+    jbe loop
+
+    # print the counter
+    leaq format(%rip), %rdi
+    movq counter(%rip), %rsi
+    movq $0, %rax
+    call printf@plt
+    movq $0, %rdi
+    call fflush@plt
+
+    pop %r12
+    pop %rbx
+    popq %rbp
+    movq $0, %rax
+    ret
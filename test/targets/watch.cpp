@@ -0,0 +1,15 @@
+#include <cstdint>
+#include <signal.h>
+#include <unistd.h>
+
+volatile std::uint64_t counter = 0;
+
+int main() {
+  auto address = &counter;
+  write(STDOUT_FILENO, &address, sizeof(void*));
+  raise(SIGTRAP);
+
+  for (int i = 0; i < 3; ++i) {
+    counter = counter + 1;
+  }
+}
@@ -0,0 +1,20 @@
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+// tells the test about every SIGCONT, which attaching shouldn't send
+void on_sigcont(int) {
+  write(STDOUT_FILENO, "C", 1);
+}
+
+void* work(void*) {
+  for (;;) usleep(1000);
+}
+
+int main() {
+  signal(SIGCONT, on_sigcont);
+  pthread_t threads[3];
+  for (auto& thread : threads) pthread_create(&thread, nullptr, work, nullptr);
+  write(STDOUT_FILENO, "R", 1);
+  for (;;) pause();
+}
@@ -2,11 +2,26 @@
 #include <catch2/catch_test_macros.hpp>
 #include <cmath>
 #include <cstdint>
+#include <dlfcn.h>
+#include <libxdb/dwarf.hpp>
+#include <libxdb/elf.hpp>
+#include <libxdb/event_loop.hpp>
+#include <libxdb/object_map.hpp>
 #include <libxdb/process.hpp>
 #include <libxdb/bits.hpp>
 #include <libxdb/pipe.hpp>
+#include <libxdb/session.hpp>
+#include <libxdb/step_until.hpp>
+#include <libxdb/symbol_index.hpp>
+#include <libxdb/syscalls.hpp>
+#include <libxdb/thread_pool.hpp>
 #include <csignal>
+#include <filesystem>
 #include <fstream>
+#include <set>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
 #include "libxdb/types.hpp"
 #include <fmt/format.h>
 #include <fmt/ranges.h>
@@ -64,6 +79,46 @@ TEST_CASE("process::resume already terminated", "[process]") {
   // proc has already terminated
   REQUIRE_THROWS_AS(proc->resume(), error);
 }
+TEST_CASE("process::attach to many processes", "[process]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  std::vector<std::unique_ptr<process>> targets;
+  std::vector<pid_t> pids;
+  for (int i = 0; i < 4; ++i) {
+    targets.push_back(process::launch("targets/workers", false, channel.get_write_fd()));
+    pids.push_back(targets.back()->pid());
+  }
+  channel.close_write();
+  for (std::size_t ready = 0; ready < pids.size();) {
+    ready += channel.read().size();
+  }
+
+  {
+    auto procs = process::attach(pids);
+    REQUIRE(procs.size() == pids.size());
+    for (std::size_t i = 0; i < pids.size(); ++i) {
+      REQUIRE(procs[i]->pid() == pids[i]);
+      REQUIRE(procs[i]->state() == process_state::stopped);
+      REQUIRE(procs[i]->threads().size() == 4);
+      for (auto& [tid, thread] : procs[i]->threads()) {
+        REQUIRE(get_process_status(tid) == 't');
+      }
+    }
+  }
+  for (auto pid : pids) REQUIRE(get_process_status(pid) != 't');
+
+  // the ones attached before a bad pid are let go again
+  REQUIRE_THROWS_AS(process::attach({ pids[0], -1 }), error);
+  REQUIRE(get_process_status(pids[0]) != 't');
+
+  // seizing sends no SIGSTOP, so detaching needs no SIGCONT
+  targets.clear();
+  std::string output;
+  for (auto data = channel.read(); !data.empty(); data = channel.read()) {
+    output += to_string_view(data);
+  }
+  REQUIRE(output.find('C') == std::string::npos);
+}
 TEST_CASE("registers: writing issue1", "[registers]") {
   auto target =  process::launch("targets/run_endlessly", false);
   auto proc = process::attach(target->pid());
@@ -245,4 +300,1458 @@ TEST_CASE("Can create breakpoint site", "[breakpoint]") {
   auto proc = process::launch("targets/run_endlessly");
   auto& site = proc->create_breakpoint_site(virt_addr{ 42 });
   REQUIRE(site.address().addr() == 42);
-}
\ No newline at end of file
+}
+TEST_CASE("Can read memory", "[memory]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/memory", true, channel.get_write_fd());
+  channel.close_write();
+
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto a_pointer = from_bytes<std::uint64_t>(channel.read().data());
+  auto data_vec = proc->read_memory(virt_addr{ a_pointer }, 8);
+  auto data = from_bytes<std::uint64_t>(data_vec.data());
+  REQUIRE(data == 0xcafecafe);
+  REQUIRE(proc->read_memory_as<std::uint64_t>(virt_addr{ a_pointer }) == 0xcafecafe);
+}
+
+TEST_CASE("Can write memory", "[memory]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/memory", true, channel.get_write_fd());
+  channel.close_write();
+
+  proc->resume();
+  proc->wait_on_signal();
+  channel.read();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto b_pointer = from_bytes<std::uint64_t>(channel.read().data());
+  std::string str = "Hello, xdb!";
+  proc->write_memory(virt_addr{ b_pointer }, reinterpret_cast<const std::byte*>(str.data()), str.size());
+
+  proc->resume();
+  proc->wait_on_signal();
+  REQUIRE(to_string_view(channel.read()) == str);
+}
+
+TEST_CASE("Memory access crosses pages and read-only mappings", "[memory]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/memory", true, channel.get_write_fd());
+  channel.close_write();
+
+  for (int i = 0; i < 4; ++i) {
+    proc->resume();
+    proc->wait_on_signal();
+  }
+  auto output = channel.read();
+  auto pages = virt_addr{ from_bytes<std::uint64_t>(output.data() + output.size() - 8) };
+
+  auto data = proc->read_memory(pages + 0xff0, 0x20);
+  REQUIRE(data[0x0f] == std::byte{1});
+  REQUIRE(data[0x10] == std::byte{2});
+
+  // the second page is read-only for the inferior, but not for us
+  std::vector<std::byte> patch(0x20, std::byte{7});
+  proc->write_memory(pages + 0xff0, patch);
+  REQUIRE(proc->read_memory(pages + 0xff0, 0x20) == patch);
+
+  proc->resume();
+  proc->wait_on_signal();
+  REQUIRE(to_string_view(channel.read()) == "7");
+}
+
+TEST_CASE("Memory reads are cached within a stop", "[memory]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/memory", true, channel.get_write_fd());
+  channel.close_write();
+
+  proc->resume();
+  proc->wait_on_signal();
+  auto a_pointer = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  auto& cache = proc->get_memory_cache();
+  cache.reset_stats();
+  auto epoch = proc->stop_epoch();
+  REQUIRE(proc->read_memory_as<std::uint64_t>(a_pointer) == 0xcafecafe);
+  REQUIRE(proc->read_memory_as<std::uint64_t>(a_pointer) == 0xcafecafe);
+  REQUIRE(cache.misses() == 1);
+  REQUIRE(cache.hits() == 1);
+
+  // our own writes must be visible straight away
+  proc->write_memory(a_pointer, as_byte64(std::uint64_t{42}).data(), 8);
+  REQUIRE(proc->read_memory_as<std::uint64_t>(a_pointer) == 42);
+
+  // a new stop starts from an empty cache
+  proc->resume();
+  proc->wait_on_signal();
+  REQUIRE(proc->stop_epoch() == epoch + 1);
+  REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("Register classes are fetched lazily", "[register]") {
+  auto proc = xdb::process::launch("targets/reg_read");
+  auto& regs = proc->get_registers();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto before = regs.syscall_count();
+  REQUIRE(regs.read_by_id<std::uint64_t>(register_id::r13) == 0xcafecafe);
+  regs.read_by_id<std::uint32_t>(register_id::r13d);
+  REQUIRE(regs.syscall_count() == before + 1);
+
+  regs.read_by_id<std::uint16_t>(register_id::fcw);
+  REQUIRE(regs.syscall_count() == before + 2);
+
+  // a new stop invalidates what was fetched
+  proc->resume();
+  proc->wait_on_signal();
+  REQUIRE(regs.read_by_id<std::uint8_t>(register_id::r13b) == 42);
+  REQUIRE(regs.syscall_count() == before + 3);
+}
+
+TEST_CASE("Register writes are flushed once on resume", "[register]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = xdb::process::launch("targets/reg_write", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto& regs = proc->get_registers();
+  regs.write_by_id(register_id::rsi, std::uint64_t{0x0a0b0c0d});
+  regs.write_by_id(register_id::rdi, regs.read_by_id<std::uint64_t>(register_id::rdi));
+  regs.write_by_id(register_id::si, std::uint16_t{0x0304});
+  // reads see the pending writes
+  REQUIRE(regs.read_by_id<std::uint64_t>(register_id::rsi) == 0x0a0b0304);
+
+  auto before = regs.syscall_count();
+  proc->resume();
+  proc->wait_on_signal();
+  REQUIRE(regs.syscall_count() == before + 1);
+  REQUIRE(to_string_view(channel.read()) == "0x0a0b0304");
+}
+
+TEST_CASE("Register info lookups", "[register]") {
+  for (auto& info : g_register_infos) {
+    REQUIRE(&register_info_by_id(info.id) == &info);
+    REQUIRE(&register_info_by_name(info.name) == &info);
+    if (info.dwarf_id >= 0) {
+      REQUIRE(&register_info_by_dwarf(info.dwarf_id) == &info);
+    }
+  }
+  REQUIRE_THROWS_AS(register_info_by_name("rip2"), error);
+  REQUIRE_THROWS_AS(register_info_by_name(""), error);
+  REQUIRE_THROWS_AS(register_info_by_dwarf(-1), error);
+  REQUIRE_THROWS_AS(register_info_by_dwarf(60), error);
+  REQUIRE_THROWS_AS(register_info_by_dwarf(1000), error);
+  static_assert(std::is_same_v<register_value_t<register_id::rip>, std::uint64_t>);
+  static_assert(std::is_same_v<register_value_t<register_id::ah>, std::uint8_t>);
+  static_assert(std::is_same_v<register_value_t<register_id::st0>, long double>);
+  static_assert(std::is_same_v<register_value_t<register_id::xmm0>, byte128>);
+}
+
+TEST_CASE("Typed register reads", "[register]") {
+  auto proc = xdb::process::launch("targets/reg_read");
+  auto& regs = proc->get_registers();
+  proc->resume();
+  proc->wait_on_signal();
+
+  REQUIRE(regs.read<register_id::r13>() == 0xcafecafe);
+  REQUIRE(regs.read<register_id::r13d>() == 0xcafecafe);
+  REQUIRE(regs.read<register_id::rip>() == proc->get_pc().addr());
+  REQUIRE(regs.read<register_id::rip>() == regs.read_by_id<std::uint64_t>(register_id::rip));
+}
+
+TEST_CASE("Breakpoint site ids increase", "[breakpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto& s1 = proc->create_breakpoint_site(virt_addr{ 42 });
+  auto& s2 = proc->create_breakpoint_site(virt_addr{ 43 });
+  REQUIRE(s2.id() == s1.id() + 1);
+  REQUIRE_THROWS_AS(proc->create_breakpoint_site(virt_addr{ 42 }), error);
+}
+
+TEST_CASE("Can find breakpoint site", "[breakpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto& sites = proc->breakpoint_sites();
+  for (std::uint64_t addr : { 46, 42, 45, 44, 43 }) {
+    proc->create_breakpoint_site(virt_addr{ addr });
+  }
+
+  REQUIRE(sites.contains(virt_addr{ 44 }));
+  REQUIRE(!sites.contains(virt_addr{ 47 }));
+  auto& s44 = sites.get_by_address(virt_addr{ 44 });
+  REQUIRE(sites.contains(s44.id()));
+  REQUIRE(&sites.get_by_id(s44.id()) == &s44);
+  REQUIRE_THROWS_AS(sites.get_by_address(virt_addr{ 47 }), error);
+  REQUIRE_THROWS_AS(sites.get_by_id(s44.id() + 100), error);
+
+  auto in_range = sites.get_in_range(virt_addr{ 43 }, virt_addr{ 46 });
+  REQUIRE(in_range.size() == 3);
+  REQUIRE(in_range[0]->address().addr() == 43);
+  REQUIRE(in_range[2]->address().addr() == 45);
+}
+
+TEST_CASE("Can remove breakpoint sites", "[breakpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto& sites = proc->breakpoint_sites();
+  auto id42 = proc->create_breakpoint_site(virt_addr{ 42 }).id();
+  proc->create_breakpoint_site(virt_addr{ 43 });
+  proc->create_breakpoint_site(virt_addr{ 44 });
+
+  sites.remove_by_id(id42);
+  sites.remove_by_address(virt_addr{ 44 });
+  REQUIRE(sites.size() == 1);
+  REQUIRE(!sites.contains(id42));
+  REQUIRE(sites.get_by_address(virt_addr{ 43 }).address().addr() == 43);
+  REQUIRE(sites.get_in_range(virt_addr{ 0 }, virt_addr{ 100 }).size() == 1);
+
+  std::size_t count = 0;
+  sites.for_each([&](auto&) { ++count; });
+  REQUIRE(count == 1);
+}
+
+TEST_CASE("Breakpoint sites patch and restore memory", "[breakpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto pc = proc->get_pc();
+  auto original = proc->read_memory(pc, 0x2000);
+
+  // a few sites on the first page, and one on the next
+  std::vector<breakpoint_site*> sites;
+  for (std::uint64_t offset : { 0, 1, 7, 0x800, 0x1004 }) {
+    sites.push_back(&proc->create_breakpoint_site(pc + offset));
+  }
+  auto& single = *sites.back();
+  sites.pop_back();
+
+  proc->enable_breakpoint_sites(sites);
+  single.enable();
+  for (auto site : sites) REQUIRE(site->is_enabled());
+  REQUIRE(single.is_enabled());
+
+  auto patched = proc->read_memory(pc, 0x2000);
+  for (std::uint64_t offset : { 0, 1, 7, 0x800, 0x1004 }) {
+    REQUIRE(patched[offset] == std::byte{ 0xcc });
+  }
+  REQUIRE(patched[2] == original[2]);
+  REQUIRE(proc->read_memory_without_traps(pc, 0x2000) == original);
+
+  proc->disable_all_breakpoint_sites();
+  REQUIRE(!single.is_enabled());
+  REQUIRE(proc->read_memory(pc, 0x2000) == original);
+}
+
+namespace {
+  // run targets/step_over to completion with a breakpoint on each of its
+  // interesting instructions, returning the hit count per site and the output
+  // hardware runs only get the first four sites, one per debug register
+  std::pair<std::vector<int>, std::string> run_step_over(step_over_strategy strategy, bool hardware = false) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/step_over", true, channel.get_write_fd());
+    channel.close_write();
+    proc->set_step_over_strategy(strategy);
+    proc->resume();
+    proc->wait_on_signal();
+
+    auto sites_data = channel.read();
+    std::vector<virt_addr> sites;
+    for (std::size_t i = 0; i < sites_data.size() && (!hardware || sites.size() < 4); i += 8) {
+      sites.push_back(virt_addr{ from_bytes<std::uint64_t>(sites_data.data() + i) });
+      proc->create_breakpoint_site(sites.back(), hardware).enable();
+    }
+
+    std::vector<int> hits(sites.size());
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    while (reason.reason == process_state::stopped) {
+      auto it = std::find(sites.begin(), sites.end(), proc->get_pc());
+      REQUIRE(it != sites.end());
+      REQUIRE(reason.trap_reason == (hardware ? trap_type::hardware_break : trap_type::software_break));
+      ++hits[it - sites.begin()];
+      proc->resume();
+      reason = proc->wait_on_signal();
+    }
+    REQUIRE(reason.reason == process_state::exited);
+    auto output = channel.read();
+    return { hits, std::string(to_string_view(output)) };
+  }
+}
+
+TEST_CASE("Can step over breakpoints", "[breakpoint]") {
+  // load, call, jcc, jmp, ret
+  std::vector<int> expected_hits = { 3, 3, 3, 1, 3 };
+  for (auto strategy : { step_over_strategy::in_place, step_over_strategy::displaced }) {
+    auto [hits, output] = run_step_over(strategy);
+    REQUIRE(hits == expected_hits);
+    REQUIRE(output == "126");
+  }
+}
+
+TEST_CASE("Hardware breakpoints need no step over", "[breakpoint]") {
+  auto [hits, output] = run_step_over(step_over_strategy::displaced, true);
+  REQUIRE(hits == std::vector<int>{ 3, 3, 3, 1 });
+  REQUIRE(output == "126");
+}
+
+TEST_CASE("Batched steps stop on the count, a predicate or a breakpoint", "[step]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/step_over", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto sites_data = channel.read();
+  auto site = [&](int i) { return virt_addr{ from_bytes<std::uint64_t>(sites_data.data() + i * 8) }; };
+  auto load_site = site(0), call_site = site(1), jmp_site = site(3), ret_site = site(4);
+
+  auto result = proc->step_instructions(2);
+  REQUIRE(result.steps == 2);
+  REQUIRE(result.reason.trap_reason == trap_type::single_step);
+  REQUIRE(proc->get_pc() == load_site);
+
+  // the load leaves rbx alone, the add doesn't
+  result = proc->step_instructions(100, register_changes(*proc, register_info_by_id(register_id::rbx)));
+  REQUIRE(result.steps == 2);
+  REQUIRE(proc->get_pc() == call_site);
+  REQUIRE(proc->get_registers().read_by_id<std::uint64_t>(register_id::rbx) == 40);
+
+  // the call pushes its return address
+  auto slot = virt_addr{ proc->get_registers().read_by_id<std::uint64_t>(register_id::rsp) - 8 };
+  result = proc->step_instructions(100, memory_changes(*proc, slot, 8));
+  REQUIRE(result.steps == 1);
+  REQUIRE(proc->read_memory_as<std::uint64_t>(slot) == (call_site + 5).addr());
+
+  result = proc->step_instructions(100, pc_outside(*proc, proc->get_pc(), ret_site + 1));
+  REQUIRE(result.steps == 2);
+  REQUIRE(proc->get_pc() == call_site + 5);
+
+  // the breakpoint on the load never stops, the one on the jmp does: two
+  // more instructions of this iteration, then two of seven
+  auto& conditional = proc->create_breakpoint_site(load_site);
+  conditional.set_condition(stop_condition::compile("r13 == 0"));
+  conditional.enable();
+  proc->create_breakpoint_site(jmp_site).enable();
+  result = proc->step_instructions(1000);
+  REQUIRE(result.steps == 16);
+  REQUIRE(result.reason.trap_reason == trap_type::software_break);
+  REQUIRE(proc->get_pc() == jmp_site);
+
+  REQUIRE(proc->step_instructions(1).steps == 1);
+  proc->resume();
+  REQUIRE(proc->wait_on_signal().reason == process_state::exited);
+  REQUIRE(to_string_view(channel.read()) == "126");
+}
+
+TEST_CASE("Stepping over calls and out of functions stops once", "[step]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/range_step", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto sites_data = channel.read();
+  auto site = [&](int i) { return virt_addr{ from_bytes<std::uint64_t>(sites_data.data() + i * 8) }; };
+  auto call_site = site(0), after_call = site(1), after_loop = site(2), after_second = site(3);
+  auto work_loop = site(4), recurse_call = site(5), recurse_return = site(6), after_recurse = site(7);
+  REQUIRE(proc->get_pc() == call_site);
+
+  auto epoch = proc->stop_epoch();
+  auto reason = proc->step_over_instruction();
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(proc->get_pc() == after_call);
+  REQUIRE(proc->stop_epoch() == epoch + 1);
+  REQUIRE(proc->breakpoint_sites().empty());
+
+  // the loop's backward branch stays inside the range
+  epoch = proc->stop_epoch();
+  proc->step_over_range(after_call, after_loop);
+  REQUIRE(proc->get_pc() == after_loop);
+  REQUIRE(proc->stop_epoch() == epoch + 1);
+
+  epoch = proc->stop_epoch();
+  proc->run_until(work_loop);
+  REQUIRE(proc->get_pc() == work_loop);
+  proc->step_out();
+  REQUIRE(proc->get_pc() == after_second);
+  REQUIRE(proc->stop_epoch() == epoch + 2);
+  REQUIRE(proc->breakpoint_sites().empty());
+
+  // a user breakpoint in the callee ends the step over
+  auto& user_site = proc->create_breakpoint_site(recurse_call);
+  user_site.enable();
+  reason = proc->step_over_range(after_second, after_recurse);
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(proc->get_pc() == recurse_call);
+  REQUIRE(proc->breakpoint_sites().size() == 1);
+
+  // out of the second of four frames: the two deeper ones return to the
+  // same address first
+  proc->resume();
+  proc->wait_on_signal();
+  user_site.disable();
+  auto frame = proc->get_registers().read_by_id<std::uint64_t>(register_id::rbp);
+  proc->step_out();
+  REQUIRE(proc->get_pc() == recurse_return);
+  REQUIRE(proc->get_registers().read_by_id<std::uint64_t>(register_id::rsp) == frame + 16);
+  proc->step_out();
+  REQUIRE(proc->get_pc() == after_recurse);
+  REQUIRE(proc->breakpoint_sites().size() == 1);
+
+  proc->resume();
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 0);
+}
+
+TEST_CASE("Hardware breakpoints leave memory untouched", "[breakpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto address = proc->get_pc();
+  auto before = proc->read_memory(address, 1);
+  auto& site = proc->create_breakpoint_site(address, true);
+  site.enable();
+  REQUIRE(site.is_hardware());
+  REQUIRE(proc->read_memory(address, 1) == before);
+}
+
+TEST_CASE("Watchpoints report writes", "[watchpoint]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/watch", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto address = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+  auto& point = proc->create_watchpoint(address, stoppoint_mode::write, 8);
+  point.enable();
+
+  for (std::uint64_t expected = 1; expected <= 3; ++expected) {
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    REQUIRE(reason.reason == process_state::stopped);
+    REQUIRE(reason.trap_reason == trap_type::hardware_break);
+    auto id = proc->get_current_hardware_stoppoint();
+    REQUIRE(id.index() == 1);
+    REQUIRE(std::get<1>(id) == point.id());
+    REQUIRE(point.previous_data() == expected - 1);
+    REQUIRE(point.data() == expected);
+  }
+
+  proc->resume();
+  REQUIRE(proc->wait_on_signal().reason == process_state::exited);
+}
+
+TEST_CASE("Hardware stoppoint slots run out", "[watchpoint]") {
+  auto proc = process::launch("targets/run_endlessly");
+  auto pc = virt_addr{ proc->get_pc().addr() & ~std::uint64_t{ 7 } };
+  REQUIRE_THROWS_AS(proc->create_watchpoint(pc + 1, stoppoint_mode::write, 8), error);
+  for (int i = 0; i < 4; ++i) {
+    proc->create_watchpoint(pc + i * 8, stoppoint_mode::read_write, 8).enable();
+  }
+  auto& site = proc->create_breakpoint_site(pc + 64, true);
+  REQUIRE_THROWS_AS(site.enable(), error);
+
+  proc->watchpoints().remove_by_address(pc);
+  site.enable();
+  REQUIRE(site.is_enabled());
+}
+
+TEST_CASE("Stop conditions compile and evaluate", "[breakpoint]") {
+  REQUIRE_THROWS_AS(stop_condition::compile("rax =="), error);
+  REQUIRE_THROWS_AS(stop_condition::compile("rax == 1 )"), error);
+  REQUIRE_THROWS_AS(stop_condition::compile("foo == 1"), error);
+  REQUIRE_THROWS_AS(stop_condition::compile("xmm0 == 1"), error);
+
+  auto proc = process::launch("targets/run_endlessly");
+  auto& regs = proc->get_registers();
+  regs.write_by_id(register_id::rax, std::uint64_t{ 42 });
+  regs.write_by_id(register_id::rbx, std::uint64_t{ 7 });
+  auto top_of_stack = proc->read_memory_as<std::uint64_t>(virt_addr{ regs.read_by_id<std::uint64_t>(register_id::rsp) });
+
+  auto eval = [&](std::string_view text) { return stop_condition::compile(text).evaluate(*proc); };
+  REQUIRE(eval("rax == 42"));
+  REQUIRE(eval("eax == 0x2a"));
+  REQUIRE_FALSE(eval("rax == 42 && rbx < 7"));
+  REQUIRE(eval("!(rax != 42) && (rbx <= 7)"));
+  REQUIRE(eval("rax - 40 == 2 || [0] == 0"));
+  REQUIRE(eval("(rax & 0xf) + (rbx ^ 1) == 16"));
+  REQUIRE(eval("-rbx == ~rbx + 1"));
+  REQUIRE(eval("1 < 2 == 1"));
+  REQUIRE(eval("[rsp] == " + std::to_string(top_of_stack)));
+  REQUIRE(eval("byte [rsp] == " + std::to_string(top_of_stack & 0xff)));
+  REQUIRE_THROWS_AS(eval("[0] == 0"), error);
+}
+
+TEST_CASE("Conditional breakpoints only stop when the condition holds", "[breakpoint]") {
+  for (bool hardware : { false, true }) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/step_over", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+
+    // the loop counter in r13 is 3, 2 and 1 at the load site
+    auto load_site = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    auto& site = proc->create_breakpoint_site(load_site, hardware);
+    site.set_condition(stop_condition::compile("r13 < 3"));
+    site.set_ignore_count(1);
+    site.enable();
+
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    REQUIRE(reason.reason == process_state::stopped);
+    REQUIRE(proc->get_pc() == load_site);
+    REQUIRE(proc->get_registers().read_by_id<std::uint64_t>(register_id::r13) == 1);
+    REQUIRE(site.hit_count() == 2);
+    REQUIRE(site.ignore_count() == 0);
+
+    proc->resume();
+    REQUIRE(proc->wait_on_signal().reason == process_state::exited);
+  }
+}
+
+TEST_CASE("Tracepoints record without stopping", "[tracepoint]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/tracepoint", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto sites_data = channel.read();
+  auto traced = virt_addr{ from_bytes<std::uint64_t>(sites_data.data()) };
+  auto traced_add = virt_addr{ from_bytes<std::uint64_t>(sites_data.data() + 8) };
+  auto too_short = virt_addr{ from_bytes<std::uint64_t>(sites_data.data() + 16) };
+
+  REQUIRE_THROWS_AS(proc->create_tracepoint(too_short, {}).enable(), error);
+  REQUIRE_THROWS_AS(proc->create_tracepoint(traced, { { register_id::xmm0, std::nullopt } }), error);
+
+  auto original = proc->read_memory(traced, 16);
+  auto& entry = proc->create_tracepoint(traced, { { register_id::rdi, std::nullopt },
+                                                  { register_id::rip, std::nullopt },
+                                                  { register_id::rbx, std::nullopt },
+                                                  { register_id::rsp, 0 },
+                                                  { register_id::eflags, std::nullopt } });
+  entry.enable();
+  // the rip-relative load plus the add and the store after it
+  auto& add = proc->create_tracepoint(traced_add, { { register_id::rax, std::nullopt } });
+  add.enable();
+  REQUIRE(entry.patch_size() == 7);
+  REQUIRE(add.patch_size() == 10);
+  REQUIRE(proc->read_memory(traced, 1)[0] == std::byte{ 0xe9 });
+  REQUIRE(proc->read_memory_without_traps(traced, 16) == original);
+  REQUIRE_THROWS_AS(proc->create_breakpoint_site(traced_add + 3).enable(), error);
+
+  proc->resume();
+  REQUIRE(proc->wait_on_signal().reason == process_state::exited);
+  REQUIRE(to_string_view(channel.read()) == "5050");
+
+  std::vector<trace_buffer::record> records;
+  auto n = proc->get_trace_buffer().drain([&](auto& record) { records.push_back(record); });
+  REQUIRE(n == 200);
+  REQUIRE(proc->get_trace_buffer().dropped() == 0);
+  std::uint64_t sum = 0;
+  for (std::uint64_t i = 1; i <= 100; ++i) {
+    auto& at_entry = records[2 * (i - 1)];
+    REQUIRE(at_entry.tracepoint_id == static_cast<std::uint64_t>(entry.id()));
+    REQUIRE(at_entry.values[0] == i);
+    REQUIRE(at_entry.values[1] == traced.addr());
+    REQUIRE(at_entry.values[2] == i);
+    REQUIRE(at_entry.values[3] == records[0].values[3]);
+    // bit 1 of eflags always reads as one
+    REQUIRE((at_entry.values[4] & 2) != 0);
+
+    auto& at_add = records[2 * (i - 1) + 1];
+    REQUIRE(at_add.tracepoint_id == static_cast<std::uint64_t>(add.id()));
+    REQUIRE(at_add.values[0] == sum);
+    sum += i;
+  }
+  REQUIRE(proc->get_trace_buffer().drain([](auto&) {}) == 0);
+}
+
+namespace {
+  void require_each_thread_hits(bool hardware) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/threads", true, channel.get_write_fd());
+    channel.close_write();
+    proc->resume();
+    proc->wait_on_signal();
+
+    auto marker = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+    proc->create_breakpoint_site(marker, hardware).enable();
+
+    std::set<pid_t> hit_by;
+    for (int i = 0; i < 4; ++i) {
+      proc->resume();
+      auto reason = proc->wait_on_signal();
+      REQUIRE(reason.reason == process_state::stopped);
+      REQUIRE(reason.trap_reason == (hardware ? trap_type::hardware_break : trap_type::software_break));
+      REQUIRE(proc->get_pc() == marker);
+      auto tid = proc->current_thread();
+      REQUIRE(tid != proc->pid());
+      hit_by.insert(tid);
+      for (auto& [other, thread] : proc->threads()) {
+        REQUIRE(thread.state == process_state::stopped);
+        REQUIRE(get_process_status(other) == 't');
+      }
+    }
+    REQUIRE(hit_by.size() == 4);
+
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    REQUIRE(reason.reason == process_state::exited);
+    REQUIRE(reason.info == 0);
+  }
+}
+
+TEST_CASE("Breakpoints stop every thread", "[thread]") {
+  require_each_thread_hits(false);
+}
+
+TEST_CASE("Hardware breakpoints reach new threads", "[thread]") {
+  require_each_thread_hits(true);
+}
+
+TEST_CASE("Non-stop mode only stops the thread that hit", "[thread]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/non_stop", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto addresses = channel.read();
+  auto marker = virt_addr{ from_bytes<std::uint64_t>(addresses.data()) };
+  auto counter = virt_addr{ from_bytes<std::uint64_t>(addresses.data() + 8) };
+  proc->set_non_stop(true);
+  proc->create_breakpoint_site(marker).enable();
+
+  proc->resume();
+  auto reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::stopped);
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(proc->get_pc() == marker);
+  auto hitter = proc->current_thread();
+  REQUIRE(proc->state() == process_state::stopped);
+  REQUIRE(get_process_status(hitter) == 't');
+
+  int n_running = 0;
+  for (auto& [tid, thread] : proc->threads()) {
+    if (tid == hitter) continue;
+    REQUIRE(thread.state == process_state::running);
+    REQUIRE(get_process_status(tid) != 't');
+    ++n_running;
+  }
+  REQUIRE(n_running == 2);
+
+  // the spinner keeps counting while we look
+  auto before = proc->read_memory_as<std::uint64_t>(counter);
+  usleep(20000);
+  REQUIRE(proc->read_memory_as<std::uint64_t>(counter) != before);
+
+  // stepping off the breakpoint leaves the others running too
+  reason = proc->step_instruction();
+  REQUIRE(reason.trap_reason == trap_type::single_step);
+  REQUIRE(proc->current_thread() == hitter);
+  REQUIRE(proc->get_pc() != marker);
+  for (auto& [tid, thread] : proc->threads()) {
+    if (tid != hitter) REQUIRE(thread.state == process_state::running);
+  }
+
+  proc->interrupt();
+  for (auto& [tid, thread] : proc->threads()) {
+    REQUIRE(thread.state == process_state::stopped);
+    REQUIRE(get_process_status(tid) == 't');
+  }
+
+  proc->resume();
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 0);
+}
+
+TEST_CASE("A thread steps over a breakpoint while another is current", "[thread]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/non_stop", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+
+  auto marker = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+  proc->set_non_stop(true);
+  proc->set_step_over_strategy(step_over_strategy::displaced);
+  proc->create_breakpoint_site(marker).enable();
+
+  proc->resume();
+  auto reason = proc->wait_on_signal();
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  auto hitter = proc->current_thread();
+
+  // the displaced copy is made, with a syscall, by the hitter and not by
+  // the current thread, which is still running
+  for (auto& [tid, thread] : proc->threads()) {
+    if (tid != hitter && tid != proc->pid()) proc->set_current_thread(tid);
+  }
+  REQUIRE(proc->current_thread() != hitter);
+  proc->resume(hitter);
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 0);
+}
+
+TEST_CASE("All-stop mode reports the stops of the other threads next", "[thread]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto target = process::launch("targets/workers", false, channel.get_write_fd());
+  channel.close_write();
+  REQUIRE(to_string_view(channel.read()) == "R");
+  auto proc = process::attach(target->pid());
+
+  // two signals the workers ignore, but that stop, land on two of them at once
+  proc->set_signal_policy(SIGWINCH, signal_policy::stop);
+  proc->set_signal_policy(SIGURG, signal_policy::stop);
+  std::vector<pid_t> workers;
+  for (auto& [tid, thread] : proc->threads()) {
+    if (tid != proc->pid()) workers.push_back(tid);
+  }
+  REQUIRE(workers.size() == 3);
+  syscall(SYS_tgkill, proc->pid(), workers[0], SIGWINCH);
+  syscall(SYS_tgkill, proc->pid(), workers[1], SIGURG);
+
+  std::map<pid_t, int> reported;
+  for (int i = 0; i < 2; ++i) {
+    proc->resume();
+    auto reason = proc->wait_on_signal(std::chrono::milliseconds(5000));
+    REQUIRE(reason.has_value());
+    REQUIRE(reason->reason == process_state::stopped);
+    reported[proc->current_thread()] = reason->info;
+    for (auto& [tid, thread] : proc->threads()) {
+      REQUIRE(thread.state == process_state::stopped);
+    }
+  }
+  REQUIRE(reported == std::map<pid_t, int>{ { workers[0], SIGWINCH }, { workers[1], SIGURG } });
+}
+
+TEST_CASE("An untraced child's exit is kept for its owner", "[thread]") {
+  auto untraced = process::launch("targets/end_immediately", false);
+  auto pid = untraced->pid();
+  // let it become a zombie that any waitpid(-1) could reap
+  for (;;) {
+    siginfo_t info{};
+    REQUIRE(waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0);
+    if (info.si_pid == pid) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  auto proc = process::launch("targets/end_immediately");
+  proc->resume();
+  REQUIRE(proc->wait_on_signal().reason == process_state::exited);
+
+  int status;
+  REQUIRE(process::wait_untraced(pid, &status) == pid);
+  REQUIRE(WIFEXITED(status));
+  REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("wait_on_signal times out", "[event_loop]") {
+  auto proc = process::launch("targets/run_endlessly");
+  proc->resume();
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE_FALSE(proc->wait_on_signal(std::chrono::milliseconds(50)).has_value());
+  REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+  kill(proc->pid(), SIGUSR1);
+  auto reason = proc->wait_on_signal(std::chrono::milliseconds(5000));
+  REQUIRE(reason.has_value());
+  REQUIRE(reason->reason == process_state::stopped);
+  REQUIRE(reason->info == SIGUSR1);
+}
+
+TEST_CASE("Event loop drives many inferiors and file descriptors", "[event_loop]") {
+  event_loop loop;
+  constexpr int n_processes = 24;
+  std::vector<std::unique_ptr<process>> procs;
+  std::map<pid_t, int> exit_statuses;
+  for (int i = 0; i < n_processes; ++i) {
+    procs.push_back(process::launch("targets/end_immediately"));
+    loop.add_process(*procs.back(), [&](process& proc, const stop_reason& reason) {
+      REQUIRE(reason.reason == process_state::exited);
+      exit_statuses[proc.pid()] = reason.info;
+    });
+  }
+
+  bool close_on_exec = true;
+  xdb::pipe channel(close_on_exec);
+  std::string received;
+  loop.add_fd(channel.get_read_fd(), [&](int) { received += to_string_view(channel.read()); });
+
+  REQUIRE_FALSE(loop.run_once(std::chrono::milliseconds(10)));
+  for (auto& proc : procs) proc->resume();
+  std::string message = "ping";
+  channel.write(reinterpret_cast<std::byte*>(message.data()), message.size());
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while ((exit_statuses.size() < n_processes || received.empty()) && std::chrono::steady_clock::now() < deadline) {
+    loop.run_once(std::chrono::milliseconds(100));
+  }
+  REQUIRE(exit_statuses.size() == n_processes);
+  for (auto& [pid, status] : exit_statuses) REQUIRE(status == 0);
+  REQUIRE(received == "ping");
+}
+
+TEST_CASE("Signal policies are applied without stopping", "[signal]") {
+  auto run = [](signal_policy usr1, std::vector<int>* observed = nullptr) {
+    auto proc = process::launch("targets/signals");
+    proc->set_signal_policy(SIGUSR1, usr1);
+    if (observed) {
+      proc->set_signal_observer([observed](pid_t, int signo) { observed->push_back(signo); });
+    }
+    proc->resume();
+    proc->wait_on_signal();
+
+    // SIGUSR2 still stops, and is delivered when resumed
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    REQUIRE(reason.reason == process_state::stopped);
+    REQUIRE(reason.info == SIGUSR2);
+    proc->resume();
+    reason = proc->wait_on_signal();
+    REQUIRE(reason.reason == process_state::exited);
+    return static_cast<int>(reason.info);
+  };
+
+  REQUIRE(run(signal_policy::pass) == 13);
+  REQUIRE(run(signal_policy::ignore) == 10);
+  std::vector<int> observed;
+  REQUIRE(run(signal_policy::print, &observed) == 13);
+  REQUIRE(observed == std::vector<int>{ SIGUSR1, SIGUSR1, SIGUSR1 });
+
+  auto proc = process::launch("targets/signals");
+  REQUIRE(proc->get_signal_policy(SIGUSR1) == signal_policy::stop);
+  REQUIRE(proc->get_signal_policy(SIGPROF) == signal_policy::pass);
+  REQUIRE_THROWS_AS(proc->set_signal_policy(SIGTRAP, signal_policy::pass), error);
+  REQUIRE_THROWS_AS(proc->set_signal_policy(NSIG, signal_policy::stop), error);
+}
+
+TEST_CASE("A signal that comes during a step over is delivered after it", "[signal]") {
+  // in place, and displaced, whose first step over injects the mmap of its
+  // scratch space
+  for (auto strategy : { step_over_strategy::in_place, step_over_strategy::displaced }) {
+    auto proc = process::launch("targets/signals");
+    proc->set_step_over_strategy(strategy);
+    proc->set_signal_policy(SIGUSR1, signal_policy::pass);
+    proc->set_signal_policy(SIGUSR2, signal_policy::pass);
+    proc->resume();
+    proc->wait_on_signal();
+
+    // right after the raise, which every later raise passes through
+    auto& site = proc->create_breakpoint_site(proc->get_pc());
+    site.enable();
+    // queued while the thread is stopped, so it comes before the step
+    kill(proc->pid(), SIGUSR1);
+    int hits = 0;
+    for (;;) {
+      proc->resume();
+      auto reason = proc->wait_on_signal();
+      if (reason.reason == process_state::exited) {
+        REQUIRE(reason.info == 14);
+        break;
+      }
+      REQUIRE(reason.trap_reason == trap_type::software_break);
+      ++hits;
+    }
+    REQUIRE(hits == 4);
+    REQUIRE(site.hit_count() == 4);
+  }
+}
+
+namespace {
+  // the first syscall instruction of a libc function, in an inferior that
+  // maps the same libc as we do
+  virt_addr first_syscall_in(process& proc, const char* function) {
+    Dl_info info;
+    auto local = dlsym(RTLD_DEFAULT, function);
+    REQUIRE(local != nullptr);
+    REQUIRE(dladdr(local, &info) != 0);
+    auto libc = std::filesystem::path(info.dli_fname).filename().string();
+    std::ifstream maps("/proc/" + std::to_string(proc.pid()) + "/maps");
+    std::uint64_t base = 0;
+    for (std::string line; base == 0 && std::getline(maps, line);) {
+      if (line.size() >= libc.size() && line.compare(line.size() - libc.size(), libc.size(), libc) == 0) {
+        base = std::stoull(line.substr(0, line.find('-')), nullptr, 16);
+      }
+    }
+    REQUIRE(base != 0);
+    auto address = virt_addr{ base + (reinterpret_cast<std::uint64_t>(local) -
+                                      reinterpret_cast<std::uint64_t>(info.dli_fbase)) };
+    auto code = proc.read_memory(address, 64);
+    for (std::size_t i = 0; i + 1 < code.size(); ++i) {
+      if (code[i] == std::byte{ 0x0f } && code[i + 1] == std::byte{ 0x05 }) return address + i;
+    }
+    FAIL("No syscall instruction in " << function);
+    return address;
+  }
+}
+
+TEST_CASE("Stepping over a fork or exec keeps its event", "[step]") {
+  for (auto strategy : { step_over_strategy::in_place, step_over_strategy::displaced }) {
+    bool close_on_exec = false;
+    xdb::pipe channel(close_on_exec);
+    auto proc = process::launch("targets/forker", true, channel.get_write_fd());
+    channel.close_write();
+    proc->set_step_over_strategy(strategy);
+    proc->resume();
+    proc->wait_on_signal();
+    channel.read();
+
+    auto fork = first_syscall_in(*proc, "_Fork");
+    auto exec = first_syscall_in(*proc, "execve");
+    proc->create_breakpoint_site(fork).enable();
+    proc->create_breakpoint_site(exec).enable();
+
+    // each step over the syscall ends in the event, and the children are
+    // let go and the new image set up as usual
+    int fork_hits = 0;
+    int exec_hits = 0;
+    for (;;) {
+      proc->resume();
+      auto reason = proc->wait_on_signal(std::chrono::milliseconds(5000));
+      REQUIRE(reason.has_value());
+      if (reason->reason == process_state::exited) {
+        REQUIRE(reason->info == 0);
+        break;
+      }
+      if (reason->info == SIGCHLD) continue;
+      REQUIRE(reason->trap_reason == trap_type::software_break);
+      if (proc->get_pc() == fork) ++fork_hits;
+      if (proc->get_pc() == exec) ++exec_hits;
+    }
+    REQUIRE(fork_hits == 3);
+    REQUIRE(exec_hits == 1);
+
+    std::multiset<int> child_codes;
+    for (auto data = channel.read(); !data.empty(); data = channel.read()) {
+      for (auto code : data) child_codes.insert(static_cast<int>(code));
+    }
+    REQUIRE(child_codes == std::multiset<int>{ 1, 2, 3 });
+  }
+}
+
+TEST_CASE("Syscall tracing only logs the selected syscalls", "[syscall]") {
+  REQUIRE(syscall_name_to_id("getppid") == SYS_getppid);
+  REQUIRE(syscall_id_to_name(SYS_write) == "write");
+  REQUIRE_THROWS_AS(syscall_name_to_id("no_such_syscall"), error);
+
+  auto log = std::filesystem::temp_directory_path() / ("xdb_syscalls_" + std::to_string(getpid()));
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/syscalls", true, channel.get_write_fd(),
+                              syscall_trace{ { SYS_getppid, SYS_write }, log });
+  channel.close_write();
+  proc->resume();
+  auto reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 0);
+  REQUIRE(to_string_view(channel.read()) == "traced");
+
+  std::ifstream in(log);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(in, line);) lines.push_back(line);
+  std::filesystem::remove(log);
+
+  auto prefix = std::to_string(proc->pid()) + " ";
+  REQUIRE(lines.size() == 4);
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(lines[i].rfind(prefix + "getppid(", 0) == 0);
+    REQUIRE(lines[i].substr(lines[i].rfind(" = ") + 3) == std::to_string(getpid()));
+  }
+  REQUIRE(lines[3].rfind(prefix + "write(0x1, 0x", 0) == 0);
+  REQUIRE(lines[3].find(", 0x6, ") != std::string::npos);
+  REQUIRE(lines[3].substr(lines[3].rfind(" = ") + 3) == "6");
+}
+
+TEST_CASE("Sessions follow forks and execs", "[session]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  session inferiors;
+  auto& parent = inferiors.add(process::launch("targets/forker", true, channel.get_write_fd()));
+  channel.close_write();
+  parent.resume();
+  parent.wait_on_signal();
+
+  auto marker = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+  auto& site = parent.create_breakpoint_site(marker);
+  site.enable();
+
+  auto parent_pid = parent.pid();
+  std::map<pid_t, int> hits;
+  std::map<pid_t, int> exit_codes;
+  virt_addr parent_hit_at;
+  parent.resume();
+  for (;;) {
+    auto [proc, reason] = inferiors.wait_on_signal();
+    if (reason.reason == process_state::exited) {
+      exit_codes[proc.pid()] = reason.info;
+      if (proc.pid() == parent_pid) break;
+      inferiors.remove(proc);
+      continue;
+    }
+    REQUIRE(reason.reason == process_state::stopped);
+    // the parent hears about its children exiting
+    if (reason.info == SIGCHLD) {
+      proc.resume();
+      continue;
+    }
+    REQUIRE(reason.trap_reason == trap_type::software_break);
+    REQUIRE(proc.breakpoint_sites().get_by_address(proc.get_pc()).id() == site.id());
+    ++hits[proc.pid()];
+    if (proc.pid() == parent_pid) parent_hit_at = proc.get_pc();
+    proc.resume();
+  }
+
+  // the children had copies of the breakpoint, and the parent got it back
+  // after its exec, wherever the new image was loaded
+  REQUIRE(hits.size() == 4);
+  for (auto& [pid, count] : hits) REQUIRE(count == 1);
+  REQUIRE(parent_hit_at == site.address());
+  REQUIRE(exit_codes.size() == 4);
+  std::set<int> child_codes;
+  for (auto& [pid, code] : exit_codes) {
+    if (pid != parent_pid) child_codes.insert(code);
+  }
+  REQUIRE(child_codes == std::set<int>{ 1, 2, 3 });
+  REQUIRE(exit_codes[parent_pid] == 0);
+  REQUIRE(inferiors.processes().size() == 1);
+}
+
+TEST_CASE("Forked children are detached without a session", "[session]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/forker", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto marker = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+  proc->create_breakpoint_site(marker).enable();
+
+  // the children never stop at the int3s they inherited, and the parent
+  // only stops for SIGCHLD before its exec
+  auto next_stop = [&] {
+    proc->resume();
+    auto reason = proc->wait_on_signal();
+    while (reason.reason == process_state::stopped && reason.info == SIGCHLD) {
+      proc->resume();
+      reason = proc->wait_on_signal();
+    }
+    return reason;
+  };
+  auto reason = next_stop();
+  REQUIRE(reason.reason == process_state::stopped);
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(proc->breakpoint_sites().enabled_stoppoint_at_address(proc->get_pc()));
+  reason = next_stop();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 0);
+
+  // and they ran to their own exits, not killed along the way
+  std::multiset<int> child_codes;
+  for (auto data = channel.read(); !data.empty(); data = channel.read()) {
+    for (auto code : data) child_codes.insert(static_cast<int>(code));
+  }
+  REQUIRE(child_codes == std::multiset<int>{ 1, 2, 3 });
+}
+
+TEST_CASE("The executable's symbols are found by address and by name", "[elf]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/forker", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto marker = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  auto& elf = proc->get_elf();
+  auto text = elf.get_section(".text");
+  REQUIRE(text != nullptr);
+  REQUIRE(elf.section_name(*text) == ".text");
+  REQUIRE(elf.section_contents(".text").size() == text->sh_size);
+  REQUIRE(elf.get_section(".no_such_section") == nullptr);
+
+  auto symbol = elf.symbol_by_name("_Z6markerv");
+  REQUIRE(symbol != nullptr);
+  REQUIRE(ELF64_ST_TYPE(symbol->st_info) == STT_FUNC);
+  REQUIRE(symbol->st_value + elf.load_bias() == marker.addr());
+  REQUIRE(elf.symbol_containing_address(marker) == symbol);
+  REQUIRE(elf.symbol_containing_address(marker + symbol->st_size - 1) == symbol);
+  auto main = elf.symbol_by_name("main");
+  REQUIRE(main != nullptr);
+  auto in_main = elf.symbol_containing_address(virt_addr{ main->st_value + elf.load_bias() + 1 });
+  REQUIRE(in_main != nullptr);
+  REQUIRE(elf.symbol_name(*in_main) == "main");
+  REQUIRE(elf.symbol_containing_address(virt_addr{ 0 }) == nullptr);
+  REQUIRE(elf.symbol_by_name("no_such_symbol") == nullptr);
+}
+
+TEST_CASE("Exported symbols are found through .gnu.hash", "[elf]") {
+  // libc as this process has it loaded
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  std::string path;
+  std::uint64_t base = 0;
+  while (std::getline(maps, line)) {
+    auto name = line.find('/');
+    if (name != std::string::npos && line.find("/libc.so") != std::string::npos) {
+      path = line.substr(name);
+      base = std::stoull(line.substr(0, line.find('-')), nullptr, 16);
+      break;
+    }
+  }
+  REQUIRE_FALSE(path.empty());
+
+  elf libc(path);
+  REQUIRE(libc.get_section(".gnu.hash") != nullptr);
+  libc.notify_loaded(virt_addr{ base });
+  for (auto name : { "write", "printf", "malloc" }) {
+    auto symbol = libc.symbol_by_name(name);
+    REQUIRE(symbol != nullptr);
+    REQUIRE(libc.symbol_name(*symbol) == name);
+    auto address = reinterpret_cast<std::uint64_t>(dlsym(RTLD_DEFAULT, name));
+    REQUIRE(symbol->st_value + libc.load_bias() == address);
+    REQUIRE(libc.symbol_containing_address(virt_addr{ address }) != nullptr);
+  }
+  REQUIRE(libc.symbol_by_name("no_such_symbol") == nullptr);
+  REQUIRE_THROWS_AS(elf("/proc/self/status"), error);
+}
+
+namespace {
+  // twice's entry address is its prologue, on line 12 where the function
+  // starts; every address info gives for its body on line 13 must map back
+  template <class Lines>
+  void require_twice_lines(const Lines& lines, const dwarf& info, virt_addr twice) {
+    REQUIRE(lines.line_entry_at_address(twice)->line == 12);
+    auto body = info.addresses_for_line("debug_info.cpp", 13);
+    REQUIRE_FALSE(body.empty());
+    for (auto address : body) REQUIRE(lines.line_entry_at_address(address)->line == 13);
+  }
+}
+
+TEST_CASE("Functions and lines are found in the units that hold them", "[dwarf]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/debug_info", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto twice = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  auto& info = proc->get_dwarf();
+  REQUIRE(info.compile_units().size() >= 2);
+  auto unit = info.compile_unit_containing_address(twice);
+  REQUIRE(unit != nullptr);
+  REQUIRE(std::filesystem::path(unit->name()).filename() == "debug_info.cpp");
+  REQUIRE_FALSE(unit->dies_parsed());
+  REQUIRE_FALSE(unit->lines_parsed());
+
+  auto function = info.function_containing_address(twice);
+  REQUIRE(function != nullptr);
+  REQUIRE(function->name == "twice");
+  REQUIRE(function->tag == DW_TAG_subprogram);
+  REQUIRE(unit->dies_parsed());
+  auto entry = info.line_entry_at_address(twice);
+  REQUIRE(entry);
+  REQUIRE(entry->address == twice);
+  REQUIRE(entry->file.filename() == "debug_info.cpp");
+  require_twice_lines(info, info, twice);
+  for (auto address : info.addresses_for_line("debug_info.cpp", 13)) {
+    REQUIRE(info.function_containing_address(address) == function);
+  }
+  // nothing was read from the other unit
+  for (auto& other : info.compile_units()) {
+    if (other.get() != unit) {
+      REQUIRE_FALSE(other->dies_parsed());
+      REQUIRE_FALSE(other->lines_parsed());
+    }
+  }
+
+  auto addresses = info.addresses_for_line("debug_info_shapes.cpp", 8);
+  REQUIRE_FALSE(addresses.empty());
+  auto area = info.function_containing_address(addresses.front());
+  REQUIRE(area != nullptr);
+  REQUIRE(area->name == "area");
+  REQUIRE(area->linkage_name == "_ZNK6shapes6square4areaEv");
+  REQUIRE(area->parent->tag == DW_TAG_compile_unit);
+  REQUIRE(info.line_entry_at_address(addresses.front())->line == 8);
+  REQUIRE(info.addresses_for_line("shapes.cpp", 8).empty());
+  REQUIRE(info.function_containing_address(virt_addr{ 0 }) == nullptr);
+  REQUIRE_FALSE(info.line_entry_at_address(virt_addr{ 0 }));
+}
+
+TEST_CASE("Units are indexed the same without .debug_aranges", "[dwarf]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/debug_info", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto twice = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  auto& elf = proc->get_elf();
+  dwarf indexed(elf);
+  dwarf scanned(elf, false);
+  scanned.parse_all();
+  for (auto& unit : scanned.compile_units()) {
+    REQUIRE(unit->dies_parsed());
+    REQUIRE(unit->lines_parsed());
+  }
+  REQUIRE(indexed.arena_bytes() < scanned.arena_bytes());
+
+  REQUIRE(scanned.compile_unit_containing_address(twice)->offset() ==
+          indexed.compile_unit_containing_address(twice)->offset());
+  for (auto& unit : scanned.compile_units()) {
+    for (auto& row : unit->lines().rows) {
+      if (row.end_sequence) continue;
+      auto address = virt_addr{ row.address + elf.load_bias() };
+      auto from_index = indexed.line_entry_at_address(address);
+      auto from_scan = scanned.line_entry_at_address(address);
+      REQUIRE(from_index);
+      REQUIRE(from_scan);
+      REQUIRE(from_index->line == from_scan->line);
+      REQUIRE(from_index->file == from_scan->file);
+      REQUIRE(indexed.function_containing_address(address)->name ==
+              scanned.function_containing_address(address)->name);
+    }
+  }
+}
+
+TEST_CASE("Symbol indexes are cached by build id and checked before use", "[symbol_index]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/debug_info", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto twice = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  auto cache = std::filesystem::temp_directory_path() / ("xdb-test-cache-" + std::to_string(getpid()));
+  std::filesystem::remove_all(cache);
+  auto& elf = proc->get_elf();
+  REQUIRE(elf.build_id().size() == 20);
+  auto& info = proc->get_dwarf();
+
+  auto check = [&](const symbol_index& index) {
+    REQUIRE(index.symbol_containing_address(twice) == elf.symbol_containing_address(twice));
+    REQUIRE(index.symbol_containing_address(virt_addr{ 0 }) == nullptr);
+    REQUIRE(index.symbol_by_name("main") == elf.symbol_by_name("main"));
+    REQUIRE(index.symbol_by_name("no_such_symbol") == nullptr);
+    auto entry = index.line_entry_at_address(twice);
+    REQUIRE(entry);
+    REQUIRE(entry->file == info.line_entry_at_address(twice)->file);
+    require_twice_lines(index, info, twice);
+    REQUIRE(index.addresses_for_line("debug_info.cpp", 13) == info.addresses_for_line("debug_info.cpp", 13));
+    REQUIRE(index.addresses_for_line("debug_info_shapes.cpp", 8) == info.addresses_for_line("debug_info_shapes.cpp", 8));
+  };
+
+  auto cold = symbol_index::load(elf, cache);
+  REQUIRE_FALSE(cold->from_cache());
+  REQUIRE(std::filesystem::exists(cold->cache_path()));
+  check(*cold);
+  auto warm = symbol_index::load(elf, cache);
+  REQUIRE(warm->from_cache());
+  check(*warm);
+  auto path = warm->cache_path();
+  auto size = warm->size();
+  warm.reset();
+
+  // a flipped byte, an old version and a short file are each rebuilt over
+  auto patch = [&](std::uint64_t offset, char byte) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offset);
+    file.put(byte);
+  };
+  patch(size - 20, 0x5a);
+  auto rebuilt = symbol_index::load(elf, cache);
+  REQUIRE_FALSE(rebuilt->from_cache());
+  check(*rebuilt);
+  REQUIRE(symbol_index::load(elf, cache)->from_cache());
+
+  patch(8, 0x7f);
+  REQUIRE_FALSE(symbol_index::load(elf, cache)->from_cache());
+  REQUIRE(symbol_index::load(elf, cache)->from_cache());
+
+  std::filesystem::resize_file(path, size / 2);
+  REQUIRE_FALSE(symbol_index::load(elf, cache)->from_cache());
+  REQUIRE(symbol_index::load(elf, cache)->from_cache());
+  std::filesystem::remove_all(cache);
+}
+
+TEST_CASE("The thread pool runs every task however they are spread", "[objects]") {
+  std::atomic<int> done = 0;
+  thread_pool pool(4);
+  REQUIRE(pool.size() == 4);
+  // one slow task holds its worker while the others take its deque's share
+  pool.submit([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ++done;
+  });
+  for (int i = 0; i < 999; ++i) pool.submit([&] { ++done; });
+  pool.wait_idle();
+  REQUIRE(done == 1000);
+}
+
+TEST_CASE("Mapped objects load in the background and are looked up by address", "[objects]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/debug_info", true, channel.get_write_fd());
+  channel.close_write();
+  proc->resume();
+  proc->wait_on_signal();
+  auto twice = virt_addr{ from_bytes<std::uint64_t>(channel.read().data()) };
+
+  object_map objects(proc->pid(), 4, std::nullopt);
+  REQUIRE(objects.n_workers() == 4);
+  REQUIRE(objects.objects().size() >= 3);
+  auto executable = objects.object_containing_address(twice);
+  REQUIRE(executable != nullptr);
+  REQUIRE(executable->path().filename() == "debug_info");
+  REQUIRE(objects.object_containing_address(virt_addr{ 0 }) == nullptr);
+
+  auto match = objects.symbol_containing_address(twice);
+  REQUIRE(match);
+  REQUIRE(match->object == executable);
+  REQUIRE(executable->get_elf().symbol_name(*match->symbol) == "_Z5twicei");
+  require_twice_lines(objects, proc->get_dwarf(), twice);
+
+  auto raise = objects.symbol_by_name("raise");
+  REQUIRE(raise);
+  REQUIRE(raise->object->path().filename().string().find("libc") == 0);
+  auto raise_address = virt_addr{ raise->symbol->st_value + raise->object->get_elf().load_bias() };
+  REQUIRE(objects.symbol_containing_address(raise_address)->object == raise->object);
+
+  objects.wait_all();
+  REQUIRE(objects.all_loaded());
+  auto n_objects = objects.objects().size();
+  objects.remove(raise->object->start());
+  REQUIRE(objects.objects().size() == n_objects - 1);
+  REQUIRE(objects.object_containing_address(raise_address) == nullptr);
+  REQUIRE_FALSE(objects.symbol_by_name("no_such_symbol"));
+}
+
+TEST_CASE("Objects follow dlopen and dlclose, and pending breakpoints resolve in them", "[objects]") {
+  auto proc = process::launch("targets/shared_objects");
+  // kept out of the user's own cache
+  auto cache = std::filesystem::temp_directory_path() / ("xdb-test-objects-cache-" + std::to_string(getpid()));
+  std::filesystem::remove_all(cache);
+  proc->set_symbol_cache_dir(cache);
+  auto& objects = proc->get_objects();
+  auto has_object = [&](std::string_view prefix) {
+    return std::any_of(objects.objects().begin(), objects.objects().end(),
+                       [&](auto& object) { return object->path().filename().string().rfind(prefix, 0) == 0; });
+  };
+  // stopped at the exec, before the dynamic linker has loaded anything
+  REQUIRE_FALSE(has_object("libc"));
+  REQUIRE_FALSE(has_object("libplugin"));
+
+  std::string resolved;
+  breakpoint_site::id_t resolved_id = 0;
+  proc->set_resolve_observer([&](const std::string& symbol, breakpoint_site& site) {
+    resolved = symbol;
+    resolved_id = site.id();
+  });
+  REQUIRE(proc->create_breakpoint_at_symbol("plugin_entry") == nullptr);
+  REQUIRE(proc->pending_breakpoints().size() == 1);
+
+  proc->resume();
+  auto reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::stopped);
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(resolved == "plugin_entry");
+  REQUIRE(proc->pending_breakpoints().empty());
+  REQUIRE(has_object("libc"));
+  auto match = objects.symbol_containing_address(proc->get_pc());
+  REQUIRE(match);
+  REQUIRE(match->object->path().filename() == "libplugin.so");
+  REQUIRE(match->object->get_elf().symbol_name(*match->symbol) == "plugin_entry");
+
+  // the raise after the dlclose; the site went with the plugin, and its
+  // symbol is pending again
+  auto first_id = resolved_id;
+  proc->resume();
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::stopped);
+  REQUIRE(reason.info == SIGTRAP);
+  REQUIRE_FALSE(has_object("libplugin"));
+  REQUIRE(has_object("libc"));
+  REQUIRE_FALSE(proc->breakpoint_sites().contains(first_id));
+  REQUIRE(proc->pending_breakpoints().size() == 1);
+  REQUIRE(proc->pending_breakpoints()[0].symbol == "plugin_entry");
+
+  // and resolves in the plugin loaded again
+  resolved.clear();
+  proc->resume();
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::stopped);
+  REQUIRE(reason.trap_reason == trap_type::software_break);
+  REQUIRE(resolved == "plugin_entry");
+  REQUIRE(resolved_id != first_id);
+  REQUIRE(proc->get_pc() == proc->breakpoint_sites().get_by_id(resolved_id).address());
+
+  proc->resume();
+  reason = proc->wait_on_signal();
+  REQUIRE(reason.reason == process_state::exited);
+  REQUIRE(reason.info == 42);
+
+  objects.wait_all();
+  REQUIRE_FALSE(std::filesystem::is_empty(cache));
+  std::filesystem::remove_all(cache);
+}
+
+TEST_CASE("Breakpoints on symbols are placed again after an exec", "[objects]") {
+  bool close_on_exec = false;
+  xdb::pipe channel(close_on_exec);
+  auto proc = process::launch("targets/forker", true, channel.get_write_fd());
+  channel.close_write();
+  proc->set_symbol_cache_dir(std::nullopt);
+  proc->resume();
+  proc->wait_on_signal();
+
+  // only the new image calls exit, from the libc it loads for itself
+  auto site = proc->create_breakpoint_at_symbol("exit");
+  REQUIRE(site != nullptr);
+  auto old_id = site->id();
+  std::optional<stop_reason> reason;
+  do {
+    proc->resume();
+    reason = proc->wait_on_signal(std::chrono::milliseconds(5000));
+    REQUIRE(reason.has_value());
+  } while (reason->reason == process_state::stopped && reason->info == SIGCHLD);
+  REQUIRE(reason->reason == process_state::stopped);
+  REQUIRE(reason->trap_reason == trap_type::software_break);
+  REQUIRE_FALSE(proc->breakpoint_sites().contains(old_id));
+  REQUIRE(proc->pending_breakpoints().empty());
+  auto match = proc->get_objects().symbol_containing_address(proc->get_pc());
+  REQUIRE(match);
+  REQUIRE(match->object->get_elf().symbol_name(*match->symbol) == "exit");
+
+  // the placed breakpoint can be dropped by its symbol too
+  auto new_id = proc->breakpoint_sites().get_by_address(proc->get_pc()).id();
+  proc->remove_breakpoint_at_symbol("exit");
+  REQUIRE_FALSE(proc->breakpoint_sites().contains(new_id));
+  REQUIRE_THROWS_AS(proc->remove_breakpoint_at_symbol("exit"), error);
+
+  proc->resume();
+  reason = proc->wait_on_signal(std::chrono::milliseconds(5000));
+  REQUIRE(reason.has_value());
+  REQUIRE(reason->reason == process_state::exited);
+  REQUIRE(reason->info == 0);
+}
@@ -1,25 +1,19 @@
+#include <libxdb/event_loop.hpp>
 #include <libxdb/pipe.hpp>
 #include <libxdb/process.hpp>
 #include <libxdb/parse.hpp>
+#include <libxdb/step_until.hpp>
+#include <libxdb/syscalls.hpp>
+#include <limits>
 #include <variant>
 #include <fmt/base.h>
 #include <readline.h>
 #include <signal.h>
+#include <unistd.h>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
 
 namespace {
-  std::unique_ptr<xdb::process> attach(int argc, char** argv) {
-    pid_t pid = 0;
-    if (argc == 3 && argv[1] == std::string_view("-p")) {
-      pid = std::stoi(argv[2]);
-      return xdb::process::attach(pid);
-    } else {
-      const char* prog_path = argv[1];
-      return xdb::process::launch(prog_path);
-    }
-  }
-
   std::vector<std::string> split(std::string_view str, char delimiter) {
     std::vector<std::string> out{};
     std::stringstream ss {std::string{str}};
@@ -32,6 +26,41 @@ namespace {
     return out;
   }
 
+  // a launched program's stdout goes to output, so the REPL can print it
+  // above the prompt
+  std::unique_ptr<xdb::process> attach(int argc, char** argv, xdb::pipe& output) {
+    pid_t pid = 0;
+    if (argc == 3 && argv[1] == std::string_view("-p")) {
+      pid = std::stoi(argv[2]);
+      return xdb::process::attach(pid);
+    } else {
+      // --trace-syscalls <name,...> --syscall-log <file> <program>
+      std::optional<xdb::syscall_trace> syscalls;
+      int arg = 1;
+      for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (!syscalls) syscalls.emplace();
+        if (argv[arg] == std::string_view("--trace-syscalls")) {
+          for (auto& name : split(argv[arg + 1], ',')) {
+            syscalls->syscalls.push_back(xdb::syscall_name_to_id(name));
+          }
+        } else if (argv[arg] == std::string_view("--syscall-log")) {
+          syscalls->log = argv[arg + 1];
+        } else {
+          xdb::error::send(std::string("Unknown option ") + argv[arg]);
+        }
+      }
+      if (arg != argc - 1) {
+        xdb::error::send("Expected one program to launch");
+      }
+      if (syscalls && syscalls->log.empty()) {
+        xdb::error::send("--trace-syscalls needs a --syscall-log");
+      }
+      auto proc = xdb::process::launch(argv[arg], true, output.get_write_fd(), syscalls);
+      output.close_write();
+      return proc;
+    }
+  }
+
   bool is_prefix(std::string_view str, std::string_view of) {
     if (str.size() > of.size()) return false;
     return std::equal(str.begin(), str.end(), of.begin());
@@ -48,24 +77,100 @@ namespace {
         break;
       case xdb::process_state::stopped:
         message = fmt::format("stopped with signal {} at {:#x}", sigabbrev_np(reason.info), process.get_pc().addr());
+        if (reason.trap_reason == xdb::trap_type::hardware_break) {
+          auto id = process.get_current_hardware_stoppoint();
+          if (id.index() == 0) {
+            message += fmt::format(" (hardware breakpoint {})", std::get<0>(id));
+          } else {
+            auto& point = process.watchpoints().get_by_id(std::get<1>(id));
+            message += fmt::format(" (watchpoint {}, old value {:#x}, new value {:#x})", point.id(),
+                                   point.previous_data(), point.data());
+          }
+        } else if (reason.trap_reason == xdb::trap_type::single_step) {
+          message += " (single step)";
+        }
         break;
       case xdb::process_state::running:
         break;
     }
+    if (process.threads().size() > 1 && reason.reason == xdb::process_state::stopped) {
+      message = fmt::format("thread {} {}", process.current_thread(), message);
+    }
     fmt::println("Process {} {}", process.pid(), message);
   }
 
   void print_help(const std::vector<std::string>& args) {
     if (args.size() == 1) {
       std::cerr << "Available commands:\n"
-                << "\tcontinue - Resume the process\n"
-                << "\tregister - Commands for operating on registers" << std::endl;
+                << "\tbreakpoint - Commands for operating on breakpoints\n"
+                << "\tcontinue - Resume the process (in non-stop mode, the current thread; -a for all)\n"
+                << "\tfinish   - Run until the current function returns\n"
+                << "\thandle   - Commands for choosing what signals do\n"
+                << "\tinterrupt - Stop every running thread\n"
+                << "\tmemory   - Commands for operating on memory\n"
+                << "\tnexti    - Step one instruction, running a call to its return\n"
+                << "\tnonstop <on|off> - Stop only the thread that hit an event\n"
+                << "\tregister - Commands for operating on registers\n"
+                << "\tstepi [count] - Single step count instructions, 1 by default\n"
+                << "\tstep-until - Step until the pc leaves a range, or a register or memory changes\n"
+                << "\tsymbol <name|address> - Look up a symbol by name, or the symbol, object and source line of an address\n"
+                << "\tthread   - Commands for operating on threads\n"
+                << "\ttracepoint - Commands for operating on tracepoints\n"
+                << "\tuntil <address> - Run until address, or until the current function returns\n"
+                << "\twatchpoint - Commands for operating on watchpoints" << std::endl;
     } else if (is_prefix(args[1], "register")) {
       std::cerr << "Available commands:\n"
                 << "\tread\n"
                 << "\tread <register>\n"
                 << "\tread all\n"
                 << "\twrite <register> <value>" << std::endl;
+    } else if (is_prefix(args[1], "breakpoint")) {
+      std::cerr << "Available commands:\n"
+                << "\tlist\n"
+                << "\tdelete <id|symbol>\n"
+                << "\tdisable <id>\n"
+                << "\tenable <id>\n"
+                << "\tset <address|symbol>\n"
+                << "\tset <address|symbol> -h\n"
+                << "\tcondition <id> <expression>\n"
+                << "\tcondition <id>\n"
+                << "\tignore <id> <count>" << std::endl;
+    } else if (is_prefix(args[1], "watchpoint")) {
+      std::cerr << "Available commands:\n"
+                << "\tlist\n"
+                << "\tdelete <id>\n"
+                << "\tdisable <id>\n"
+                << "\tenable <id>\n"
+                << "\tset <address> <write|rw|execute> <size>" << std::endl;
+    } else if (is_prefix(args[1], "tracepoint")) {
+      std::cerr << "Available commands:\n"
+                << "\tlist\n"
+                << "\tdelete <id>\n"
+                << "\tdisable <id>\n"
+                << "\tenable <id>\n"
+                << "\tdrain\n"
+                << "\tset <address> <field>...   (field: <register>, [<register>] or [<register>+<offset>])"
+                << std::endl;
+    } else if (is_prefix(args[1], "thread")) {
+      std::cerr << "Available commands:\n"
+                << "\tlist\n"
+                << "\tselect <tid>" << std::endl;
+    } else if (is_prefix(args[1], "handle")) {
+      std::cerr << "Available commands:\n"
+                << "\tlist\n"
+                << "\t<signal>\n"
+                << "\t<signal> <stop|print|pass|ignore>" << std::endl;
+    } else if (is_prefix(args[1], "step-until")) {
+      std::cerr << "Available commands:\n"
+                << "\toutside <low> <high>\n"
+                << "\tregister <register>\n"
+                << "\tmemory <address>\n"
+                << "\tmemory <address> <number of bytes>" << std::endl;
+    } else if (is_prefix(args[1], "memory")) {
+      std::cerr << "Available commands:\n"
+                << "\tread <address>\n"
+                << "\tread <address> <number of bytes>\n"
+                << "\twrite <address> <bytes>" << std::endl;
     } else {
       std::cerr << "No help available on that" << std::endl;
     }
@@ -161,20 +266,495 @@ namespace {
       }
     }
 
+    void handle_memory_read(xdb::process& process, const std::vector<std::string>& args) {
+      auto address = xdb::to_integer<std::uint64_t>(args[2]);
+      if (!address) xdb::error::send("Invalid address format");
+
+      std::size_t n_bytes = 32;
+      if (args.size() == 4) {
+        auto bytes_arg = xdb::to_integer<std::size_t>(args[3]);
+        if (!bytes_arg) xdb::error::send("Invalid number of bytes");
+        n_bytes = *bytes_arg;
+      }
+
+      auto data = process.read_memory_without_traps(xdb::virt_addr{ *address }, n_bytes);
+      for (std::size_t i = 0; i < data.size(); i += 16) {
+        auto start = data.begin() + i;
+        auto end = data.begin() + std::min(i + 16, data.size());
+        fmt::print("{:#016x}: {:02x}\n", *address + i, fmt::join(start, end, " "));
+      }
+    }
+
+    void handle_memory_write(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() != 4) {
+        print_help({ "help", "memory" });
+        return;
+      }
+      auto address = xdb::to_integer<std::uint64_t>(args[2]);
+      if (!address) xdb::error::send("Invalid address format");
+
+      auto data = xdb::to_bytes(args[3]);
+      if (!data) xdb::error::send("Invalid data format");
+      process.write_memory(xdb::virt_addr{ *address }, *data);
+    }
+
+    void handle_memory_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 3) {
+        print_help({ "help", "memory" });
+        return;
+      }
+      try {
+        if (is_prefix(args[1], "read")) {
+          handle_memory_read(process, args);
+        } else if (is_prefix(args[1], "write")) {
+          handle_memory_write(process, args);
+        } else {
+          print_help({ "help", "memory" });
+        }
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    void handle_breakpoint_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 2) {
+        print_help({ "help", "breakpoint" });
+        return;
+      }
+      auto command = args[1];
+      if (is_prefix(command, "list")) {
+        std::size_t n_user_sites = 0;
+        process.breakpoint_sites().for_each([&](auto& site) { n_user_sites += !site.is_internal(); });
+        if (n_user_sites == 0 && process.pending_breakpoints().empty()) {
+          fmt::print("No breakpoints set\n");
+          return;
+        }
+        fmt::print("Current breakpoints:\n");
+        process.breakpoint_sites().for_each([](auto& site) {
+          if (site.is_internal()) return;
+          fmt::print("{}: address = {:#x}, {}{}, hits = {}", site.id(), site.address().addr(),
+                     site.is_enabled() ? "enabled" : "disabled", site.is_hardware() ? ", hardware" : "",
+                     site.hit_count());
+          if (site.ignore_count() > 0) fmt::print(", ignore next {}", site.ignore_count());
+          if (site.condition()) fmt::print(", if {}", site.condition()->text());
+          fmt::print("\n");
+        });
+        for (auto& pending : process.pending_breakpoints()) {
+          fmt::print("pending: {}{}\n", pending.symbol, pending.hardware ? ", hardware" : "");
+        }
+        return;
+      }
+      if (args.size() < 3) {
+        print_help({ "help", "breakpoint" });
+        return;
+      }
+      try {
+        if (is_prefix(command, "set")) {
+          bool hardware = args.size() == 4 && args[3] == "-h";
+          if (args.size() == 4 && !hardware) xdb::error::send("Invalid breakpoint command argument");
+          // anything that isn't an address is a symbol
+          if (auto address = xdb::to_integer<std::uint64_t>(args[2])) {
+            process.create_breakpoint_site(xdb::virt_addr{ *address }, hardware).enable();
+          } else if (auto site = process.create_breakpoint_at_symbol(args[2], hardware)) {
+            fmt::println("Breakpoint {} at {:#x}", site->id(), site->address().addr());
+          } else {
+            fmt::println("Breakpoint on {} pending until a library that defines it is loaded", args[2]);
+          }
+          return;
+        }
+        if (is_prefix(command, "delete") && !xdb::to_integer<xdb::breakpoint_site::id_t>(args[2])) {
+          process.remove_breakpoint_at_symbol(args[2]);
+          return;
+        }
+        auto id = xdb::to_integer<xdb::breakpoint_site::id_t>(args[2]);
+        if (!id) xdb::error::send("Command expects breakpoint id");
+        if (is_prefix(command, "condition")) {
+          // the expression is everything after the id, spaces included
+          std::optional<xdb::stop_condition> condition;
+          if (args.size() > 3) {
+            std::string text;
+            for (auto it = args.begin() + 3; it != args.end(); ++it) {
+              if (!text.empty()) text += ' ';
+              text += *it;
+            }
+            condition = xdb::stop_condition::compile(text);
+          }
+          process.breakpoint_sites().get_by_id(*id).set_condition(std::move(condition));
+        } else if (is_prefix(command, "ignore")) {
+          auto count = args.size() == 4 ? xdb::to_integer<std::uint64_t>(args[3]) : std::nullopt;
+          if (!count) xdb::error::send("Command expects an ignore count");
+          process.breakpoint_sites().get_by_id(*id).set_ignore_count(*count);
+        } else if (is_prefix(command, "enable")) {
+          process.breakpoint_sites().get_by_id(*id).enable();
+        } else if (is_prefix(command, "disable")) {
+          process.breakpoint_sites().get_by_id(*id).disable();
+        } else if (is_prefix(command, "delete")) {
+          process.remove_breakpoint_site(*id);
+        } else {
+          print_help({ "help", "breakpoint" });
+        }
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    void handle_watchpoint_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 2) {
+        print_help({ "help", "watchpoint" });
+        return;
+      }
+      auto command = args[1];
+      if (is_prefix(command, "list")) {
+        auto mode_name = [](xdb::stoppoint_mode mode) {
+          switch (mode) {
+            case xdb::stoppoint_mode::execute: return "execute";
+            case xdb::stoppoint_mode::write: return "write";
+            case xdb::stoppoint_mode::read_write: return "read_write";
+          }
+          return "";
+        };
+        if (process.watchpoints().empty()) {
+          fmt::print("No watchpoints set\n");
+          return;
+        }
+        fmt::print("Current watchpoints:\n");
+        process.watchpoints().for_each([&](auto& point) {
+          fmt::print("{}: address = {:#x}, mode = {}, size = {}, {}\n", point.id(), point.address().addr(),
+                     mode_name(point.mode()), point.size(), point.is_enabled() ? "enabled" : "disabled");
+        });
+        return;
+      }
+      if (args.size() < 3) {
+        print_help({ "help", "watchpoint" });
+        return;
+      }
+      try {
+        if (is_prefix(command, "set")) {
+          if (args.size() != 5) {
+            print_help({ "help", "watchpoint" });
+            return;
+          }
+          auto address = xdb::to_integer<std::uint64_t>(args[2]);
+          auto size = xdb::to_integer<std::size_t>(args[4]);
+          if (!address || !size) xdb::error::send("Invalid watchpoint address or size");
+          xdb::stoppoint_mode mode;
+          if (args[3] == "write") mode = xdb::stoppoint_mode::write;
+          else if (args[3] == "rw") mode = xdb::stoppoint_mode::read_write;
+          else if (args[3] == "execute") mode = xdb::stoppoint_mode::execute;
+          else xdb::error::send("Invalid watchpoint mode");
+          process.create_watchpoint(xdb::virt_addr{ *address }, mode, *size).enable();
+          return;
+        }
+        auto id = xdb::to_integer<xdb::watchpoint::id_t>(args[2]);
+        if (!id) xdb::error::send("Command expects watchpoint id");
+        if (is_prefix(command, "enable")) {
+          process.watchpoints().get_by_id(*id).enable();
+        } else if (is_prefix(command, "disable")) {
+          process.watchpoints().get_by_id(*id).disable();
+        } else if (is_prefix(command, "delete")) {
+          process.watchpoints().remove_by_id(*id);
+        } else {
+          print_help({ "help", "watchpoint" });
+        }
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    std::string field_name(const xdb::trace_field& field) {
+      std::string name(xdb::register_info_by_id(field.reg).name);
+      if (!field.deref) return name;
+      if (*field.deref == 0) return "[" + name + "]";
+      return fmt::format("[{}{:+}]", name, *field.deref);
+    }
+
+    xdb::trace_field parse_trace_field(std::string_view text) {
+      if (text.size() < 2 || text.front() != '[' || text.back() != ']') {
+        return { xdb::register_info_by_name(text).id, std::nullopt };
+      }
+      text = text.substr(1, text.size() - 2);
+      auto sign = text.find_first_of("+-");
+      if (sign == std::string_view::npos) {
+        return { xdb::register_info_by_name(text).id, 0 };
+      }
+      auto offset = xdb::to_integer<std::int32_t>(text.substr(sign + 1));
+      if (!offset) xdb::error::send("Invalid tracepoint field offset");
+      return { xdb::register_info_by_name(text.substr(0, sign)).id, text[sign] == '-' ? -*offset : *offset };
+    }
+
+    void handle_tracepoint_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 2) {
+        print_help({ "help", "tracepoint" });
+        return;
+      }
+      auto command = args[1];
+      try {
+        if (is_prefix(command, "list")) {
+          if (process.tracepoints().empty()) {
+            fmt::print("No tracepoints set\n");
+            return;
+          }
+          fmt::print("Current tracepoints:\n");
+          process.tracepoints().for_each([](auto& point) {
+            std::vector<std::string> fields;
+            for (auto& field : point.fields()) fields.push_back(field_name(field));
+            fmt::print("{}: address = {:#x}, {}, fields = {}\n", point.id(), point.address().addr(),
+                       point.is_enabled() ? "enabled" : "disabled", fmt::join(fields, " "));
+          });
+          return;
+        }
+        if (is_prefix(command, "drain")) {
+          auto& buffer = process.get_trace_buffer();
+          buffer.drain([&](auto& record) {
+            auto id = static_cast<xdb::tracepoint::id_t>(record.tracepoint_id);
+            if (!process.tracepoints().contains(id)) return;
+            auto& point = process.tracepoints().get_by_id(id);
+            fmt::print("{}:", id);
+            for (std::size_t i = 0; i < point.fields().size(); ++i) {
+              fmt::print(" {}={:#x}", field_name(point.fields()[i]), record.values[i]);
+            }
+            fmt::print("\n");
+          });
+          if (buffer.dropped() > 0) fmt::print("{} records dropped\n", buffer.dropped());
+          return;
+        }
+        if (args.size() < 3) {
+          print_help({ "help", "tracepoint" });
+          return;
+        }
+        if (is_prefix(command, "set")) {
+          auto address = xdb::to_integer<std::uint64_t>(args[2]);
+          if (!address) xdb::error::send("Tracepoint command expects address in hexadecimal, prefixed with '0x'");
+          std::vector<xdb::trace_field> fields;
+          for (auto it = args.begin() + 3; it != args.end(); ++it) fields.push_back(parse_trace_field(*it));
+          process.create_tracepoint(xdb::virt_addr{ *address }, std::move(fields)).enable();
+          return;
+        }
+        auto id = xdb::to_integer<xdb::tracepoint::id_t>(args[2]);
+        if (!id) xdb::error::send("Command expects tracepoint id");
+        if (is_prefix(command, "enable")) {
+          process.tracepoints().get_by_id(*id).enable();
+        } else if (is_prefix(command, "disable")) {
+          process.tracepoints().get_by_id(*id).disable();
+        } else if (is_prefix(command, "delete")) {
+          process.tracepoints().remove_by_id(*id);
+        } else {
+          print_help({ "help", "tracepoint" });
+        }
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    void handle_thread_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 2) {
+        print_help({ "help", "thread" });
+        return;
+      }
+      auto command = args[1];
+      try {
+        if (is_prefix(command, "list")) {
+          for (auto& [tid, thread] : process.threads()) {
+            auto marker = tid == process.current_thread() ? "*" : " ";
+            if (thread.state != xdb::process_state::stopped) {
+              fmt::print("{} {}: {}\n", marker, tid,
+                         thread.state == xdb::process_state::running ? "running" : "gone");
+            } else {
+              fmt::print("{} {}: pc = {:#x}\n", marker, tid, thread.regs->read<xdb::register_id::rip>());
+            }
+          }
+        } else if (is_prefix(command, "select") && args.size() == 3) {
+          auto tid = xdb::to_integer<pid_t>(args[2]);
+          if (!tid) xdb::error::send("Command expects a thread id");
+          process.set_current_thread(*tid);
+        } else {
+          print_help({ "help", "thread" });
+        }
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    // a number, or a name with or without its SIG prefix
+    int parse_signal(std::string_view text) {
+      if (auto signo = xdb::to_integer<int>(text)) return *signo;
+      if (text.substr(0, 3) == "SIG") text.remove_prefix(3);
+      for (int signo = 1; signo < NSIG; ++signo) {
+        if (auto name = sigabbrev_np(signo); name && text == name) return signo;
+      }
+      xdb::error::send("Unknown signal " + std::string(text));
+    }
+
+    const char* signal_policy_name(xdb::signal_policy policy) {
+      switch (policy) {
+        case xdb::signal_policy::stop: return "stop";
+        case xdb::signal_policy::print: return "print";
+        case xdb::signal_policy::pass: return "pass";
+        case xdb::signal_policy::ignore: return "ignore";
+      }
+      return "";
+    }
+
+    void handle_handle_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 2) {
+        print_help({ "help", "handle" });
+        return;
+      }
+      try {
+        if (args.size() == 2 && is_prefix(args[1], "list")) {
+          for (int signo = 1; signo < NSIG; ++signo) {
+            auto name = sigabbrev_np(signo);
+            if (!name) continue;
+            fmt::print("SIG{:<8} {}\n", name, signal_policy_name(process.get_signal_policy(signo)));
+          }
+          return;
+        }
+        auto signo = parse_signal(args[1]);
+        if (args.size() == 3) {
+          std::optional<xdb::signal_policy> policy;
+          for (auto candidate : { xdb::signal_policy::stop, xdb::signal_policy::print, xdb::signal_policy::pass,
+                                  xdb::signal_policy::ignore }) {
+            if (args[2] == signal_policy_name(candidate)) policy = candidate;
+          }
+          if (!policy) {
+            print_help({ "help", "handle" });
+            return;
+          }
+          process.set_signal_policy(signo, *policy);
+        } else if (args.size() != 2) {
+          print_help({ "help", "handle" });
+          return;
+        }
+        fmt::print("{}: {}\n", args[1], signal_policy_name(process.get_signal_policy(signo)));
+      } catch (xdb::error& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+
+    void handle_symbol_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() != 2) {
+        print_help({ "help" });
+        return;
+      }
+      // only the object asked about is waited for, if it is still loading
+      auto& objects = process.get_objects();
+      if (auto address = xdb::to_integer<std::uint64_t>(args[1])) {
+        auto match = objects.symbol_containing_address(xdb::virt_addr{ *address });
+        if (!match) xdb::error::send("No symbol contains that address");
+        auto& elf = match->object->get_elf();
+        auto name = fmt::format("{}+{:#x} in {}", elf.symbol_name(*match->symbol),
+                                *address - (match->symbol->st_value + elf.load_bias()),
+                                match->object->path().filename().string());
+        if (auto line = objects.line_entry_at_address(xdb::virt_addr{ *address })) {
+          fmt::println("{} at {}:{}", name, line->file.string(), line->line);
+        } else {
+          fmt::println("{}", name);
+        }
+      } else {
+        auto match = objects.symbol_by_name(args[1]);
+        if (!match) xdb::error::send("No symbol named " + args[1]);
+        fmt::println("{:#x}", match->symbol->st_value + match->object->get_elf().load_bias());
+      }
+    }
+
+    void print_step_result(const xdb::process& process, const xdb::step_result& result) {
+      print_stop_reason(process, result.reason);
+      fmt::println("{} instruction{} stepped", result.steps, result.steps == 1 ? "" : "s");
+    }
+
+    void handle_stepi_command(xdb::process& process, const std::vector<std::string>& args) {
+      std::uint64_t count = 1;
+      if (args.size() == 2) {
+        auto count_arg = xdb::to_integer<std::uint64_t>(args[1]);
+        if (!count_arg) xdb::error::send("Invalid step count");
+        count = *count_arg;
+      }
+      print_step_result(process, process.step_instructions(count));
+    }
+
+    void handle_step_until_command(xdb::process& process, const std::vector<std::string>& args) {
+      if (args.size() < 3) {
+        print_help({ "help", "step-until" });
+        return;
+      }
+      auto address_arg = [&](std::size_t i) {
+        auto address = xdb::to_integer<std::uint64_t>(args[i]);
+        if (!address) xdb::error::send("Invalid address format");
+        return xdb::virt_addr{ *address };
+      };
+
+      xdb::step_predicate until;
+      if (is_prefix(args[1], "outside") && args.size() == 4) {
+        until = xdb::pc_outside(process, address_arg(2), address_arg(3));
+      } else if (is_prefix(args[1], "register") && args.size() == 3) {
+        until = xdb::register_changes(process, xdb::register_info_by_name(args[2]));
+      } else if (is_prefix(args[1], "memory") && args.size() <= 4) {
+        std::size_t n_bytes = 8;
+        if (args.size() == 4) {
+          auto bytes_arg = xdb::to_integer<std::size_t>(args[3]);
+          if (!bytes_arg) xdb::error::send("Invalid number of bytes");
+          n_bytes = *bytes_arg;
+        }
+        until = xdb::memory_changes(process, address_arg(2), n_bytes);
+      } else {
+        print_help({ "help", "step-until" });
+        return;
+      }
+      print_step_result(process, process.step_instructions(std::numeric_limits<std::uint64_t>::max(), until));
+    }
+
     void handle_command(std::unique_ptr<xdb::process> & process, std::string_view line) {
       auto args = split(line, ' ');
       assert(args.size() > 0);
       auto command = args[0];
 
       if (is_prefix(command, "continue")) {
-        process->resume();
-        auto reason = process->wait_on_signal();
-        print_stop_reason(*process, reason);
+        // stops are printed by the main loop as they come in
+        if (process->non_stop() && !(args.size() > 1 && args[1] == "-a")) {
+          process->resume(process->current_thread());
+        } else {
+          process->resume();
+        }
+      } else if (is_prefix(command, "interrupt")) {
+        process->interrupt();
+      } else if (is_prefix(command, "nonstop")) {
+        if (args.size() != 2 || (args[1] != "on" && args[1] != "off")) {
+          print_help({ "help" });
+          return;
+        }
+        process->set_non_stop(args[1] == "on");
       } else if (is_prefix(command, "register")) {
         handle_register_command(*process, args);
+      } else if (is_prefix(command, "breakpoint")) {
+        handle_breakpoint_command(*process, args);
+      } else if (is_prefix(command, "memory")) {
+        handle_memory_command(*process, args);
+      } else if (is_prefix(command, "tracepoint")) {
+        handle_tracepoint_command(*process, args);
+      } else if (is_prefix(command, "watchpoint")) {
+        handle_watchpoint_command(*process, args);
+      } else if (is_prefix(command, "thread")) {
+        handle_thread_command(*process, args);
+      } else if (is_prefix(command, "nexti")) {
+        print_stop_reason(*process, process->step_over_instruction());
+      } else if (is_prefix(command, "finish")) {
+        print_stop_reason(*process, process->step_out());
+      } else if (is_prefix(command, "until") && args.size() == 2) {
+        auto address = xdb::to_integer<std::uint64_t>(args[1]);
+        if (!address) xdb::error::send("Invalid address format");
+        print_stop_reason(*process, process->run_until(xdb::virt_addr{ *address }));
+      } else if (is_prefix(command, "stepi")) {
+        handle_stepi_command(*process, args);
+      } else if (is_prefix(command, "step-until")) {
+        handle_step_until_command(*process, args);
+      } else if (is_prefix(command, "symbol")) {
+        handle_symbol_command(*process, args);
       } else if (is_prefix(command, "help")) {
         print_help(args);
+      } else if (is_prefix(command, "handle")) {
+        handle_handle_command(*process, args);
       } else if (is_prefix(command, "quit")) {
+        rl_callback_handler_remove();
         assert(kill(process->pid(), SIGTERM) == 0);
         process->wait_on_signal();
         std::cerr << static_cast<int>(process->state()) << std::endl;
@@ -184,39 +764,102 @@ namespace {
       }
     }
 
-    void main_loop(std::unique_ptr<xdb::process> & process) {
-      char* line = nullptr;
-      while ((line = readline("xdb> ")) != nullptr) {
-        std::string line_str;
+    std::unique_ptr<xdb::process>* repl_process = nullptr;
+    bool input_closed = false;
 
-        // if the input is empty, use the last command
-        if (line == std::string_view("")) {
-          free(line);
-          if (history_length > 0) {
-            line_str = history_list()[history_length - 1]->line;
-          }
-        } else {
-          line_str = line;
-          add_history(line);
-          free(line);
+    void handle_line(char* line) {
+      if (!line) {
+        input_closed = true;
+        return;
+      }
+      std::string line_str;
+
+      // if the input is empty, use the last command
+      if (line == std::string_view("")) {
+        free(line);
+        if (history_length > 0) {
+          line_str = history_list()[history_length - 1]->line;
         }
+      } else {
+        line_str = line;
+        add_history(line);
+        free(line);
+      }
 
-        if (!line_str.empty()) {
-          handle_command(process, line_str);
+      if (!line_str.empty()) {
+        try {
+          handle_command(*repl_process, line_str);
+        } catch (const xdb::error& e) {
+          std::cerr << e.what() << std::endl;
         }
       }
     }
+
+    // prints above the prompt, leaving whatever has been typed in place
+    template <class F>
+    void print_above_prompt(F print) {
+      rl_clear_visible_line();
+      print();
+      rl_forced_update_display();
+    }
+
+    void print_inferior_output(xdb::event_loop& loop, int fd) {
+      char buf[4096];
+      auto n = read(fd, buf, sizeof(buf));
+      if (n <= 0) {
+        loop.remove_fd(fd);
+        return;
+      }
+      print_above_prompt([&] {
+        std::fwrite(buf, 1, n, stdout);
+        if (buf[n - 1] != '\n') std::fputc('\n', stdout);
+        std::fflush(stdout);
+      });
+    }
+
+    // Input, the inferior's output and its stops all come through one event
+    // loop; readline's callback interface takes input a character at a time,
+    // so the prompt stays live while the inferior runs
+    void main_loop(std::unique_ptr<xdb::process> & process, int inferior_output) {
+      repl_process = &process;
+      xdb::event_loop loop;
+      loop.add_fd(STDIN_FILENO, [&](int) {
+        rl_callback_read_char();
+        if (input_closed) loop.stop();
+      });
+      if (inferior_output != -1) {
+        loop.add_fd(inferior_output, [&](int fd) { print_inferior_output(loop, fd); });
+      }
+      loop.add_process(*process, [](auto& proc, auto& reason) {
+        print_above_prompt([&] { print_stop_reason(proc, reason); });
+      });
+      // signals set to print go by without a stop
+      process->set_signal_observer([pid = process->pid()](pid_t tid, int signo) {
+        print_above_prompt([&] { fmt::println("Process {} thread {} received signal {}", pid, tid, sigabbrev_np(signo)); });
+      });
+
+      process->set_resolve_observer([](const std::string& symbol, xdb::breakpoint_site& site) {
+        print_above_prompt([&] { fmt::println("Breakpoint {} on {} resolved at {:#x}", site.id(), symbol, site.address().addr()); });
+      });
+
+      // symbols load in the background; the prompt doesn't wait for them
+      process->get_objects();
+      rl_callback_handler_install("xdb> ", handle_line);
+      loop.run();
+      rl_callback_handler_remove();
+    }
   }
 
 int main(int argc, char** argv) {
   if (argc == 1) {
-    std::cerr << "Usage: xdb <program> | xdb -p <pid>\n";
+    std::cerr << "Usage: xdb [--trace-syscalls <name,...> --syscall-log <file>] <program> | xdb -p <pid>\n";
     return -1;
   }
 
   try {
-    auto process = attach(argc, argv);
-    main_loop(process);
+    xdb::pipe output(true);
+    auto process = attach(argc, argv, output);
+    main_loop(process, output.get_read_fd());
   } catch(const xdb::error& e) {
     std::cerr << e.what() << std::endl;
     return -1;